@@ -29,6 +29,7 @@
 
 #include "SDL_main.h"
 #include "SDL_stdinc.h"
+#include "SDL_archive.h"
 #include "SDL_audio.h"
 #include "SDL_cdrom.h"
 #include "SDL_cpuinfo.h"
@@ -39,6 +40,7 @@
 #include "SDL_mutex.h"
 #include "SDL_rwops.h"
 #include "SDL_thread.h"
+#include "SDL_threadpool.h"
 #include "SDL_timer.h"
 #include "SDL_video.h"
 #include "SDL_version.h"
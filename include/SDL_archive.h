@@ -0,0 +1,94 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifndef _SDL_archive_h
+#define _SDL_archive_h
+
+/** @file SDL_archive.h
+ *  Pack files holding many small files, read through SDL_RWops
+ *
+ *  A pack file is opened once, and its directory is kept in a hash table,
+ *  so finding a member doesn't touch the file system.  Each member stream
+ *  reads its own part of the pack, and streams can be used from different
+ *  threads at the same time.
+ *
+ *  The format, all little endian:
+ *  - "SDLP", then Uint32 version (1), member count and name table size
+ *  - for each member, Uint32 name offset, name length, data offset, data
+ *    size, and the FNV-1a hash of the name
+ *  - the name table, each name followed by a 0 byte
+ *  - the member data
+ */
+
+#include "SDL_stdinc.h"
+#include "SDL_error.h"
+#include "SDL_rwops.h"
+
+#include "begin_code.h"
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** The archive structure, defined in SDL_archive.c */
+struct SDL_Archive;
+typedef struct SDL_Archive SDL_Archive;
+
+/**
+ * Open a pack file and read its directory.
+ * Returns NULL if the file can't be read or isn't a pack file.
+ */
+extern DECLSPEC SDL_Archive * SDLCALL SDL_OpenArchive(const char *file);
+
+/** Return the number of members in an archive */
+extern DECLSPEC int SDLCALL SDL_GetArchiveMembers(SDL_Archive *archive);
+
+/** Return the name of member 'index', or NULL if there's no such member */
+extern DECLSPEC const char * SDLCALL SDL_GetArchiveMemberName(SDL_Archive *archive, int index);
+
+/**
+ * Open a read-only stream on the member called 'name'.
+ * Returns NULL if the archive has no such member.
+ */
+extern DECLSPEC SDL_RWops * SDLCALL SDL_RWFromArchive(SDL_Archive *archive, const char *name);
+
+/**
+ * Close an archive.  All the streams opened on its members must have been
+ * closed first.
+ */
+extern DECLSPEC void SDLCALL SDL_CloseArchive(SDL_Archive *archive);
+
+/**
+ * Write a pack file holding 'count' files.  The member called names[i]
+ * is read from the file paths[i], or from names[i] if 'paths' is NULL.
+ * If two members have the same name, only the first can be opened.
+ * Returns 0, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_SaveArchive(const char *file, int count, const char **names, const char **paths);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+#include "close_code.h"
+
+#endif /* _SDL_archive_h */
@@ -65,6 +65,7 @@ extern "C" {
  *     This function usually runs in a separate thread, and so you should
  *     protect data structures that it accesses by calling SDL_LockAudio()
  *     and SDL_UnlockAudio() in your code.
+ *     If the callback is NULL, audio is pushed with SDL_QueueAudio() instead.
  * - 'desired->userdata' is passed as the first parameter to your callback
  *     function.
  *
@@ -223,6 +224,59 @@ extern DECLSPEC SDL_AudioSpec * SDLCALL SDL_LoadWAV_RW(SDL_RWops *src, int frees
  */
 extern DECLSPEC void SDLCALL SDL_FreeWAV(Uint8 *audio_buf);
 
+/**
+ * @name WAVE Streams
+ * Read a WAVE file a piece at a time instead of loading it all at once.
+ * The same formats as SDL_LoadWAV_RW() are supported, and ADPCM data is
+ * decoded one block at a time, so long music tracks take little memory.
+ * If the source is a memory stream, its data is used in place.
+ */
+/*@{*/
+typedef struct SDL_WAVStream SDL_WAVStream;
+
+/**
+ * Parse the headers of a WAVE file and fill 'spec' with the format the
+ * stream decodes to, as SDL_LoadWAV_RW() does.  The source is closed with
+ * the stream if 'freesrc' is non-zero, and must not be used by anything
+ * else in the meantime.  Returns NULL on error.
+ */
+extern DECLSPEC SDL_WAVStream * SDLCALL SDL_OpenWAVStream_RW(SDL_RWops *src, int freesrc, SDL_AudioSpec *spec);
+
+/** Open a WAVE stream from a file */
+#define SDL_OpenWAVStream(file, spec) \
+	SDL_OpenWAVStream_RW(SDL_RWFromFile(file, "rb"), 1, spec)
+
+/**
+ * Decode up to 'frames' sample frames into 'buf'.  Returns the number of
+ * frames read, which is 0 at the end of the stream, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_ReadWAVStream(SDL_WAVStream *stream, Uint8 *buf, Uint32 frames);
+
+/**
+ * Return a pointer straight to the next sample frames of an uncompressed
+ * stream whose source is in memory, without copying them.  On input
+ * '*frames' is the most frames wanted, and on output how many there are.
+ * Returns NULL if the stream is compressed or not in memory, in which
+ * case use SDL_ReadWAVStream() instead.
+ */
+extern DECLSPEC const Uint8 * SDLCALL SDL_MapWAVStream(SDL_WAVStream *stream, Uint32 *frames);
+
+/**
+ * Move to the given sample frame.  ADPCM streams decode the block that
+ * holds it on the next read.  Returns 0, or -1 if past the end.
+ */
+extern DECLSPEC int SDLCALL SDL_SeekWAVStream(SDL_WAVStream *stream, Uint32 frame);
+
+/** Return the next sample frame to be read */
+extern DECLSPEC Uint32 SDLCALL SDL_TellWAVStream(SDL_WAVStream *stream);
+
+/** Return the total number of sample frames in the stream */
+extern DECLSPEC Uint32 SDLCALL SDL_GetWAVStreamLength(SDL_WAVStream *stream);
+
+/** Close a WAVE stream, and its source if it was opened with 'freesrc' */
+extern DECLSPEC void SDLCALL SDL_CloseWAVStream(SDL_WAVStream *stream);
+/*@}*/
+
 /**
  * This function takes a source format and rate and a destination format
  * and rate, and initializes the 'cvt' structure with information needed
@@ -243,6 +297,9 @@ extern DECLSPEC int SDLCALL SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
  * The data conversion may expand the size of the audio data, so the buffer
  * cvt->buf should be allocated after the cvt structure is initialized by
  * SDL_BuildAudioCVT(), and should be cvt->len*cvt->len_mult bytes long.
+ *
+ * @return 0 on success, or -1 if the conversion failed, leaving
+ *         cvt->len_cvt at 0.
  */
 extern DECLSPEC int SDLCALL SDL_ConvertAudio(SDL_AudioCVT *cvt);
 
@@ -257,6 +314,111 @@ extern DECLSPEC int SDLCALL SDL_ConvertAudio(SDL_AudioCVT *cvt);
  */
 extern DECLSPEC void SDLCALL SDL_MixAudio(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
 
+/**
+ * @name Voices
+ * A simple mixer for playing several sounds at once.  Voices are created
+ * after SDL_OpenAudio(), in any format, and are converted to the format
+ * the audio callback uses.  Calling SDL_MixVoices() from the callback adds
+ * up every playing voice with extra headroom and clips the sum only once,
+ * which is both faster and cleaner than calling SDL_MixAudio() for each.
+ * Free all voices before closing the audio device.
+ */
+/*@{*/
+typedef struct SDL_Voice SDL_Voice;
+
+/**
+ * Create a voice playing len bytes of audio in the format described by
+ * spec.  The data is converted and copied, so buf may be freed afterwards.
+ * Returns NULL on error.
+ */
+extern DECLSPEC SDL_Voice * SDLCALL SDL_CreateVoice(const SDL_AudioSpec *spec, const Uint8 *buf, Uint32 len);
+
+/**
+ * Create a voice streaming raw audio in the format described by spec from
+ * the current position of src.  The data is read and converted a piece at
+ * a time by a feeder thread, a few callback buffers ahead of the audio
+ * callback, and SDL_PlayVoice() reads the first pieces before returning.
+ * If freesrc is non-zero, the stream is closed when the voice is freed.
+ * Returns NULL on error.
+ */
+extern DECLSPEC SDL_Voice * SDLCALL SDL_CreateVoiceRW(SDL_RWops *src, int freesrc, const SDL_AudioSpec *spec);
+
+/**
+ * Set the volume of a voice, from 0 to SDL_MIX_MAXVOLUME, and its pan from
+ * -128 (left only) to 128 (right only).  New voices play at full volume,
+ * centered.
+ */
+extern DECLSPEC void SDLCALL SDL_SetVoiceVolume(SDL_Voice *voice, int volume, int pan);
+
+/**
+ * Set the loop points of a voice, in sample frames of the original data.
+ * The voice plays from the start of the data to 'end', then goes back to
+ * 'start' and repeats 'loops' more times, or forever if 'loops' is -1.
+ * An end of 0 means the end of the data, which is also the default.
+ */
+extern DECLSPEC void SDLCALL SDL_SetVoiceLoop(SDL_Voice *voice, Uint32 start, Uint32 end, int loops);
+
+/**
+ * Start a voice playing from the beginning, or stop it.
+ */
+/*@{*/
+extern DECLSPEC void SDLCALL SDL_PlayVoice(SDL_Voice *voice);
+extern DECLSPEC void SDLCALL SDL_StopVoice(SDL_Voice *voice);
+/*@}*/
+
+/**
+ * Returns 1 if a voice is playing, or 0 if it was stopped or has finished.
+ */
+extern DECLSPEC int SDLCALL SDL_VoicePlaying(SDL_Voice *voice);
+
+/**
+ * Stop and free a voice.
+ */
+extern DECLSPEC void SDLCALL SDL_FreeVoice(SDL_Voice *voice);
+
+/**
+ * Mix every playing voice into 'stream', which holds 'len' bytes of audio
+ * in the format the audio callback uses.  Call this from the callback.
+ */
+extern DECLSPEC void SDLCALL SDL_MixVoices(Uint8 *stream, int len);
+/*@}*/
+
+/**
+ * @name Audio Queue
+ * If SDL_OpenAudio() is given a NULL callback, the audio thread plays
+ * whatever the application pushes with SDL_QueueAudio(), in the format of
+ * the obtained spec, or the desired spec when SDL converts the audio.
+ * The queue is lock-free, so a single thread may push audio without ever
+ * waiting on SDL_LockAudio().  When the queue runs dry, silence is played.
+ * The queue holds about 8 audio buffers, or SDL_AUDIO_QUEUE_SIZE bytes.
+ */
+/*@{*/
+
+/**
+ * Add up to len bytes of audio to the queue, without blocking.  Only whole
+ * sample frames are taken.  Returns the number of bytes queued, which is
+ * less than len when the queue is full, or -1 if audio was opened with a
+ * callback.  Call this from one thread only.
+ */
+extern DECLSPEC int SDLCALL SDL_QueueAudio(const void *data, Uint32 len);
+
+/**
+ * Returns the number of bytes queued but not yet played.
+ */
+extern DECLSPEC Uint32 SDLCALL SDL_GetQueuedAudioSize(void);
+
+/**
+ * Returns the number of times playback ran out of queued audio since the
+ * device was opened.  A gap spanning several buffers counts only once.
+ */
+extern DECLSPEC Uint32 SDLCALL SDL_GetAudioUnderruns(void);
+
+/**
+ * Drop all audio queued so far.  Call this from the thread that queues.
+ */
+extern DECLSPEC void SDLCALL SDL_ClearQueuedAudio(void);
+/*@}*/
+
 /**
  * @name Audio Locks
  * The lock manipulated by these functions protects the callback function.
@@ -29,6 +29,7 @@
 
 #include <stdarg.h>
 #define HAVE_STDINT_H		1
+#define SDL_HAS_64BIT_TYPE	1
 #define HAVE_ALLOCA_H		1
 #define HAVE_SYS_TYPES_H	1
 #define HAVE_STDIO_H	1
@@ -98,6 +99,8 @@
 #define HAVE_SETJMP	1
 #define HAVE_NANOSLEEP	1
 #define HAVE_SYSCONF	1
+#define HAVE_MMAP	1
+#define HAVE_PREAD	1
 #define HAVE_CLOCK_GETTIME 1
 
 /* Enable the QNX NTO audio driver (src/audio/nto/\*.c) */
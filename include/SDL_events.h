@@ -289,6 +289,28 @@ extern DECLSPEC int SDLCALL SDL_PollEvent(SDL_Event *event);
  */
 extern DECLSPEC int SDLCALL SDL_WaitEvent(SDL_Event *event);
 
+/** Waits up to 'timeout' milliseconds for the next available event, returning
+ *  1, or 0 if the timeout elapsed or there was an error while waiting for
+ *  events.  If 'event' is not NULL, the next event is removed from the queue
+ *  and stored in that area.
+ */
+extern DECLSPEC int SDLCALL SDL_WaitEventTimeout(SDL_Event *event, Uint32 timeout);
+
+/** Event queue statistics, see SDL_GetEventQueueStats() */
+typedef struct SDL_EventQueueStats {
+	Uint32 queued;		/**< Number of events currently in the queue */
+	Uint32 peak;		/**< Largest number of events queued at once */
+	Uint32 capacity;	/**< Number of events the queue holds before growing */
+	Uint32 dropped;		/**< Number of events lost because the queue was full */
+} SDL_EventQueueStats;
+
+/** Fills in 'stats' with the current state of the event queue.
+ *  The event queue grows as needed, so events are only dropped when memory
+ *  runs out or a very large number of events is left unprocessed.
+ *  This function returns 0 on success, or -1 if the event queue isn't running.
+ */
+extern DECLSPEC int SDLCALL SDL_GetEventQueueStats(SDL_EventQueueStats *stats);
+
 /** Add an event to the event queue.
  *  This function returns 0 on success, or -1 if the event queue was full
  *  or there was some other error.
@@ -61,7 +61,7 @@ typedef struct SDL_RWops {
 	/** Close and free an allocated SDL_FSops structure */
 	int (SDLCALL *close)(struct SDL_RWops *context);
 
-	Uint32 type;
+	Uint32 type;		/**< One of the SDL_RWOPS_* values below */
 	union {
 #if defined(__WIN32__) && !defined(__SYMBIAN32__)
 	    struct {
@@ -93,9 +93,31 @@ typedef struct SDL_RWops {
 } SDL_RWops;
 
 
+/** @name RWops types
+ *  Set in SDL_RWops::type, so code that knows an implementation can
+ *  look inside it.  Streams from SDL_AllocRW() start out as unknown.
+ */
+/*@{*/
+#define SDL_RWOPS_UNKNOWN	0	/**< Unknown stream type */
+#define SDL_RWOPS_WINFILE	1	/**< Win32 file */
+#define SDL_RWOPS_STDFILE	2	/**< Stdio file */
+#define SDL_RWOPS_MEMORY	4	/**< Memory stream, in hidden.mem */
+#define SDL_RWOPS_MEMORY_RO	5	/**< Read-only memory stream */
+#define SDL_RWOPS_BUFFERED	6	/**< Buffer over another stream, windowed
+					     through hidden.mem */
+#define SDL_RWOPS_ASYNC		7	/**< Read ahead by a thread, windowed
+					     through hidden.mem */
+#define SDL_RWOPS_ARCHIVE	8	/**< Member of an SDL_Archive */
+/*@}*/
+
 /** @name Functions to create SDL_RWops structures from various data sources */
 /*@{*/
 
+/** Open a file with a stdio style 'mode'.  If 'mode' also contains 'm',
+ *  a file opened for reading only is mapped into memory where the system
+ *  supports it, and then reads as a read-only memory stream.  Otherwise
+ *  the 'm' is ignored.
+ */
 extern DECLSPEC SDL_RWops * SDLCALL SDL_RWFromFile(const char *file, const char *mode);
 
 #ifdef HAVE_STDIO_H
@@ -105,6 +127,46 @@ extern DECLSPEC SDL_RWops * SDLCALL SDL_RWFromFP(FILE *fp, int autoclose);
 extern DECLSPEC SDL_RWops * SDLCALL SDL_RWFromMem(void *mem, int size);
 extern DECLSPEC SDL_RWops * SDLCALL SDL_RWFromConstMem(const void *mem, int size);
 
+/** Wrap a stream in a read buffer of 'blocksize' bytes, or 4096 if
+ *  'blocksize' is 0.  The source is read a block at a time, so many small
+ *  reads cost a copy each instead of a call into the source.  Writes and
+ *  seeks outside the buffer go through to the source.
+ *  If 'freesrc' is non-zero the source is closed along with the wrapper,
+ *  otherwise it is left positioned where the wrapper was, if it can seek.
+ */
+extern DECLSPEC SDL_RWops * SDLCALL SDL_RWFromRW(SDL_RWops *src, int freesrc, int blocksize);
+
+/** Wrap a stream so that a thread reads ahead of the caller.  The thread
+ *  keeps up to 'blocks' blocks of 'blocksize' bytes loaded, or 3 blocks of
+ *  65536 bytes for zeros, and reads hand out data from the loaded blocks.
+ *  Seeks outside the current block wait for the thread to seek the source
+ *  and start over.  The stream can't be written to.
+ *  The source belongs to the thread until the wrapper is closed, and then
+ *  is closed if 'freesrc' is non-zero, or left positioned where the
+ *  wrapper was.  Without thread support this is SDL_RWFromRW().
+ */
+extern DECLSPEC SDL_RWops * SDLCALL SDL_RWFromRWAsync(SDL_RWops *src, int freesrc, int blocksize, int blocks);
+
+/** Statistics kept by a stream from SDL_RWFromRWAsync(), with times in
+ *  seconds
+ */
+typedef struct SDL_RWAsyncStats {
+	Uint32 blocks;		/**< Blocks handed to the reader */
+	Uint32 underruns;	/**< Times the reader had to wait for a block */
+	double wait_time;	/**< Total time the reader waited */
+	double max_wait_time;	/**< Longest the reader waited at once */
+	double load_time;	/**< Total time spent reading the source */
+	double max_load_time;	/**< Longest read of one block */
+} SDL_RWAsyncStats;
+
+/** Get the statistics of a stream from SDL_RWFromRWAsync().
+ *  Returns 0, or -1 if the stream isn't one.
+ */
+extern DECLSPEC int SDLCALL SDL_GetRWAsyncStats(SDL_RWops *ctx, SDL_RWAsyncStats *stats);
+
+/** Reset the statistics of a stream from SDL_RWFromRWAsync() */
+extern DECLSPEC void SDLCALL SDL_ResetRWAsyncStats(SDL_RWops *ctx);
+
 extern DECLSPEC SDL_RWops * SDLCALL SDL_AllocRW(void);
 extern DECLSPEC void SDLCALL SDL_FreeRW(SDL_RWops *area);
 
@@ -126,6 +188,23 @@ extern DECLSPEC void SDLCALL SDL_FreeRW(SDL_RWops *area);
 #define SDL_RWclose(ctx)		(ctx)->close(ctx)
 /*@}*/
 
+/** Look at the next bytes of a buffered or memory stream without copying.
+ *  Up to the block size, the buffer is refilled until it holds at least
+ *  'want' bytes or the source runs out.  Returns a pointer to the bytes
+ *  and stores how many there are in 'len', or returns NULL if the stream
+ *  is of another type.  The pointer is good until the next call on the
+ *  stream; use SDL_RWseek(ctx, n, RW_SEEK_CUR) to step over what was used.
+ */
+extern DECLSPEC const Uint8 * SDLCALL SDL_RWPeek(SDL_RWops *ctx, int want, int *len);
+
+/** Borrow a pointer to the 'size' bytes at 'offset' in a memory, mapped or
+ *  buffered stream, without copying them or moving the stream.  Returns
+ *  NULL, without setting an error, if the bytes aren't all in memory;
+ *  the caller then reads them as usual.  The pointer is good until the
+ *  stream is closed, or for a buffered stream until it is next used.
+ */
+extern DECLSPEC const Uint8 * SDLCALL SDL_RWBorrow(SDL_RWops *ctx, int offset, int size);
+
 /** @name Read an item of the specified endianness and return in native format */
 /*@{*/
 extern DECLSPEC Uint16 SDLCALL SDL_ReadLE16(SDL_RWops *src);
@@ -136,6 +215,94 @@ extern DECLSPEC Uint64 SDLCALL SDL_ReadLE64(SDL_RWops *src);
 extern DECLSPEC Uint64 SDLCALL SDL_ReadBE64(SDL_RWops *src);
 /*@}*/
 
+/** The read function of the memory, buffered and read-ahead streams,
+ *  which keep their unread bytes between hidden.mem.here and
+ *  hidden.mem.stop.  Code that looks inside a stream checks for it
+ *  first, because 'type' isn't set in a structure filled in by hand.
+ */
+extern DECLSPEC int SDLCALL SDL_RWReadWindow(SDL_RWops *ctx, void *ptr, int size, int maxnum);
+
+#if defined(SDL_INLINE_OKAY) && !defined(SDL_RWOPS_NO_INLINE)
+/** @name Inline versions of the readers
+ *  Streams read through SDL_RWReadWindow() have the value put together
+ *  from hidden.mem directly, and only a read that crosses the end of
+ *  the window calls into the library.
+ */
+/*@{*/
+#define SDL_RWInWindow(ctx, n) \
+	((ctx)->read == SDL_RWReadWindow && \
+	 (ctx)->hidden.mem.stop - (ctx)->hidden.mem.here >= (n))
+
+static __inline__ Uint16 SDL_InlineReadLE16(SDL_RWops *src)
+{
+	if ( SDL_RWInWindow(src, 2) ) {
+		const Uint8 *p = src->hidden.mem.here;
+		src->hidden.mem.here += 2;
+		return (Uint16)(p[0] | (p[1] << 8));
+	}
+	return SDL_ReadLE16(src);
+}
+static __inline__ Uint16 SDL_InlineReadBE16(SDL_RWops *src)
+{
+	if ( SDL_RWInWindow(src, 2) ) {
+		const Uint8 *p = src->hidden.mem.here;
+		src->hidden.mem.here += 2;
+		return (Uint16)((p[0] << 8) | p[1]);
+	}
+	return SDL_ReadBE16(src);
+}
+static __inline__ Uint32 SDL_InlineReadLE32(SDL_RWops *src)
+{
+	if ( SDL_RWInWindow(src, 4) ) {
+		const Uint8 *p = src->hidden.mem.here;
+		src->hidden.mem.here += 4;
+		return ((Uint32)p[0] | ((Uint32)p[1] << 8) |
+		        ((Uint32)p[2] << 16) | ((Uint32)p[3] << 24));
+	}
+	return SDL_ReadLE32(src);
+}
+static __inline__ Uint32 SDL_InlineReadBE32(SDL_RWops *src)
+{
+	if ( SDL_RWInWindow(src, 4) ) {
+		const Uint8 *p = src->hidden.mem.here;
+		src->hidden.mem.here += 4;
+		return (((Uint32)p[0] << 24) | ((Uint32)p[1] << 16) |
+		        ((Uint32)p[2] << 8) | (Uint32)p[3]);
+	}
+	return SDL_ReadBE32(src);
+}
+#ifdef SDL_HAS_64BIT_TYPE
+static __inline__ Uint64 SDL_InlineReadLE64(SDL_RWops *src)
+{
+	if ( SDL_RWInWindow(src, 8) ) {
+		Uint32 lo = SDL_InlineReadLE32(src);
+		Uint32 hi = SDL_InlineReadLE32(src);
+		return (((Uint64)hi << 32) | lo);
+	}
+	return SDL_ReadLE64(src);
+}
+static __inline__ Uint64 SDL_InlineReadBE64(SDL_RWops *src)
+{
+	if ( SDL_RWInWindow(src, 8) ) {
+		Uint32 hi = SDL_InlineReadBE32(src);
+		Uint32 lo = SDL_InlineReadBE32(src);
+		return (((Uint64)hi << 32) | lo);
+	}
+	return SDL_ReadBE64(src);
+}
+#endif
+
+#define SDL_ReadLE16(src)	SDL_InlineReadLE16(src)
+#define SDL_ReadBE16(src)	SDL_InlineReadBE16(src)
+#define SDL_ReadLE32(src)	SDL_InlineReadLE32(src)
+#define SDL_ReadBE32(src)	SDL_InlineReadBE32(src)
+#ifdef SDL_HAS_64BIT_TYPE
+#define SDL_ReadLE64(src)	SDL_InlineReadLE64(src)
+#define SDL_ReadBE64(src)	SDL_InlineReadBE64(src)
+#endif
+/*@}*/
+#endif /* SDL_INLINE_OKAY */
+
 /** @name Write an item of native format to the specified endianness */
 /*@{*/
 extern DECLSPEC int SDLCALL SDL_WriteLE16(SDL_RWops *dst, Uint16 value);
@@ -0,0 +1,134 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+
+#ifndef _SDL_threadpool_h
+#define _SDL_threadpool_h
+
+/** @file SDL_threadpool.h
+ *  A pool of worker threads for running many small jobs in parallel
+ *
+ *  Each worker has its own queue of jobs.  Jobs queued from a worker go
+ *  on its own queue, jobs from other threads are spread over the queues,
+ *  and a worker whose queue is empty steals from the others.  A thread
+ *  waiting for a group of jobs runs queued jobs while it waits.
+ */
+
+#include "SDL_stdinc.h"
+#include "SDL_error.h"
+
+#include "begin_code.h"
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** The thread pool structure, defined in SDL_threadpool.c */
+struct SDL_ThreadPool;
+typedef struct SDL_ThreadPool SDL_ThreadPool;
+
+/** A set of jobs that can be waited for together */
+struct SDL_JobGroup;
+typedef struct SDL_JobGroup SDL_JobGroup;
+
+/** The function run for a job */
+typedef void (SDLCALL *SDL_JobFunction)(void *data);
+
+/** The function run for each range of a parallel for loop */
+typedef void (SDLCALL *SDL_RangeFunction)(void *data, int first, int last);
+
+/** Statistics kept by a thread pool, with times in seconds */
+typedef struct SDL_ThreadPoolStats {
+	int threads;		/**< Worker threads in the pool */
+	Uint32 jobs;		/**< Jobs finished */
+	Uint32 stolen;		/**< Jobs a worker took from another's queue */
+	Uint32 helped;		/**< Jobs run by threads waiting on a group */
+	double run_time;	/**< Total time spent running jobs */
+	double max_run_time;	/**< Longest time spent running one job */
+	double wait_time;	/**< Total time jobs spent queued */
+	double max_wait_time;	/**< Longest time one job spent queued */
+} SDL_ThreadPoolStats;
+
+/**
+ * Create a pool of worker threads.  If 'threads' is 0, there is one less
+ * than the number of CPUs, since the thread waiting on the jobs runs them
+ * too.  A pool without threads runs each job as it is submitted.
+ */
+extern DECLSPEC SDL_ThreadPool * SDLCALL SDL_CreateThreadPool(int threads);
+
+/**
+ * Get the pool shared by SDL and the application, creating it the first
+ * time.  Its size can be set with the SDL_THREAD_POOL_SIZE environment
+ * variable.  It is destroyed by SDL_Quit().  Passing a NULL pool to the
+ * functions below uses this pool.
+ */
+extern DECLSPEC SDL_ThreadPool * SDLCALL SDL_GetThreadPool(void);
+
+/** Return the number of worker threads in a pool */
+extern DECLSPEC int SDLCALL SDL_GetThreadPoolSize(SDL_ThreadPool *pool);
+
+/**
+ * Finish all the queued jobs, then stop the worker threads and free the
+ * pool.  No jobs may be submitted once this has been called.
+ */
+extern DECLSPEC void SDLCALL SDL_DestroyThreadPool(SDL_ThreadPool *pool);
+
+/** Create an empty group of jobs, returning NULL on error */
+extern DECLSPEC SDL_JobGroup * SDLCALL SDL_CreateJobGroup(SDL_ThreadPool *pool);
+
+/**
+ * Queue a job in a group.  Jobs may be submitted from any thread,
+ * including from other jobs.  Returns 0, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_SubmitJob(SDL_JobGroup *group, SDL_JobFunction fn, void *data);
+
+/** Wait until every job submitted to the group has finished */
+extern DECLSPEC void SDLCALL SDL_WaitJobGroup(SDL_JobGroup *group);
+
+/** Wait for the jobs in a group to finish, then free it */
+extern DECLSPEC void SDLCALL SDL_FreeJobGroup(SDL_JobGroup *group);
+
+/**
+ * Call fn(data, first, last) over ranges of [0, count) in parallel,
+ * returning when they have all finished.  Each range covers 'grain' items,
+ * or if 'grain' is 0, enough for each thread to get a few ranges.
+ * Returns 0, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_ParallelFor(SDL_ThreadPool *pool, int count, int grain, SDL_RangeFunction fn, void *data);
+
+/**
+ * Get the statistics for all jobs run by a pool since it was created or
+ * its statistics were last reset.  They are exact once the jobs they
+ * cover have been waited for.
+ */
+extern DECLSPEC void SDLCALL SDL_GetThreadPoolStats(SDL_ThreadPool *pool, SDL_ThreadPoolStats *stats);
+
+/** Reset the statistics of a pool.  Only call this when it is idle. */
+extern DECLSPEC void SDLCALL SDL_ResetThreadPoolStats(SDL_ThreadPool *pool);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+#include "close_code.h"
+
+#endif /* _SDL_threadpool_h */
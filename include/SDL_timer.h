@@ -51,6 +51,27 @@ extern DECLSPEC Uint32 SDLCALL SDL_GetTicks(void);
 /** Wait a specified number of milliseconds before returning */
 extern DECLSPEC void SDLCALL SDL_Delay(Uint32 ms);
 
+#ifdef SDL_HAS_64BIT_TYPE
+/**
+ * Get the current value of the high resolution counter.
+ * The counter only makes sense relative to other values of the counter,
+ * and ticks SDL_GetPerformanceFrequency() times per second.  Platforms
+ * without a high resolution clock fall back to counting milliseconds.
+ */
+extern DECLSPEC Uint64 SDLCALL SDL_GetPerformanceCounter(void);
+
+/** Get the number of high resolution counter ticks per second */
+extern DECLSPEC Uint64 SDLCALL SDL_GetPerformanceFrequency(void);
+
+/**
+ * Wait a specified number of nanoseconds before returning.
+ * This sleeps for most of the wait and then spins on the high resolution
+ * counter for the last fraction of a millisecond, so it is much more
+ * accurate than SDL_Delay() at the cost of some CPU time.
+ */
+extern DECLSPEC void SDLCALL SDL_DelayPrecise(Uint64 ns);
+#endif /* SDL_HAS_64BIT_TYPE */
+
 /** Function prototype for the timer callback function */
 typedef Uint32 (SDLCALL *SDL_TimerCallback)(Uint32 interval);
 
@@ -941,6 +941,31 @@ extern DECLSPEC SDL_GrabMode SDLCALL SDL_WM_GrabInput(SDL_GrabMode mode);
 /** @internal Not in public API at the moment - do not use! */
 extern DECLSPEC int SDLCALL SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
                                     SDL_Surface *dst, SDL_Rect *dstrect);
+
+/** Filters available to SDL_SoftStretchFiltered() */
+typedef enum {
+	SDL_STRETCH_NEAREST = 0,	/**< Nearest neighbour, any pixel depth */
+	SDL_STRETCH_BILINEAR		/**< Bilinear, 16 and 32 bpp surfaces */
+} SDL_StretchFilter;
+
+/**
+ * Perform a stretched copy of a rectangle of one surface into a rectangle
+ * of another surface with the same pixel format.  A NULL rectangle means
+ * the whole surface.  Unlike SDL_BlitSurface(), the rectangles are not
+ * clipped: they must lie entirely within their surfaces.
+ *
+ * Bilinear filtering samples at pixel centres and clamps to the edges of
+ * the source rectangle.  It treats every channel of the pixel format,
+ * including alpha, independently.
+ *
+ * This function is safe to call from several threads at once, as long
+ * as they don't write to the same surface.
+ *
+ * @return 0 on success, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_SoftStretchFiltered(SDL_Surface *src,
+			SDL_Rect *srcrect, SDL_Surface *dst, SDL_Rect *dstrect,
+			SDL_StretchFilter filter);
                     
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
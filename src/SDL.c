@@ -48,6 +48,12 @@ extern int  SDL_TimerInit(void);
 extern void SDL_TimerQuit(void);
 #endif
 
+/* The thread pool shared with the application */
+extern void SDL_QuitThreadPool(void);
+
+/* The rate conversion tables, which don't need the audio subsystem */
+extern void SDL_QuitResampler(void);
+
 /* The current SDL version */
 static SDL_version version = 
 	{ SDL_MAJOR_VERSION, SDL_MINOR_VERSION, SDL_PATCHLEVEL };
@@ -220,6 +226,8 @@ void SDL_Quit(void)
   printf("[SDL_Quit] : Enter! Calling QuitSubSystem()\n"); fflush(stdout);
 #endif
 	SDL_QuitSubSystem(SDL_INIT_EVERYTHING);
+	SDL_QuitThreadPool();
+	SDL_QuitResampler();
 
 #ifdef CHECK_LEAKS
 #ifdef DEBUG_BUILD
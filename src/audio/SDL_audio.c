@@ -130,6 +130,7 @@ int SDLCALL SDL_RunAudio(void *audiop)
 	SDL_AudioDevice *audio = (SDL_AudioDevice *)audiop;
 	Uint8 *stream;
 	int    stream_len;
+	int    len, done;
 	void  *udata;
 	void (SDLCALL *fill)(void *userdata,Uint8 *stream, int len);
 	int    silence;
@@ -144,12 +145,8 @@ int SDLCALL SDL_RunAudio(void *audiop)
 	fill  = audio->spec.callback;
 	udata = audio->spec.userdata;
 
-	if ( audio->convert.needed ) {
-		if ( audio->convert.src_format == AUDIO_U8 ) {
-			silence = 0x80;
-		} else {
-			silence = 0;
-		}
+	if ( audio->convert.buf ) {
+		silence = audio->callback_spec.silence;
 		stream_len = audio->convert.len;
 	} else {
 		silence = audio->spec.silence;
@@ -180,6 +177,42 @@ int SDLCALL SDL_RunAudio(void *audiop)
 	/* Loop, filling the audio buffers */
 	while ( audio->enabled ) {
 
+		/* Changing the rate takes as many callbacks as it needs to fill
+		   the device buffer, and keeps any input left over for next time */
+		if ( audio->resampler ) {
+			stream = audio->GetAudioBuf(audio);
+			if ( stream == NULL ) {
+				stream = audio->fake_stream;
+			}
+			done = 0;
+			for ( ;; ) {
+				done += SDL_ReadResampler(audio->resampler,
+				                          stream + done,
+				                          audio->spec.size - done);
+				if ( done == audio->spec.size ) {
+					break;
+				}
+				SDL_memset(audio->convert.buf, silence, stream_len);
+				if ( ! audio->paused ) {
+					SDL_mutexP(audio->mixer_lock);
+					(*fill)(udata, audio->convert.buf, stream_len);
+					SDL_mutexV(audio->mixer_lock);
+				}
+				len = stream_len;
+				if ( audio->convert.needed ) {
+					SDL_ConvertAudio(&audio->convert);
+					len = audio->convert.len_cvt;
+				}
+				if ( SDL_FeedResampler(audio->resampler,
+				                       audio->convert.buf, len) == 0 ) {
+					SDL_memset(stream + done, audio->spec.silence,
+					           audio->spec.size - done);
+					break;
+				}
+			}
+			goto play;
+		}
+
 		/* Fill the current buffer with sound */
 		if ( audio->convert.needed ) {
 			if ( audio->convert.buf ) {
@@ -209,10 +242,20 @@ int SDLCALL SDL_RunAudio(void *audiop)
 			if ( stream == NULL ) {
 				stream = audio->fake_stream;
 			}
-			SDL_memcpy(stream, audio->convert.buf,
-			               audio->convert.len_cvt);
+			/* Never copy more than the device buffer holds */
+			if ( audio->convert.len_cvt < audio->spec.size ) {
+				SDL_memcpy(stream, audio->convert.buf,
+				               audio->convert.len_cvt);
+				SDL_memset(stream + audio->convert.len_cvt,
+				           audio->spec.silence,
+				           audio->spec.size - audio->convert.len_cvt);
+			} else {
+				SDL_memcpy(stream, audio->convert.buf,
+				               audio->spec.size);
+			}
 		}
 
+play:
 		/* Ready current buffer for play and change current buffer */
 		if ( stream != audio->fake_stream ) {
 			audio->PlayAudio(audio);
@@ -472,11 +515,6 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 		}
 		desired->samples = power2;
 	}
-	if ( desired->callback == NULL ) {
-		SDL_SetError("SDL_OpenAudio() passed a NULL callback");
-		return(-1);
-	}
-
 #if SDL_THREADS_DISABLED
 	/* Uses interrupt driven audio, without thread */
 #else
@@ -494,6 +532,11 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 
 	/* Open the audio subsystem */
 	SDL_memcpy(&audio->spec, desired, sizeof(audio->spec));
+	if ( audio->spec.callback == NULL ) {
+		/* The application pushes audio with SDL_QueueAudio().  Only
+		   our copy of the spec says so, the caller's are left alone. */
+		audio->spec.callback = SDL_DrainAudioQueue;
+	}
 	audio->convert.needed = 0;
 	audio->enabled = 1;
 	audio->paused  = 1;
@@ -522,21 +565,49 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 	/* See if we need to do any conversion */
 	if ( obtained != NULL ) {
 		SDL_memcpy(obtained, &audio->spec, sizeof(audio->spec));
+		if ( obtained->callback == SDL_DrainAudioQueue ) {
+			obtained->callback = NULL;
+		}
 	} else if ( desired->freq != audio->spec.freq ||
                     desired->format != audio->spec.format ||
 	            desired->channels != audio->spec.channels ) {
+		/* SDL_RunAudio() changes the rate with a resampler that
+		   carries on from one buffer to the next.  Drivers that feed
+		   the device themselves convert each buffer on its own. */
+		int resample = ( (audio->opened == 1) &&
+		                 (desired->freq != audio->spec.freq) );
+
 		/* Build an audio conversion block */
 		if ( SDL_BuildAudioCVT(&audio->convert,
 			desired->format, desired->channels,
 					desired->freq,
 			audio->spec.format, audio->spec.channels,
-					audio->spec.freq) < 0 ) {
+			resample ? desired->freq : audio->spec.freq) < 0 ) {
 			SDL_CloseAudio();
 			return(-1);
 		}
-		if ( audio->convert.needed ) {
+		if ( resample ) {
+			/* Ask the callback for about a device buffer's worth */
+			int frames = (int)(((double)audio->spec.samples *
+			                    desired->freq) / audio->spec.freq + 0.5);
+
+			if ( frames < 1 ) {
+				frames = 1;
+			}
+			audio->convert.len = frames * desired->channels *
+			                     ((desired->format & 0xFF) / 8);
+			audio->resampler = SDL_CreateResampler(
+			        audio->spec.format, audio->spec.channels,
+			        desired->freq, audio->spec.freq, frames);
+			if ( audio->resampler == NULL ) {
+				SDL_CloseAudio();
+				return(-1);
+			}
+		} else if ( audio->convert.needed ) {
 			audio->convert.len = (int) ( ((double) audio->spec.size) /
                                           audio->convert.len_ratio );
+		}
+		if ( audio->convert.needed || audio->resampler ) {
 			audio->convert.buf =(Uint8 *)SDL_AllocAudioMem(
 			   audio->convert.len*audio->convert.len_mult);
 			if ( audio->convert.buf == NULL ) {
@@ -547,6 +618,25 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 		}
 	}
 
+	/* Remember the format the callback fills, for SDL_MixVoices() */
+	if ( obtained != NULL ) {
+		SDL_memcpy(&audio->callback_spec, obtained, sizeof(audio->spec));
+	} else {
+		SDL_memcpy(&audio->callback_spec, desired, sizeof(audio->spec));
+	}
+	audio->callback_spec.callback = audio->spec.callback;
+	if ( SDL_OpenVoices(&audio->callback_spec, audio->convert.buf ?
+	                    audio->convert.len : audio->spec.size) < 0 ) {
+		SDL_CloseAudio();
+		return(-1);
+	}
+	if ( audio->callback_spec.callback == SDL_DrainAudioQueue ) {
+		if ( SDL_OpenAudioQueue(&audio->callback_spec) < 0 ) {
+			SDL_CloseAudio();
+			return(-1);
+		}
+	}
+
 	/* Start the audio thread if necessary */
 	switch (audio->opened) {
 		case  1:
@@ -631,16 +721,18 @@ void SDL_AudioQuit(void)
 		if ( audio->thread != NULL ) {
 			SDL_WaitThread(audio->thread, NULL);
 		}
+		SDL_QuitVoices();
+		SDL_CloseAudioQueue();
 		if ( audio->mixer_lock != NULL ) {
 			SDL_DestroyMutex(audio->mixer_lock);
 		}
 		if ( audio->fake_stream != NULL ) {
 			SDL_FreeAudioMem(audio->fake_stream);
 		}
-		if ( audio->convert.needed ) {
+		if ( audio->convert.buf != NULL ) {
 			SDL_FreeAudioMem(audio->convert.buf);
-
 		}
+		SDL_FreeResampler(audio->resampler);
 		if ( audio->opened ) {
 			audio->CloseAudio(audio);
 			audio->opened = 0;
@@ -649,6 +741,7 @@ void SDL_AudioQuit(void)
 		audio->free(audio);
 		current_audio = NULL;
 	}
+	SDL_QuitResampler();
 }
 
 #define NUM_FORMATS	6
@@ -32,3 +32,35 @@ extern void SDL_CalculateAudioSpec(SDL_AudioSpec *spec);
 
 /* The actual mixing thread function */
 extern int SDLCALL SDL_RunAudio(void *audiop);
+
+/* Free the resampling tables, from SDL_audiocvt.c.  They are built again
+   if a conversion needs them afterwards. */
+extern void SDL_QuitResampler(void);
+
+/* Rate conversion that carries its state from one buffer to the next,
+   from SDL_audiocvt.c.  The input and output are in 'format', and no
+   more than 'max_frames' may be put in at once.
+ */
+typedef struct SDL_AudioResampler SDL_AudioResampler;
+extern SDL_AudioResampler *SDL_CreateResampler(Uint16 format, int channels,
+                                               int src_rate, int dst_rate,
+                                               int max_frames);
+extern void SDL_ResetResampler(SDL_AudioResampler *resampler);
+/* Returns the bytes of input taken, only feed more once a read comes up short */
+extern int SDL_FeedResampler(SDL_AudioResampler *resampler,
+                            const Uint8 *buf, int len);
+/* Returns the bytes of output written, up to len */
+extern int SDL_ReadResampler(SDL_AudioResampler *resampler,
+                            Uint8 *buf, int len);
+extern void SDL_FreeResampler(SDL_AudioResampler *resampler);
+
+/* Size the mixing buffer for callbacks of 'len' bytes when the audio is
+   opened, and stop all voices, the feeder thread and free the buffer when
+   it's closed, from SDL_voice.c */
+extern int SDL_OpenVoices(const SDL_AudioSpec *spec, int len);
+extern void SDL_QuitVoices(void);
+
+/* The queue behind SDL_QueueAudio(), from SDL_audioqueue.c */
+extern int SDL_OpenAudioQueue(const SDL_AudioSpec *spec);
+extern void SDL_CloseAudioQueue(void);
+extern void SDLCALL SDL_DrainAudioQueue(void *userdata, Uint8 *stream, int len);
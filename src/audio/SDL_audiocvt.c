@@ -24,6 +24,9 @@
 /* Functions for audio drivers to perform runtime conversion of audio format */
 
 #include "SDL_audio.h"
+#include "SDL_mutex.h"
+#include "SDL_audio_c.h"
+#include "../thread/SDL_barrier.h"
 
 
 /* Effectively mix right and left channels into a single channel */
@@ -798,7 +801,7 @@ void SDLCALL SDL_Convert8(SDL_AudioCVT *cvt, Uint16 format)
 		src += 2;
 		dst += 1;
 	}
-	format = ((format & ~0x9010) | AUDIO_U8);
+	format = ((format & ~0x1010) | AUDIO_U8);
 	cvt->len_cvt /= 2;
 	if ( cvt->filters[++cvt->filter_index] ) {
 		cvt->filters[cvt->filter_index](cvt, format);
@@ -1300,6 +1303,1057 @@ void SDLCALL SDL_RateSLOW(SDL_AudioCVT *cvt, Uint16 format)
 	}
 }
 
+/* Polyphase resampling by an arbitrary ratio.
+
+   The rates are reduced to L output frames for every M input frames, so
+   output frame n falls at input position n*M/L: frame n*M/L plus phase
+   (n*M)%L of L.  Each phase has its own set of filter taps, stored as
+   14-bit fixed point and normalised to unity gain:
+     quality 0:  linear interpolation (2 taps)
+     quality 1:  Kaiser windowed sinc, 8 zero crossings each side
+     quality 2:  Kaiser windowed sinc, 24 zero crossings each side
+   When downsampling, the cutoff drops to the output Nyquist frequency
+   and the filter widens to match.
+
+   Tables are built by SDL_BuildAudioCVT() and kept until the audio
+   subsystem or SDL is shut down, since applications copy SDL_AudioCVT
+   around freely and it has no room for a pointer.  The filter finds its
+   table again by quality and cvt->rate_incr, which is M/L, and builds
+   it again if it was freed meanwhile.  Tables are never changed once
+   they are on the list, so the filter only needs a memory barrier to
+   look for one, and the lock just keeps two threads from building the
+   same table.
+
+   SDL_ConvertAudio() resamples each buffer on its own, holding the first
+   and last input frames beyond the edges.  The input is first unpacked
+   to 16-bit at the far end of cvt->buf, which is why this filter asks
+   for a large len_mult, and the output is then written from the start
+   of the buffer.  The audio device and streaming voices use an
+   SDL_AudioResampler instead, which carries on from one buffer to the
+   next.
+*/
+#define RESAMPLE_MAXPHASES	1024
+#define RESAMPLE_MAXTAPS	256
+#define RESAMPLE_SHIFT		14
+
+typedef struct SDL_ResampleTable {
+	double incr;
+	int quality;
+	int phases;
+	int step;
+	int taps;
+	Sint16 *coeffs;
+	struct SDL_ResampleTable *next;
+} SDL_ResampleTable;
+
+static SDL_ResampleTable * volatile SDL_resample_tables = NULL;
+static SDL_mutex *SDL_resample_lock = NULL;
+
+/* Only what the filter design needs, so the library doesn't need libm */
+static double SDL_ResampleSin(double x)
+{
+	const double pi = 3.14159265358979323846;
+	double x2, term, sum;
+	int i;
+
+	/* Reduce to [-pi/2, pi/2] */
+	x -= 2.0 * pi * (double)(Sint32)(x / (2.0 * pi));
+	if ( x > pi ) {
+		x -= 2.0 * pi;
+	} else if ( x < -pi ) {
+		x += 2.0 * pi;
+	}
+	if ( x > pi / 2.0 ) {
+		x = pi - x;
+	} else if ( x < -pi / 2.0 ) {
+		x = -pi - x;
+	}
+	x2 = x * x;
+	term = x;
+	sum = x;
+	for ( i = 1; i < 12; ++i ) {
+		term *= -x2 / ((2*i) * (2*i + 1));
+		sum += term;
+	}
+	return(sum);
+}
+
+static double SDL_ResampleSqrt(double x)
+{
+	double r;
+	int i;
+
+	if ( x <= 0.0 ) {
+		return(0.0);
+	}
+	r = (x > 1.0) ? x : 1.0;
+	for ( i = 0; i < 64; ++i ) {
+		r = 0.5 * (r + x / r);
+	}
+	return(r);
+}
+
+/* Zeroth order modified Bessel function of the first kind */
+static double SDL_ResampleI0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	int k;
+
+	for ( k = 1; k < 64; ++k ) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+		if ( term < sum * 1e-15 ) {
+			break;
+		}
+	}
+	return(sum);
+}
+
+static int SDL_ResampleGCD(int a, int b)
+{
+	while ( b ) {
+		int t = a % b;
+		a = b;
+		b = t;
+	}
+	return(a);
+}
+
+static void SDL_BuildResampleCoeffs(SDL_ResampleTable *table)
+{
+	const double pi = 3.14159265358979323846;
+	const int half = table->taps / 2;
+	double cutoff, beta, i0beta, h[RESAMPLE_MAXTAPS], sum, d, x, w;
+	int p, k, total, peak;
+	Sint16 *coeffs;
+
+	cutoff = 1.0;
+	if ( table->step > table->phases ) {
+		cutoff = (double)table->phases / table->step;
+	}
+	if ( table->quality == 1 ) {
+		cutoff *= 0.90;
+		beta = 6.0;
+	} else {
+		cutoff *= 0.95;
+		beta = 9.0;
+	}
+	i0beta = SDL_ResampleI0(beta);
+
+	for ( p = 0; p < table->phases; ++p ) {
+		coeffs = &table->coeffs[p * table->taps];
+		if ( table->quality == 0 ) {
+			coeffs[1] = (Sint16)(((p << RESAMPLE_SHIFT) +
+			                      table->phases / 2) / table->phases);
+			coeffs[0] = (Sint16)((1 << RESAMPLE_SHIFT) - coeffs[1]);
+			continue;
+		}
+
+		/* Tap k is for input frame (k - half + 1), relative to the
+		   frame the output position falls in */
+		sum = 0.0;
+		for ( k = 0; k < table->taps; ++k ) {
+			d = (double)(k - half + 1) - (double)p / table->phases;
+			x = d / half;
+			w = SDL_ResampleI0(beta * SDL_ResampleSqrt(1.0 - x * x)) /
+			    i0beta;
+			if ( d == 0.0 ) {
+				h[k] = cutoff * w;
+			} else {
+				h[k] = SDL_ResampleSin(pi * cutoff * d) / (pi * d) * w;
+			}
+			sum += h[k];
+		}
+
+		/* Round to fixed point and put the rounding error on the
+		   largest tap, so every phase has exactly unity gain */
+		total = 0;
+		peak = 0;
+		for ( k = 0; k < table->taps; ++k ) {
+			x = h[k] / sum * (1 << RESAMPLE_SHIFT);
+			coeffs[k] = (Sint16)((x < 0.0) ? (x - 0.5) : (x + 0.5));
+			total += coeffs[k];
+			if ( coeffs[k] > coeffs[peak] ) {
+				peak = k;
+			}
+		}
+		coeffs[peak] += (Sint16)((1 << RESAMPLE_SHIFT) - total);
+	}
+}
+
+/* SDL_AUDIO_RESAMPLE_QUALITY picks the resampler:
+     0: doubling or halving, then linear interpolation
+     1: windowed sinc (the default)
+     2: longer windowed sinc
+ */
+static int SDL_ResampleQuality(void)
+{
+	const char *hint;
+	int quality;
+
+	quality = 1;
+	hint = SDL_getenv("SDL_AUDIO_RESAMPLE_QUALITY");
+	if ( hint ) {
+		quality = SDL_atoi(hint);
+		if ( quality < 0 ) {
+			quality = 0;
+		} else if ( quality > 2 ) {
+			quality = 2;
+		}
+	}
+	return(quality);
+}
+
+/* Create the lock the first time a table is built, which needn't be from
+   SDL_Init().  If two threads race to do it, only one lock is kept.
+   Without SDL_CompareAndSwapPointer this expects the first conversion to
+   be set up before there are other threads. */
+static int SDL_InitResampler(void)
+{
+	SDL_mutex *lock;
+
+	if ( SDL_resample_lock == NULL ) {
+		lock = SDL_CreateMutex();
+		if ( lock == NULL ) {
+			return(-1);
+		}
+#ifdef SDL_CompareAndSwapPointer
+		if ( !SDL_CompareAndSwapPointer(&SDL_resample_lock, NULL, lock) ) {
+			SDL_DestroyMutex(lock);
+		}
+#else
+		SDL_resample_lock = lock;
+#endif
+	}
+	return(0);
+}
+
+/* Called from SDL_AudioQuit() and SDL_Quit(), when nothing is converting */
+void SDL_QuitResampler(void)
+{
+	SDL_ResampleTable *table;
+
+	while ( SDL_resample_tables ) {
+		table = SDL_resample_tables;
+		SDL_resample_tables = table->next;
+		SDL_free(table->coeffs);
+		SDL_free(table);
+	}
+	if ( SDL_resample_lock ) {
+		SDL_DestroyMutex(SDL_resample_lock);
+		SDL_resample_lock = NULL;
+	}
+}
+
+/* Look for a table, without the lock where there is a memory barrier */
+static SDL_ResampleTable *SDL_FindResampleTable(double incr, int quality)
+{
+	SDL_ResampleTable *table;
+
+#ifdef SDL_MemoryBarrier
+	table = SDL_resample_tables;
+	SDL_MemoryBarrier();
+#else
+	if ( SDL_resample_lock == NULL ) {
+		return(NULL);
+	}
+	SDL_mutexP(SDL_resample_lock);
+	table = SDL_resample_tables;
+	SDL_mutexV(SDL_resample_lock);
+#endif
+	for ( ; table; table = table->next ) {
+		if ( (table->incr == incr) && (table->quality == quality) ) {
+			break;
+		}
+	}
+	return(table);
+}
+
+/* Find or build the table for 'phases' outputs every 'step' inputs,
+   returning NULL on error */
+static SDL_ResampleTable *SDL_LoadResampleTable(int step, int phases,
+                                                int quality)
+{
+	SDL_ResampleTable *table;
+	double incr;
+
+	incr = (double)step / phases;
+	table = SDL_FindResampleTable(incr, quality);
+	if ( table ) {
+		return(table);
+	}
+	if ( SDL_InitResampler() < 0 ) {
+		return(NULL);
+	}
+
+	/* Another thread may have built it since we looked */
+	SDL_mutexP(SDL_resample_lock);
+	for ( table = SDL_resample_tables; table; table = table->next ) {
+		if ( (table->incr == incr) && (table->quality == quality) ) {
+			break;
+		}
+	}
+	if ( table == NULL ) {
+		table = (SDL_ResampleTable *)SDL_malloc(sizeof(*table));
+		if ( table ) {
+			table->incr = incr;
+			table->quality = quality;
+			table->phases = phases;
+			table->step = step;
+			if ( quality == 0 ) {
+				table->taps = 2;
+			} else {
+				/* Stretch the filter out when downsampling */
+				table->taps = (quality == 1) ? 16 : 48;
+				if ( step > phases ) {
+					table->taps = (table->taps * step +
+					               phases - 1) / phases;
+					table->taps = (table->taps + 1) & ~1;
+				}
+				if ( table->taps > RESAMPLE_MAXTAPS ) {
+					table->taps = RESAMPLE_MAXTAPS;
+				}
+			}
+			table->coeffs = (Sint16 *)SDL_malloc(
+			        phases * table->taps * sizeof(Sint16));
+			if ( table->coeffs ) {
+				SDL_BuildResampleCoeffs(table);
+				table->next = SDL_resample_tables;
+#ifdef SDL_MemoryBarrier
+				/* Finish the table before it can be seen */
+				SDL_MemoryBarrier();
+#endif
+				SDL_resample_tables = table;
+			} else {
+				SDL_free(table);
+				table = NULL;
+			}
+		}
+		if ( table == NULL ) {
+			SDL_OutOfMemory();
+		}
+	}
+	SDL_mutexV(SDL_resample_lock);
+	return(table);
+}
+
+/* Find or build the table for a conversion, returning NULL on error */
+static SDL_ResampleTable *SDL_GetResampleTable(int src_rate, int dst_rate,
+                                               int quality)
+{
+	int phases, step, gcd;
+
+	gcd = SDL_ResampleGCD(src_rate, dst_rate);
+	phases = dst_rate / gcd;
+	step = src_rate / gcd;
+	if ( phases > RESAMPLE_MAXPHASES ) {
+		/* Close enough, the pitch is off by much less than a cent */
+		step = (int)(((double)src_rate * RESAMPLE_MAXPHASES) /
+		             dst_rate + 0.5);
+		phases = RESAMPLE_MAXPHASES;
+		gcd = SDL_ResampleGCD(phases, step);
+		phases /= gcd;
+		step /= gcd;
+	}
+	return(SDL_LoadResampleTable(step, phases, quality));
+}
+
+/* Build the table for a CVT again after SDL_QuitResampler(), working out
+   the ratio from cvt->rate_incr.  Its terms have no common factor, so the
+   first number of phases that gives the same increment is the one. */
+static SDL_ResampleTable *SDL_RebuildResampleTable(double incr, int quality)
+{
+	int phases, step;
+
+	for ( phases = 1; phases <= RESAMPLE_MAXPHASES; ++phases ) {
+		step = (int)(incr * phases + 0.5);
+		if ( (step > 0) && ((double)step / phases == incr) ) {
+			return(SDL_LoadResampleTable(step, phases, quality));
+		}
+	}
+	SDL_SetError("Invalid audio rate conversion");
+	return(NULL);
+}
+
+/* Load a sample as native signed 16-bit */
+static __inline__ Sint16 SDL_ResampleLoad(const Uint8 *src, int size,
+                                          int big, int flip)
+{
+	if ( size == 1 ) {
+		return (Sint16)(((src[0] << 8) ^ flip) & 0xFFFF);
+	} else if ( big ) {
+		return (Sint16)((((src[0] << 8) | src[1]) ^ flip) & 0xFFFF);
+	} else {
+		return (Sint16)((((src[1] << 8) | src[0]) ^ flip) & 0xFFFF);
+	}
+}
+
+/* Filter one output frame from the window of input frames around it */
+static __inline__ Uint8 *SDL_ResampleFrame(Uint8 *dst, const Sint16 *coeffs,
+                                           const Sint16 *window, int taps,
+                                           int chans, int size, int big,
+                                           int flip)
+{
+	Sint32 sample;
+	int c, k;
+
+	for ( c = 0; c < chans; ++c ) {
+		sample = 1 << (RESAMPLE_SHIFT - 1);
+		for ( k = 0; k < taps; ++k ) {
+			sample += (Sint32)coeffs[k] * window[k * chans + c];
+		}
+		sample >>= RESAMPLE_SHIFT;
+		if ( sample > 32767 ) {
+			sample = 32767;
+		} else if ( sample < -32768 ) {
+			sample = -32768;
+		}
+		sample = (sample ^ flip) & 0xFFFF;
+		if ( size == 1 ) {
+			*dst++ = (Uint8)(sample >> 8);
+		} else if ( big ) {
+			*dst++ = (Uint8)(sample >> 8);
+			*dst++ = (Uint8)(sample & 0xFF);
+		} else {
+			*dst++ = (Uint8)(sample & 0xFF);
+			*dst++ = (Uint8)(sample >> 8);
+		}
+	}
+	return(dst);
+}
+
+static __inline__ void SDL_Resample(SDL_AudioCVT *cvt, Uint16 format,
+                                    const int chans, int quality)
+{
+	const int size = (format & 0xFF) / 8;
+	const int big = ((format & 0x1000) == 0x1000);
+	const int flip = ((format & 0x8000) == 0) ? 0x8000 : 0;
+	SDL_ResampleTable *table;
+	Sint16 *in, *window;
+	Uint8 *src, *dst;
+	Sint16 edge[RESAMPLE_MAXTAPS * 6];
+	int in_frames, out_frames, out_bytes, work_bytes, capacity;
+	int half, taps, i, j, k, c, n, p, first;
+
+	table = SDL_FindResampleTable(cvt->rate_incr, quality);
+	if ( table == NULL ) {
+		table = SDL_RebuildResampleTable(cvt->rate_incr, quality);
+		if ( table == NULL ) {
+			/* SDL_ConvertAudio() returns the error */
+			cvt->len_cvt = -1;
+			return;
+		}
+	}
+	taps = table->taps;
+	half = taps / 2;
+	in_frames = cvt->len_cvt / (size * chans);
+	if ( in_frames == 0 ) {
+		goto done;
+	}
+	out_frames = (in_frames / table->step) * table->phases +
+	             ((in_frames % table->step) * table->phases +
+	              table->step - 1) / table->step;
+	out_bytes = out_frames * size * chans;
+	work_bytes = in_frames * chans * sizeof(Sint16);
+
+	/* Unpack the input to native signed 16-bit at the end of the buffer,
+	   working backwards so it can overlap the packed input. */
+	capacity = cvt->len * cvt->len_mult;
+	if ( capacity < out_bytes + work_bytes + 1 ) {
+		SDL_SetError("Audio buffer is smaller than len*len_mult");
+		cvt->len_cvt = -1;
+		return;
+	}
+	in = (Sint16 *)(cvt->buf + ((capacity - work_bytes) & ~1));
+	src = cvt->buf + in_frames * chans * size;
+	for ( i = in_frames * chans - 1; i >= 0; --i ) {
+		src -= size;
+		in[i] = SDL_ResampleLoad(src, size, big, flip);
+	}
+
+	/* Produce the output from the start of the buffer */
+	dst = cvt->buf;
+	i = 0;
+	p = 0;
+	for ( n = 0; n < out_frames; ++n ) {
+		first = i - half + 1;
+		if ( (first >= 0) && (first + taps <= in_frames) ) {
+			window = &in[first * chans];
+		} else {
+			/* Hold the edge frames beyond the ends of the buffer */
+			for ( k = 0; k < taps; ++k ) {
+				j = first + k;
+				if ( j < 0 ) {
+					j = 0;
+				} else if ( j >= in_frames ) {
+					j = in_frames - 1;
+				}
+				for ( c = 0; c < chans; ++c ) {
+					edge[k * chans + c] = in[j * chans + c];
+				}
+			}
+			window = edge;
+		}
+		dst = SDL_ResampleFrame(dst, &table->coeffs[p * taps], window,
+		                        taps, chans, size, big, flip);
+		p += table->step;
+		while ( p >= table->phases ) {
+			p -= table->phases;
+			++i;
+		}
+	}
+	cvt->len_cvt = out_bytes;
+
+done:
+	if ( cvt->filters[++cvt->filter_index] ) {
+		cvt->filters[cvt->filter_index](cvt, format);
+	}
+}
+
+#define RESAMPLE_FILTER(quality, chans)					\
+static void SDLCALL SDL_Resample_q##quality##_c##chans(SDL_AudioCVT *cvt,	\
+                                                 Uint16 format)		\
+{									\
+	SDL_Resample(cvt, format, chans, quality);			\
+}
+RESAMPLE_FILTER(0, 1)
+RESAMPLE_FILTER(0, 2)
+RESAMPLE_FILTER(0, 4)
+RESAMPLE_FILTER(0, 6)
+RESAMPLE_FILTER(1, 1)
+RESAMPLE_FILTER(1, 2)
+RESAMPLE_FILTER(1, 4)
+RESAMPLE_FILTER(1, 6)
+RESAMPLE_FILTER(2, 1)
+RESAMPLE_FILTER(2, 2)
+RESAMPLE_FILTER(2, 4)
+RESAMPLE_FILTER(2, 6)
+#undef RESAMPLE_FILTER
+
+static void (SDLCALL *SDL_resample_filters[3][4])(SDL_AudioCVT *, Uint16) = {
+	{ SDL_Resample_q0_c1, SDL_Resample_q0_c2,
+	  SDL_Resample_q0_c4, SDL_Resample_q0_c6 },
+	{ SDL_Resample_q1_c1, SDL_Resample_q1_c2,
+	  SDL_Resample_q1_c4, SDL_Resample_q1_c6 },
+	{ SDL_Resample_q2_c1, SDL_Resample_q2_c2,
+	  SDL_Resample_q2_c4, SDL_Resample_q2_c6 }
+};
+
+/* Add a resampling filter from src_rate to dst_rate, or return -1 */
+static int SDL_AddResampler(SDL_AudioCVT *cvt, int channels,
+                            int src_rate, int dst_rate, int quality)
+{
+	SDL_ResampleTable *table;
+	int index, grow;
+
+	switch (channels) {
+		case 1: index = 0; break;
+		case 2: index = 1; break;
+		case 4: index = 2; break;
+		case 6: index = 3; break;
+		default: return -1;
+	}
+	table = SDL_GetResampleTable(src_rate, dst_rate, quality);
+	if ( table == NULL ) {
+		return -1;
+	}
+	cvt->rate_incr = table->incr;
+	cvt->filters[cvt->filter_index++] = SDL_resample_filters[quality][index];
+
+	/* Room for the output, a 16-bit copy of the input and a spare frame */
+	grow = (table->phases + table->step - 1) / table->step;
+	cvt->len_mult *= grow + 3;
+	cvt->len_ratio *= (double)table->phases / table->step;
+	return 0;
+}
+
+/* Rate conversion that carries on from one buffer to the next.
+
+   The input is kept as native 16-bit frames.  The frame the next output
+   is centered on is always preceded by the half-1 frames of history the
+   filter needs, and the phase is kept between calls, so the output is
+   the same as resampling the whole stream at once.  The stream starts
+   with silent history, and input is only taken once all the output it
+   allows has been read, so the buffer never holds more than a filter's
+   length on top of the largest piece of input.
+*/
+struct SDL_AudioResampler {
+	SDL_ResampleTable *table;
+	int chans;
+	int size;
+	int big;
+	int flip;
+	Sint16 *in;
+	int room;		/* Frames 'in' can hold */
+	int have;		/* Frames in 'in' */
+	int pos;		/* Frame the next output frame is centered on */
+	int phase;
+};
+
+SDL_AudioResampler *SDL_CreateResampler(Uint16 format, int channels,
+                                        int src_rate, int dst_rate,
+                                        int max_frames)
+{
+	SDL_AudioResampler *resampler;
+	SDL_ResampleTable *table;
+
+	table = SDL_GetResampleTable(src_rate, dst_rate,
+	                             SDL_ResampleQuality());
+	if ( table == NULL ) {
+		return(NULL);
+	}
+	resampler = (SDL_AudioResampler *)SDL_malloc(sizeof(*resampler));
+	if ( resampler == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	resampler->table = table;
+	resampler->chans = channels;
+	resampler->size = (format & 0xFF) / 8;
+	resampler->big = ((format & 0x1000) == 0x1000);
+	resampler->flip = ((format & 0x8000) == 0) ? 0x8000 : 0;
+	resampler->room = max_frames + table->taps;
+	resampler->in = (Sint16 *)SDL_malloc(resampler->room * channels *
+	                                     sizeof(Sint16));
+	if ( resampler->in == NULL ) {
+		SDL_free(resampler);
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_ResetResampler(resampler);
+	return(resampler);
+}
+
+void SDL_ResetResampler(SDL_AudioResampler *resampler)
+{
+	const int history = resampler->table->taps / 2 - 1;
+
+	SDL_memset(resampler->in, 0,
+	           history * resampler->chans * sizeof(Sint16));
+	resampler->have = history;
+	resampler->pos = history;
+	resampler->phase = 0;
+}
+
+int SDL_FeedResampler(SDL_AudioResampler *resampler, const Uint8 *buf, int len)
+{
+	const int frame = resampler->size * resampler->chans;
+	const int chans = resampler->chans;
+	int first, frames, skip, i;
+	Sint16 *in;
+
+	/* Drop the frames the filter has moved past.  When downsampling it
+	   may have moved past the end, and some of the new frames go too. */
+	first = resampler->pos - resampler->table->taps / 2 + 1;
+	if ( first > resampler->have ) {
+		first = resampler->have;
+	}
+	if ( first > 0 ) {
+		resampler->have -= first;
+		SDL_memmove(resampler->in, resampler->in + first * chans,
+		            resampler->have * chans * sizeof(Sint16));
+		resampler->pos -= first;
+	}
+	frames = len / frame;
+	skip = resampler->pos - resampler->table->taps / 2 + 1;
+	if ( skip > frames ) {
+		skip = frames;
+	}
+	if ( skip > 0 ) {
+		buf += skip * frame;
+		frames -= skip;
+		resampler->pos -= skip;
+	} else {
+		skip = 0;
+	}
+
+	if ( frames > resampler->room - resampler->have ) {
+		frames = resampler->room - resampler->have;
+	}
+	in = resampler->in + resampler->have * chans;
+	for ( i = frames * chans; i; --i ) {
+		*in++ = SDL_ResampleLoad(buf, resampler->size,
+		                         resampler->big, resampler->flip);
+		buf += resampler->size;
+	}
+	resampler->have += frames;
+	return((skip + frames) * frame);
+}
+
+int SDL_ReadResampler(SDL_AudioResampler *resampler, Uint8 *buf, int len)
+{
+	const SDL_ResampleTable *table = resampler->table;
+	const int chans = resampler->chans;
+	const int half = table->taps / 2;
+	Uint8 *dst = buf;
+	int frames, pos, phase;
+
+	pos = resampler->pos;
+	phase = resampler->phase;
+	for ( frames = len / (resampler->size * chans); frames; --frames ) {
+		if ( pos + half >= resampler->have ) {
+			break;
+		}
+		dst = SDL_ResampleFrame(dst, &table->coeffs[phase * table->taps],
+		                        &resampler->in[(pos - half + 1) * chans],
+		                        table->taps, chans, resampler->size,
+		                        resampler->big, resampler->flip);
+		phase += table->step;
+		while ( phase >= table->phases ) {
+			phase -= table->phases;
+			++pos;
+		}
+	}
+	resampler->pos = pos;
+	resampler->phase = phase;
+	return(dst - buf);
+}
+
+void SDL_FreeResampler(SDL_AudioResampler *resampler)
+{
+	if ( resampler ) {
+		SDL_free(resampler->in);
+		SDL_free(resampler);
+	}
+}
+
+/* Single pass conversion for the common cases.
+
+   Most streams are mono or stereo, and going through the filters above
+   one at a time touches the whole buffer once for every step:  a U8 mono
+   11 kHz stream played on an S16LSB stereo device with quality 0 takes
+   sign, width, stereo and two rate doubling passes.  The filters below do
+   the format, channel and power of two rate work for each frame in one
+   go, and give the same output as the separate filters.
+
+   A sample is loaded in its source width and endianness, gets its sign
+   bit flipped if the signedness differs, and is shifted to the
+   destination width.  Stereo to mono mixes in the destination format, as
+   SDL_ConvertMono() does.  Each source frame is then written rate times,
+   or every rate'th source frame is used when the rate goes down.
+
+   SDL_AudioCVT has no room to say which conversion is wanted, so there
+   is a filter for each channel layout and rate shift, and each of those
+   has a loop for each pair of sample types.
+*/
+#define FUSED_U8	0
+#define FUSED_LSB	1
+#define FUSED_MSB	2
+#define FUSED_MAXSHIFT	3
+
+static __inline__ int SDL_FusedType(Uint16 format)
+{
+	if ( (format & 0xFF) == 8 ) {
+		return FUSED_U8;
+	}
+	if ( (format & 0x1000) == 0x1000 ) {
+		return FUSED_MSB;
+	}
+	return FUSED_LSB;
+}
+
+#define FUSED_LOAD(type, src) \
+	((type == FUSED_U8) ? (Uint32)(src)[0] : \
+	 (type == FUSED_LSB) ? (Uint32)((src)[0] | ((src)[1] << 8)) : \
+	                       (Uint32)(((src)[0] << 8) | (src)[1]))
+
+#define FUSED_STORE(type, dst, x) \
+	if ( type == FUSED_U8 ) { \
+		(dst)[0] = (Uint8)(x); \
+	} else if ( type == FUSED_LSB ) { \
+		(dst)[0] = (Uint8)((x) & 0xFF); \
+		(dst)[1] = (Uint8)((x) >> 8); \
+	} else { \
+		(dst)[0] = (Uint8)((x) >> 8); \
+		(dst)[1] = (Uint8)((x) & 0xFF); \
+	}
+
+static __inline__ void SDL_ConvertFused(SDL_AudioCVT *cvt, Uint16 format,
+                                        const int src_type,
+                                        const int dst_type,
+                                        const int src_chans,
+                                        const int dst_chans, int shift)
+{
+	const int src_size = (src_type == FUSED_U8) ? 1 : 2;
+	const int dst_size = (dst_type == FUSED_U8) ? 1 : 2;
+	const Uint16 dst_format = cvt->dst_format;
+	const int is_signed = ((dst_format & 0x8000) == 0x8000);
+	Uint32 flip, left, right;
+	Sint32 sample;
+	Uint8 *src, *dst;
+	int in_unit, out_unit, units, rate, i, k;
+
+	flip = 0;
+	if ( (format & 0x8000) != (dst_format & 0x8000) ) {
+		flip = (src_size == 1) ? 0x80 : 0x8000;
+	}
+
+	/* Each unit reads one source frame and writes rate frames */
+	if ( shift < 0 ) {
+		rate = 1;
+		in_unit = (1 << -shift) * src_chans * src_size;
+	} else {
+		rate = (1 << shift);
+		in_unit = src_chans * src_size;
+	}
+	out_unit = rate * dst_chans * dst_size;
+	units = cvt->len_cvt / in_unit;
+
+	/* Work backwards if the data grows, so it can be done in place */
+	src = cvt->buf;
+	dst = cvt->buf;
+	if ( (out_unit > in_unit) && units ) {
+		src += (units - 1) * in_unit;
+		dst += (units - 1) * out_unit;
+		in_unit = -in_unit;
+		out_unit = -out_unit;
+	}
+	for ( i=units; i; --i ) {
+		left = FUSED_LOAD(src_type, src) ^ flip;
+		if ( src_chans == 2 ) {
+			right = FUSED_LOAD(src_type, src + src_size) ^ flip;
+		} else {
+			right = left;
+		}
+		if ( src_size < dst_size ) {
+			left <<= 8;
+			right <<= 8;
+		} else if ( src_size > dst_size ) {
+			left >>= 8;
+			right >>= 8;
+		}
+		if ( (src_chans == 2) && (dst_chans == 1) ) {
+			if ( !is_signed ) {
+				left = (left + right) / 2;
+			} else if ( dst_size == 1 ) {
+				sample = (Sint8)left + (Sint8)right;
+				left = (Uint32)(sample / 2) & 0xFF;
+			} else {
+				sample = (Sint16)left + (Sint16)right;
+				left = (Uint32)(sample / 2) & 0xFFFF;
+			}
+		}
+		FUSED_STORE(dst_type, dst, left);
+		if ( dst_chans == 2 ) {
+			FUSED_STORE(dst_type, dst + dst_size, right);
+		}
+		for ( k=1; k < rate; ++k ) {
+			FUSED_STORE(dst_type, dst + k*dst_chans*dst_size, left);
+			if ( dst_chans == 2 ) {
+				FUSED_STORE(dst_type,
+				            dst + (k*2+1)*dst_size, right);
+			}
+		}
+		src += in_unit;
+		dst += out_unit;
+	}
+	if ( out_unit < 0 ) {
+		out_unit = -out_unit;
+	}
+	cvt->len_cvt = units * out_unit;
+}
+
+#define FUSED_CHANNELS(src_chans, dst_chans)				\
+static void SDL_ConvertFused_c##src_chans##dst_chans(SDL_AudioCVT *cvt,	\
+                                        Uint16 format, int shift)	\
+{									\
+	switch (SDL_FusedType(format) * 3 +				\
+	        SDL_FusedType(cvt->dst_format)) {			\
+		case FUSED_U8*3 + FUSED_U8:				\
+			SDL_ConvertFused(cvt, format, FUSED_U8, FUSED_U8,	\
+			                 src_chans, dst_chans, shift);	\
+			break;						\
+		case FUSED_U8*3 + FUSED_LSB:				\
+			SDL_ConvertFused(cvt, format, FUSED_U8, FUSED_LSB,	\
+			                 src_chans, dst_chans, shift);	\
+			break;						\
+		case FUSED_U8*3 + FUSED_MSB:				\
+			SDL_ConvertFused(cvt, format, FUSED_U8, FUSED_MSB,	\
+			                 src_chans, dst_chans, shift);	\
+			break;						\
+		case FUSED_LSB*3 + FUSED_U8:				\
+			SDL_ConvertFused(cvt, format, FUSED_LSB, FUSED_U8,	\
+			                 src_chans, dst_chans, shift);	\
+			break;						\
+		case FUSED_LSB*3 + FUSED_LSB:				\
+			SDL_ConvertFused(cvt, format, FUSED_LSB, FUSED_LSB,	\
+			                 src_chans, dst_chans, shift);	\
+			break;						\
+		case FUSED_LSB*3 + FUSED_MSB:				\
+			SDL_ConvertFused(cvt, format, FUSED_LSB, FUSED_MSB,	\
+			                 src_chans, dst_chans, shift);	\
+			break;						\
+		case FUSED_MSB*3 + FUSED_U8:				\
+			SDL_ConvertFused(cvt, format, FUSED_MSB, FUSED_U8,	\
+			                 src_chans, dst_chans, shift);	\
+			break;						\
+		case FUSED_MSB*3 + FUSED_LSB:				\
+			SDL_ConvertFused(cvt, format, FUSED_MSB, FUSED_LSB,	\
+			                 src_chans, dst_chans, shift);	\
+			break;						\
+		case FUSED_MSB*3 + FUSED_MSB:				\
+			SDL_ConvertFused(cvt, format, FUSED_MSB, FUSED_MSB,	\
+			                 src_chans, dst_chans, shift);	\
+			break;						\
+	}								\
+}
+FUSED_CHANNELS(1, 1)
+FUSED_CHANNELS(1, 2)
+FUSED_CHANNELS(2, 1)
+FUSED_CHANNELS(2, 2)
+#undef FUSED_CHANNELS
+
+#define FUSED_FILTER(src_chans, dst_chans, name, shift)			\
+static void SDLCALL SDL_ConvertFused_c##src_chans##dst_chans##_##name(	\
+                                   SDL_AudioCVT *cvt, Uint16 format)	\
+{									\
+	SDL_ConvertFused_c##src_chans##dst_chans(cvt, format, shift);	\
+	format = cvt->dst_format;					\
+	if ( cvt->filters[++cvt->filter_index] ) {			\
+		cvt->filters[cvt->filter_index](cvt, format);		\
+	}								\
+}
+#define FUSED_FILTERS(src_chans, dst_chans)				\
+	FUSED_FILTER(src_chans, dst_chans, div8, -3)			\
+	FUSED_FILTER(src_chans, dst_chans, div4, -2)			\
+	FUSED_FILTER(src_chans, dst_chans, div2, -1)			\
+	FUSED_FILTER(src_chans, dst_chans, mul1, 0)			\
+	FUSED_FILTER(src_chans, dst_chans, mul2, 1)			\
+	FUSED_FILTER(src_chans, dst_chans, mul4, 2)			\
+	FUSED_FILTER(src_chans, dst_chans, mul8, 3)
+FUSED_FILTERS(1, 1)
+FUSED_FILTERS(1, 2)
+FUSED_FILTERS(2, 1)
+FUSED_FILTERS(2, 2)
+#undef FUSED_FILTERS
+#undef FUSED_FILTER
+
+#define FUSED_ROW(src_chans, dst_chans) {				\
+	SDL_ConvertFused_c##src_chans##dst_chans##_div8,		\
+	SDL_ConvertFused_c##src_chans##dst_chans##_div4,		\
+	SDL_ConvertFused_c##src_chans##dst_chans##_div2,		\
+	SDL_ConvertFused_c##src_chans##dst_chans##_mul1,		\
+	SDL_ConvertFused_c##src_chans##dst_chans##_mul2,		\
+	SDL_ConvertFused_c##src_chans##dst_chans##_mul4,		\
+	SDL_ConvertFused_c##src_chans##dst_chans##_mul8 }
+static void (SDLCALL *SDL_fused_filters[4][2*FUSED_MAXSHIFT+1])(SDL_AudioCVT *, Uint16) = {
+	FUSED_ROW(1, 1), FUSED_ROW(1, 2), FUSED_ROW(2, 1), FUSED_ROW(2, 2)
+};
+#undef FUSED_ROW
+
+/* Set up a single pass conversion for mono and stereo streams.
+   Returns 1 if it did, 0 if the separate filters should be used, or -1
+   if the resampler couldn't be set up.
+*/
+static int SDL_BuildFusedCVT(SDL_AudioCVT *cvt,
+	Uint16 src_format, Uint8 src_channels, int src_rate,
+	Uint16 dst_format, Uint8 dst_channels, int dst_rate, int quality)
+{
+	const char *hint;
+	int src_size, dst_size;
+	int passes, shift, resample_first;
+	Uint32 hi_rate, lo_rate;
+
+	/* SDL_AUDIO_FUSED=0 uses the separate filters, for comparison */
+	hint = SDL_getenv("SDL_AUDIO_FUSED");
+	if ( hint && (SDL_atoi(hint) == 0) ) {
+		return 0;
+	}
+	if ( (src_channels < 1) || (src_channels > 2) ||
+	     (dst_channels < 1) || (dst_channels > 2) ) {
+		return 0;
+	}
+	src_size = (src_format & 0xFF) / 8;
+	dst_size = (dst_format & 0xFF) / 8;
+	if ( (src_size < 1) || (src_size > 2) ||
+	     (dst_size < 1) || (dst_size > 2) ) {
+		return 0;
+	}
+
+	/* Count the passes the separate filters would take */
+	passes = 0;
+	if ( (src_size == 2) && (dst_size == 2) &&
+	     ((src_format & 0x1000) != (dst_format & 0x1000)) ) {
+		++passes;
+	}
+	if ( (src_format & 0x8000) != (dst_format & 0x8000) ) {
+		++passes;
+	}
+	if ( src_size != dst_size ) {
+		++passes;
+	}
+	if ( src_channels != dst_channels ) {
+		++passes;
+	}
+
+	/* Quality 0 doubles or halves the rate first, as below */
+	shift = 0;
+	if ( ((src_rate/100) != (dst_rate/100)) && (quality == 0) ) {
+		if ( src_rate > dst_rate ) {
+			hi_rate = src_rate;
+			lo_rate = dst_rate;
+		} else {
+			hi_rate = dst_rate;
+			lo_rate = src_rate;
+		}
+		while ( ((lo_rate*2)/100) <= (hi_rate/100) ) {
+			lo_rate *= 2;
+			++shift;
+		}
+		if ( shift > FUSED_MAXSHIFT ) {
+			return 0;
+		}
+		if ( src_rate > dst_rate ) {
+			shift = -shift;
+			src_rate = hi_rate;
+			dst_rate = lo_rate;
+		} else {
+			src_rate = lo_rate;
+			dst_rate = hi_rate;
+		}
+		passes += (shift < 0) ? -shift : shift;
+	}
+
+	/* Resample before adding channels, it's cheaper on fewer of them,
+	   but don't resample a narrower format than the output. */
+	resample_first = ( (src_rate/100) != (dst_rate/100) &&
+	                   (shift == 0) && (src_channels < dst_channels) &&
+	                   (src_size >= dst_size) );
+	if ( (passes < 2) && !resample_first ) {
+		return 0;
+	}
+	if ( resample_first ) {
+		if ( SDL_AddResampler(cvt, src_channels,
+		                      src_rate, dst_rate, quality) < 0 ) {
+			return -1;
+		}
+	}
+	cvt->filters[cvt->filter_index++] =
+		SDL_fused_filters[(src_channels-1)*2 + (dst_channels-1)]
+		                 [shift + FUSED_MAXSHIFT];
+	if ( dst_size > src_size ) {
+		cvt->len_mult *= 2;
+	}
+	if ( dst_channels > src_channels ) {
+		cvt->len_mult *= 2;
+	}
+	cvt->len_ratio *= (double)(dst_size * dst_channels) /
+	                  (src_size * src_channels);
+	if ( shift > 0 ) {
+		cvt->len_mult <<= shift;
+		cvt->len_ratio *= (double)(1 << shift);
+	} else if ( shift < 0 ) {
+		cvt->len_ratio /= (double)(1 << -shift);
+	}
+	if ( !resample_first && ((src_rate/100) != (dst_rate/100)) ) {
+		if ( SDL_AddResampler(cvt, dst_channels,
+		                      src_rate, dst_rate, quality) < 0 ) {
+			return -1;
+		}
+	}
+	return 1;
+}
+
 int SDL_ConvertAudio(SDL_AudioCVT *cvt)
 {
 	/* Make sure there's data to convert */
@@ -1316,6 +2370,12 @@ int SDL_ConvertAudio(SDL_AudioCVT *cvt)
 	/* Set up the conversion and go! */
 	cvt->filter_index = 0;
 	cvt->filters[0](cvt, cvt->src_format);
+
+	/* A filter that fails stops the chain and sets len_cvt to -1 */
+	if ( cvt->len_cvt < 0 ) {
+		cvt->len_cvt = 0;
+		return(-1);
+	}
 	return(0);
 }
 
@@ -1328,6 +2388,8 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 	Uint16 src_format, Uint8 src_channels, int src_rate,
 	Uint16 dst_format, Uint8 dst_channels, int dst_rate)
 {
+	int quality;
+
 /*printf("Build format %04x->%04x, channels %u->%u, rate %d->%d\n",
 		src_format, dst_format, src_channels, dst_channels, src_rate, dst_rate);*/
 	/* Start off with no conversion necessary */
@@ -1337,6 +2399,17 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 	cvt->len_mult = 1;
 	cvt->len_ratio = 1.0;
 
+	quality = SDL_ResampleQuality();
+
+	/* Do the common conversions in a single pass if we can */
+	switch (SDL_BuildFusedCVT(cvt, src_format, src_channels, src_rate,
+	                          dst_format, dst_channels, dst_rate, quality)) {
+		case -1:
+			return -1;
+		case 1:
+			goto filters_done;
+	}
+
 	/* First filter:  Endian conversion from src to dst */
 	if ( (src_format & 0x1000) != (dst_format & 0x1000)
 	     && ((src_format & 0xff) == 16) && ((dst_format & 0xff) == 16)) {
@@ -1441,6 +2514,14 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 		double len_ratio;
 		void (SDLCALL *rate_cvt)(SDL_AudioCVT *cvt, Uint16 format);
 
+		if ( quality > 0 ) {
+			if ( SDL_AddResampler(cvt, src_channels,
+			                      src_rate, dst_rate, quality) < 0 ) {
+				return -1;
+			}
+			goto filters_done;
+		}
+
 		if ( src_rate > dst_rate ) {
 			hi_rate = src_rate;
 			lo_rate = dst_rate;
@@ -1473,29 +2554,21 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 			lo_rate *= 2;
 			cvt->len_ratio *= len_ratio;
 		}
-		/* We may need a slow conversion here to finish up */
+		/* Interpolate the rest of the way */
 		if ( (lo_rate/100) != (hi_rate/100) ) {
-#if 1
-			/* The problem with this is that if the input buffer is
-			   say 1K, and the conversion rate is say 1.1, then the
-			   output buffer is 1.1K, which may not be an acceptable
-			   buffer size for the audio driver (not a power of 2)
-			*/
-			/* For now, punt and hope the rate distortion isn't great.
-			*/
-#else
 			if ( src_rate < dst_rate ) {
-				cvt->rate_incr = (double)lo_rate/hi_rate;
-				cvt->len_mult *= 2;
-				cvt->len_ratio /= cvt->rate_incr;
+				src_rate = lo_rate;
 			} else {
-				cvt->rate_incr = (double)hi_rate/lo_rate;
-				cvt->len_ratio *= cvt->rate_incr;
+				dst_rate = lo_rate;
+				src_rate = hi_rate;
+			}
+			if ( SDL_AddResampler(cvt, src_channels,
+			                      src_rate, dst_rate, 0) < 0 ) {
+				return -1;
 			}
-			cvt->filters[cvt->filter_index++] = SDL_RateSLOW;
-#endif
 		}
 	}
+filters_done:
 
 	/* Set up the filter information */
 	if ( cvt->filter_index != 0 ) {
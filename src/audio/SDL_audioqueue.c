@@ -0,0 +1,215 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Push audio to the device instead of supplying a callback.
+
+   When SDL_OpenAudio() is given no callback, the audio thread drains a
+   single-producer, single-consumer ring buffer which the application
+   fills with SDL_QueueAudio().  Neither side ever takes the mixer lock.
+   The write and read positions run freely and are only masked when the
+   buffer is indexed, so 'write - read' is always the queued byte count.
+   Each position is written by one thread only, and a memory barrier
+   separates the copying of the data from publishing the new position.
+*/
+
+#include "SDL_audio.h"
+#include "SDL_thread.h"
+#include "SDL_sysaudio.h"
+#include "SDL_audio_c.h"
+#include "../thread/SDL_barrier.h"
+
+/* Default queue length, in callback buffers */
+#define QUEUE_BUFFERS	8
+
+static struct {
+	Uint8 *buf;
+	Uint32 size;			/* Always a power of two */
+	Uint32 frame;			/* Bytes per sample frame */
+	volatile Uint32 write;		/* Only changed by the application */
+	volatile Uint32 read;		/* Only changed by the audio thread */
+	volatile Uint32 clear_to;	/* Where to skip to on a clear request */
+	volatile Uint32 clear_request;	/* Bumped by SDL_ClearQueuedAudio() */
+	Uint32 clear_done;		/* Last request seen by the audio thread */
+	volatile Uint32 underruns;
+	int starved;
+#ifndef SDL_MemoryBarrier
+	SDL_mutex *lock;
+#endif
+} queue;
+
+#ifdef SDL_MemoryBarrier
+#define QueueBarrier()	SDL_MemoryBarrier()
+#else
+/* Taking and releasing a mutex orders memory just as well, and it is
+   never held for more than that, so neither thread waits on the other.
+*/
+#define QueueBarrier()	{ SDL_mutexP(queue.lock); SDL_mutexV(queue.lock); }
+#endif
+
+int SDL_OpenAudioQueue(const SDL_AudioSpec *spec)
+{
+	const char *env;
+	Uint32 want;
+
+	SDL_memset(&queue, 0, sizeof(queue));
+	queue.frame = (spec->format & 0xFF) / 8 * spec->channels;
+	queue.starved = 1;
+
+	want = spec->size * QUEUE_BUFFERS;
+	env = SDL_getenv("SDL_AUDIO_QUEUE_SIZE");
+	if ( env && SDL_atoi(env) > 0 ) {
+		want = SDL_atoi(env);
+	}
+	for ( queue.size = 1024; queue.size < want; queue.size *= 2 ) {
+		;
+	}
+
+#ifndef SDL_MemoryBarrier
+	queue.lock = SDL_CreateMutex();
+	if ( queue.lock == NULL ) {
+		return(-1);
+	}
+#endif
+	queue.buf = (Uint8 *)SDL_malloc(queue.size);
+	if ( queue.buf == NULL ) {
+		SDL_CloseAudioQueue();
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	return(0);
+}
+
+void SDL_CloseAudioQueue(void)
+{
+#ifndef SDL_MemoryBarrier
+	if ( queue.lock ) {
+		SDL_DestroyMutex(queue.lock);
+	}
+#endif
+	if ( queue.buf ) {
+		SDL_free(queue.buf);
+	}
+	SDL_memset(&queue, 0, sizeof(queue));
+}
+
+void SDLCALL SDL_DrainAudioQueue(void *userdata, Uint8 *stream, int len)
+{
+	Uint32 request, read, amount, pos, part;
+
+	/* Skip everything queued before the last SDL_ClearQueuedAudio().
+	   A previous drain may already have played past that point, and
+	   the application may have refilled the space, so never go back.
+	 */
+	request = queue.clear_request;
+	if ( request != queue.clear_done ) {
+		QueueBarrier();
+		if ( (Sint32)(queue.clear_to - queue.read) > 0 ) {
+			queue.read = queue.clear_to;
+		}
+		queue.clear_done = request;
+	}
+
+	read = queue.read;
+	amount = queue.write - read;
+	QueueBarrier();
+	if ( amount > (Uint32)len ) {
+		amount = len;
+	}
+
+	/* The stream is already silent, so a short read plays out as a gap */
+	pos = read & (queue.size - 1);
+	part = queue.size - pos;
+	if ( part > amount ) {
+		part = amount;
+	}
+	SDL_memcpy(stream, queue.buf + pos, part);
+	SDL_memcpy(stream + part, queue.buf, amount - part);
+
+	QueueBarrier();
+	queue.read = read + amount;
+
+	/* Count each time the application falls behind, not each buffer */
+	if ( amount < (Uint32)len ) {
+		if ( ! queue.starved ) {
+			++queue.underruns;
+			queue.starved = 1;
+		}
+	} else {
+		queue.starved = 0;
+	}
+}
+
+int SDL_QueueAudio(const void *data, Uint32 len)
+{
+	Uint32 write, space, pos, part;
+
+	if ( queue.buf == NULL ) {
+		SDL_SetError("Audio was not opened without a callback");
+		return(-1);
+	}
+
+	write = queue.write;
+	space = queue.size - (write - queue.read);
+	QueueBarrier();
+	if ( len > space ) {
+		len = space;
+	}
+	len -= len % queue.frame;
+
+	pos = write & (queue.size - 1);
+	part = queue.size - pos;
+	if ( part > len ) {
+		part = len;
+	}
+	SDL_memcpy(queue.buf + pos, data, part);
+	SDL_memcpy(queue.buf, (const Uint8 *)data + part, len - part);
+
+	QueueBarrier();
+	queue.write = write + len;
+	return(len);
+}
+
+Uint32 SDL_GetQueuedAudioSize(void)
+{
+	Uint32 write, read;
+
+	write = queue.write;
+	read = queue.read;
+	if ( queue.clear_request != queue.clear_done &&
+	     (Sint32)(queue.clear_to - read) > 0 ) {
+		read = queue.clear_to;
+	}
+	return(write - read);
+}
+
+Uint32 SDL_GetAudioUnderruns(void)
+{
+	return(queue.underruns);
+}
+
+void SDL_ClearQueuedAudio(void)
+{
+	queue.clear_to = queue.write;
+	QueueBarrier();
+	++queue.clear_request;
+}
@@ -30,6 +30,7 @@
 #include "SDL_mixer_MMX.h"
 #include "SDL_mixer_MMX_VC.h"
 #include "SDL_mixer_m68k.h"
+#include "SDL_mixer_simd.h"
 
 /* This table is used to add two sound values together and pin
  * the value to avoid overflow.  (used with permission from ARDI)
@@ -90,6 +91,24 @@ static const Uint8 mix8[] =
 #define ADJUST_VOLUME(s, v)	(s = (s*v)/SDL_MIX_MAXVOLUME)
 #define ADJUST_VOLUME_U8(s, v)	(s = (((s-128)*v)/SDL_MIX_MAXVOLUME)+128)
 
+/* Mix the bulk of the buffer with vector code, leaving the tail to C */
+#if SDL_SSE2_MIXERS || SDL_NEON_MIXERS
+#if SDL_SSE2_MIXERS
+#define HasSIMD()	SDL_HasSSE2()
+#else
+#define HasSIMD()	SDL_HasNEON()
+#endif
+#define MIX_SIMD(name)							\
+	if ( HasSIMD() && (volume <= SDL_MIX_MAXVOLUME) ) {		\
+		Uint32 mixed = name(dst, src, len, volume);		\
+		dst += mixed;						\
+		src += mixed;						\
+		len -= mixed;						\
+	}
+#else
+#define MIX_SIMD(name)
+#endif
+
 void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 {
 	Uint16 format;
@@ -116,6 +135,7 @@ void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 #else
 			Uint8 src_sample;
 
+			MIX_SIMD(SDL_MixAudio_SIMD_U8)
 			while ( len-- ) {
 				src_sample = *src;
 				ADJUST_VOLUME_U8(src_sample, volume);
@@ -154,6 +174,7 @@ void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 			const int max_audioval = ((1<<(8-1))-1);
 			const int min_audioval = -(1<<(8-1));
 
+			MIX_SIMD(SDL_MixAudio_SIMD_S8)
 			src8 = (Sint8 *)src;
 			dst8 = (Sint8 *)dst;
 			while ( len-- ) {
@@ -202,6 +223,7 @@ void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 			const int max_audioval = ((1<<(16-1))-1);
 			const int min_audioval = -(1<<(16-1));
 
+			MIX_SIMD(SDL_MixAudio_SIMD_S16LSB)
 			len /= 2;
 			while ( len-- ) {
 				src1 = ((src[1])<<8|src[0]);
@@ -234,6 +256,7 @@ void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 			const int max_audioval = ((1<<(16-1))-1);
 			const int min_audioval = -(1<<(16-1));
 
+			MIX_SIMD(SDL_MixAudio_SIMD_S16MSB)
 			len /= 2;
 			while ( len-- ) {
 				src1 = ((src[0])<<8|src[1]);
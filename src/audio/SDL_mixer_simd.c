@@ -0,0 +1,363 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* SSE2 and NEON versions of SDL_MixAudio.
+
+   These give exactly the same results as the C mixers in SDL_mixer.c.
+   The volume is applied as a multiply followed by a shift right by 7,
+   with SDL_MIX_MAXVOLUME - 1 added to negative products first so the
+   shift rounds towards zero like the C division does.  The sum is then
+   clamped with a saturating add.  U8 samples are mixed as signed values
+   and limited to 0xFE afterwards, which is what the mix8 table does.
+*/
+
+#include "SDL_audio.h"
+#include "SDL_mixer_simd.h"
+
+#if SDL_SSE2_MIXERS
+#include <emmintrin.h>
+
+/* Scale 16 signed 8-bit samples by volume/SDL_MIX_MAXVOLUME */
+static __inline__ __m128i AdjustVolume8(__m128i s, __m128i vol)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16(SDL_MIX_MAXVOLUME - 1);
+	__m128i lo, hi;
+
+	/* Sign extend to 16 bits, the products fit */
+	lo = _mm_srai_epi16(_mm_unpacklo_epi8(zero, s), 8);
+	hi = _mm_srai_epi16(_mm_unpackhi_epi8(zero, s), 8);
+	lo = _mm_mullo_epi16(lo, vol);
+	hi = _mm_mullo_epi16(hi, vol);
+	lo = _mm_add_epi16(lo, _mm_and_si128(_mm_srai_epi16(lo, 15), bias));
+	hi = _mm_add_epi16(hi, _mm_and_si128(_mm_srai_epi16(hi, 15), bias));
+	lo = _mm_srai_epi16(lo, 7);
+	hi = _mm_srai_epi16(hi, 7);
+	return _mm_packs_epi16(lo, hi);
+}
+
+/* Scale 8 signed 16-bit samples by volume/SDL_MIX_MAXVOLUME */
+static __inline__ __m128i AdjustVolume16(__m128i s, __m128i vol)
+{
+	const __m128i bias = _mm_set1_epi32(SDL_MIX_MAXVOLUME - 1);
+	__m128i plo, phi, lo, hi;
+
+	plo = _mm_mullo_epi16(s, vol);
+	phi = _mm_mulhi_epi16(s, vol);
+	lo = _mm_unpacklo_epi16(plo, phi);
+	hi = _mm_unpackhi_epi16(plo, phi);
+	lo = _mm_add_epi32(lo, _mm_and_si128(_mm_srai_epi32(lo, 31), bias));
+	hi = _mm_add_epi32(hi, _mm_and_si128(_mm_srai_epi32(hi, 31), bias));
+	lo = _mm_srai_epi32(lo, 7);
+	hi = _mm_srai_epi32(hi, 7);
+	return _mm_packs_epi32(lo, hi);
+}
+
+static __inline__ __m128i Swap16(__m128i x)
+{
+	return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+}
+
+Uint32 SDL_MixAudio_SIMD_U8(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const __m128i vol = _mm_set1_epi16((short)volume);
+	const __m128i sign = _mm_set1_epi8((char)0x80);
+	const __m128i max = _mm_set1_epi8((char)0xFE);
+	__m128i s, d;
+	Uint32 i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = _mm_loadu_si128((const __m128i *)(src + i));
+		d = _mm_loadu_si128((const __m128i *)(dst + i));
+		s = AdjustVolume8(_mm_xor_si128(s, sign), vol);
+		d = _mm_adds_epi8(_mm_xor_si128(d, sign), s);
+		d = _mm_min_epu8(_mm_xor_si128(d, sign), max);
+		_mm_storeu_si128((__m128i *)(dst + i), d);
+	}
+	return i;
+}
+
+Uint32 SDL_MixAudio_SIMD_S8(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const __m128i vol = _mm_set1_epi16((short)volume);
+	__m128i s, d;
+	Uint32 i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = _mm_loadu_si128((const __m128i *)(src + i));
+		d = _mm_loadu_si128((const __m128i *)(dst + i));
+		d = _mm_adds_epi8(d, AdjustVolume8(s, vol));
+		_mm_storeu_si128((__m128i *)(dst + i), d);
+	}
+	return i;
+}
+
+Uint32 SDL_MixAudio_SIMD_S16LSB(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const __m128i vol = _mm_set1_epi16((short)volume);
+	__m128i s, d;
+	Uint32 i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = _mm_loadu_si128((const __m128i *)(src + i));
+		d = _mm_loadu_si128((const __m128i *)(dst + i));
+		d = _mm_adds_epi16(d, AdjustVolume16(s, vol));
+		_mm_storeu_si128((__m128i *)(dst + i), d);
+	}
+	return i;
+}
+
+Uint32 SDL_MixAudio_SIMD_S16MSB(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const __m128i vol = _mm_set1_epi16((short)volume);
+	__m128i s, d;
+	Uint32 i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = Swap16(_mm_loadu_si128((const __m128i *)(src + i)));
+		d = Swap16(_mm_loadu_si128((const __m128i *)(dst + i)));
+		d = _mm_adds_epi16(d, AdjustVolume16(s, vol));
+		_mm_storeu_si128((__m128i *)(dst + i), Swap16(d));
+	}
+	return i;
+}
+
+int SDL_MixVoice_SIMD(Sint32 *mix, const Sint16 *data, int count, int left, int right)
+{
+	const __m128i gain = _mm_set_epi16((short)right, (short)left,
+	                                   (short)right, (short)left,
+	                                   (short)right, (short)left,
+	                                   (short)right, (short)left);
+	__m128i s, plo, phi;
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		s = _mm_loadu_si128((const __m128i *)(data + i));
+		plo = _mm_mullo_epi16(s, gain);
+		phi = _mm_mulhi_epi16(s, gain);
+		_mm_storeu_si128((__m128i *)(mix + i), _mm_add_epi32(
+		    _mm_loadu_si128((const __m128i *)(mix + i)),
+		    _mm_unpacklo_epi16(plo, phi)));
+		_mm_storeu_si128((__m128i *)(mix + i + 4), _mm_add_epi32(
+		    _mm_loadu_si128((const __m128i *)(mix + i + 4)),
+		    _mm_unpackhi_epi16(plo, phi)));
+	}
+	return i;
+}
+
+int SDL_MixVoices_SIMD_Load(Sint32 *mix, const Sint16 *stream, int count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i s;
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		s = _mm_loadu_si128((const __m128i *)(stream + i));
+		/* Sign extend and multiply by SDL_MIX_MAXVOLUME at once */
+		_mm_storeu_si128((__m128i *)(mix + i),
+		    _mm_srai_epi32(_mm_unpacklo_epi16(zero, s), 16 - 7));
+		_mm_storeu_si128((__m128i *)(mix + i + 4),
+		    _mm_srai_epi32(_mm_unpackhi_epi16(zero, s), 16 - 7));
+	}
+	return i;
+}
+
+int SDL_MixVoices_SIMD_Store(Sint16 *stream, const Sint32 *mix, int count)
+{
+	const __m128i bias = _mm_set1_epi32(SDL_MIX_MAXVOLUME - 1);
+	__m128i lo, hi;
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		lo = _mm_loadu_si128((const __m128i *)(mix + i));
+		hi = _mm_loadu_si128((const __m128i *)(mix + i + 4));
+		lo = _mm_add_epi32(lo, _mm_and_si128(_mm_srai_epi32(lo, 31), bias));
+		hi = _mm_add_epi32(hi, _mm_and_si128(_mm_srai_epi32(hi, 31), bias));
+		lo = _mm_srai_epi32(lo, 7);
+		hi = _mm_srai_epi32(hi, 7);
+		_mm_storeu_si128((__m128i *)(stream + i), _mm_packs_epi32(lo, hi));
+	}
+	return i;
+}
+
+#elif SDL_NEON_MIXERS
+#include <arm_neon.h>
+
+/* Scale 16 signed 8-bit samples by volume/SDL_MIX_MAXVOLUME */
+static __inline__ int8x16_t AdjustVolume8(int8x16_t s, int8x8_t vol)
+{
+	const int16x8_t bias = vdupq_n_s16(SDL_MIX_MAXVOLUME - 1);
+	int16x8_t lo, hi;
+
+	lo = vmull_s8(vget_low_s8(s), vol);
+	hi = vmull_s8(vget_high_s8(s), vol);
+	lo = vaddq_s16(lo, vandq_s16(vshrq_n_s16(lo, 15), bias));
+	hi = vaddq_s16(hi, vandq_s16(vshrq_n_s16(hi, 15), bias));
+	return vcombine_s8(vshrn_n_s16(lo, 7), vshrn_n_s16(hi, 7));
+}
+
+/* Scale 8 signed 16-bit samples by volume/SDL_MIX_MAXVOLUME */
+static __inline__ int16x8_t AdjustVolume16(int16x8_t s, int16x4_t vol)
+{
+	const int32x4_t bias = vdupq_n_s32(SDL_MIX_MAXVOLUME - 1);
+	int32x4_t lo, hi;
+
+	lo = vmull_s16(vget_low_s16(s), vol);
+	hi = vmull_s16(vget_high_s16(s), vol);
+	lo = vaddq_s32(lo, vandq_s32(vshrq_n_s32(lo, 31), bias));
+	hi = vaddq_s32(hi, vandq_s32(vshrq_n_s32(hi, 31), bias));
+	return vcombine_s16(vshrn_n_s32(lo, 7), vshrn_n_s32(hi, 7));
+}
+
+Uint32 SDL_MixAudio_SIMD_U8(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const int8x8_t vol = vdup_n_s8((Sint8)volume);
+	const uint8x16_t sign = vdupq_n_u8(0x80);
+	const uint8x16_t max = vdupq_n_u8(0xFE);
+	int8x16_t s, d;
+	Uint32 i;
+
+	if ( volume == SDL_MIX_MAXVOLUME ) {
+		/* The volume doesn't fit in a signed byte, but is a no-op */
+		for ( i = 0; i + 16 <= len; i += 16 ) {
+			s = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(src + i), sign));
+			d = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(dst + i), sign));
+			d = vqaddq_s8(d, s);
+			vst1q_u8(dst + i, vminq_u8(veorq_u8(
+			         vreinterpretq_u8_s8(d), sign), max));
+		}
+		return i;
+	}
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(src + i), sign));
+		d = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(dst + i), sign));
+		d = vqaddq_s8(d, AdjustVolume8(s, vol));
+		vst1q_u8(dst + i, vminq_u8(veorq_u8(
+		         vreinterpretq_u8_s8(d), sign), max));
+	}
+	return i;
+}
+
+Uint32 SDL_MixAudio_SIMD_S8(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const int8x8_t vol = vdup_n_s8((Sint8)volume);
+	int8x16_t s, d;
+	Uint32 i;
+
+	if ( volume == SDL_MIX_MAXVOLUME ) {
+		/* The volume doesn't fit in a signed byte, but is a no-op */
+		for ( i = 0; i + 16 <= len; i += 16 ) {
+			s = vld1q_s8((const Sint8 *)(src + i));
+			d = vld1q_s8((const Sint8 *)(dst + i));
+			vst1q_s8((Sint8 *)(dst + i), vqaddq_s8(d, s));
+		}
+		return i;
+	}
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = vld1q_s8((const Sint8 *)(src + i));
+		d = vld1q_s8((const Sint8 *)(dst + i));
+		d = vqaddq_s8(d, AdjustVolume8(s, vol));
+		vst1q_s8((Sint8 *)(dst + i), d);
+	}
+	return i;
+}
+
+Uint32 SDL_MixAudio_SIMD_S16LSB(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const int16x4_t vol = vdup_n_s16((Sint16)volume);
+	int16x8_t s, d;
+	Uint32 i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = vreinterpretq_s16_u8(vld1q_u8(src + i));
+		d = vreinterpretq_s16_u8(vld1q_u8(dst + i));
+		d = vqaddq_s16(d, AdjustVolume16(s, vol));
+		vst1q_u8(dst + i, vreinterpretq_u8_s16(d));
+	}
+	return i;
+}
+
+Uint32 SDL_MixAudio_SIMD_S16MSB(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const int16x4_t vol = vdup_n_s16((Sint16)volume);
+	int16x8_t s, d;
+	Uint32 i;
+
+	for ( i = 0; i + 16 <= len; i += 16 ) {
+		s = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(src + i)));
+		d = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(dst + i)));
+		d = vqaddq_s16(d, AdjustVolume16(s, vol));
+		vst1q_u8(dst + i, vrev16q_u8(vreinterpretq_u8_s16(d)));
+	}
+	return i;
+}
+
+int SDL_MixVoice_SIMD(Sint32 *mix, const Sint16 *data, int count, int left, int right)
+{
+	const Sint16 pair[4] = { (Sint16)left, (Sint16)right,
+	                         (Sint16)left, (Sint16)right };
+	const int16x4_t gain = vld1_s16(pair);
+	int16x8_t s;
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		s = vld1q_s16(data + i);
+		vst1q_s32(mix + i, vmlal_s16(vld1q_s32(mix + i),
+		                             vget_low_s16(s), gain));
+		vst1q_s32(mix + i + 4, vmlal_s16(vld1q_s32(mix + i + 4),
+		                                 vget_high_s16(s), gain));
+	}
+	return i;
+}
+
+int SDL_MixVoices_SIMD_Load(Sint32 *mix, const Sint16 *stream, int count)
+{
+	int16x8_t s;
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		s = vld1q_s16(stream + i);
+		vst1q_s32(mix + i, vshll_n_s16(vget_low_s16(s), 7));
+		vst1q_s32(mix + i + 4, vshll_n_s16(vget_high_s16(s), 7));
+	}
+	return i;
+}
+
+int SDL_MixVoices_SIMD_Store(Sint16 *stream, const Sint32 *mix, int count)
+{
+	const int32x4_t bias = vdupq_n_s32(SDL_MIX_MAXVOLUME - 1);
+	int32x4_t lo, hi;
+	int i;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		lo = vld1q_s32(mix + i);
+		hi = vld1q_s32(mix + i + 4);
+		lo = vaddq_s32(lo, vandq_s32(vshrq_n_s32(lo, 31), bias));
+		hi = vaddq_s32(hi, vandq_s32(vshrq_n_s32(hi, 31), bias));
+		vst1q_s16(stream + i, vcombine_s16(vqshrn_n_s32(lo, 7),
+		                                   vqshrn_n_s32(hi, 7)));
+	}
+	return i;
+}
+
+#endif /* SDL_SSE2_MIXERS */
@@ -0,0 +1,58 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* SSE2 and NEON versions of SDL_MixAudio, from SDL_mixer_simd.c
+
+   Each one mixes as many whole vectors as fit in len bytes and returns
+   the number of bytes it mixed, leaving the rest to the C code.  The
+   volume must be between 1 and SDL_MIX_MAXVOLUME.
+*/
+
+#include "SDL_endian.h"
+
+#if defined(__SSE2__) || (defined(_MSC_VER) && defined(_M_X64))
+#define SDL_SSE2_MIXERS	1
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON)) && \
+      (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#define SDL_NEON_MIXERS	1
+#endif
+
+#if SDL_SSE2_MIXERS || SDL_NEON_MIXERS
+extern Uint32 SDL_MixAudio_SIMD_U8(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
+extern Uint32 SDL_MixAudio_SIMD_S8(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
+extern Uint32 SDL_MixAudio_SIMD_S16LSB(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
+extern Uint32 SDL_MixAudio_SIMD_S16MSB(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
+
+/* Add count native 16-bit samples, alternately scaled by left and right,
+   to a 32-bit mixing buffer.  Returns the number of samples done, always
+   an even number.  Used by SDL_MixVoices().
+*/
+extern int SDL_MixVoice_SIMD(Sint32 *mix, const Sint16 *data, int count, int left, int right);
+
+/* Move native 16-bit samples into the mixing buffer, scaled up by
+   SDL_MIX_MAXVOLUME, and back again with clipping.  Both return the
+   number of samples done.
+*/
+extern int SDL_MixVoices_SIMD_Load(Sint32 *mix, const Sint16 *stream, int count);
+extern int SDL_MixVoices_SIMD_Store(Sint16 *stream, const Sint32 *mix, int count);
+#endif
@@ -65,9 +65,15 @@ struct SDL_AudioDevice {
 	/* The current audio specification (shared with audio thread) */
 	SDL_AudioSpec spec;
 
+	/* The audio specification the callback fills */
+	SDL_AudioSpec callback_spec;
+
 	/* An audio conversion block for audio format emulation */
 	SDL_AudioCVT convert;
 
+	/* Rate conversion, kept separate since it carries over between buffers */
+	struct SDL_AudioResampler *resampler;
+
 	/* Current state flags */
 	int enabled;
 	int paused;
@@ -0,0 +1,945 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* A mixer for several voices at once, built on SDL_AudioCVT.
+
+   Every voice is converted to native 16-bit audio with the channels and
+   rate of the audio callback.  SDL_MixVoices() sums the stream and all
+   playing voices, each scaled by its per-channel gain, into a 32-bit
+   buffer and clips the result once when writing it back.
+
+   Streams are read, converted and looped by a feeder thread, into a ring
+   buffer for each voice that only the feeder writes and only the audio
+   callback reads, so the callback never waits on a file.  The write and
+   read positions count frames and run freely, as in SDL_audioqueue.c.
+   The feeder lock is held while refilling, and is taken before the audio
+   lock wherever both are needed.
+*/
+
+#include "SDL_audio.h"
+#include "SDL_thread.h"
+#include "SDL_sysaudio.h"
+#include "SDL_audio_c.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_mixer_simd.h"
+#include "../thread/SDL_barrier.h"
+
+#if SDL_SSE2_MIXERS
+#define HasSIMD()	SDL_HasSSE2()
+#elif SDL_NEON_MIXERS
+#define HasSIMD()	SDL_HasNEON()
+#endif
+
+struct SDL_Voice {
+	/* Converted audio:  all of it, or the piece of a stream the feeder
+	   is copying to the ring */
+	Uint8 *data;
+	Uint32 len;
+	Uint32 pos;
+
+	/* Where the voice loops, in bytes of data for memory voices and in
+	   bytes of the source for streams.  'end' is 0 for the end of data. */
+	Uint32 loop_start;
+	Uint32 loop_end;
+	int loops;
+	int loops_left;
+
+	/* The stream a voice reads from, NULL for memory voices */
+	SDL_RWops *src;
+	int freesrc;
+	int src_start;
+	Uint32 src_pos;
+	Uint32 src_chunk;
+	SDL_AudioCVT cvt;
+
+	/* Streams change the rate separately, so it carries on from one
+	   piece to the next, reading and converting into src_buf first */
+	SDL_AudioResampler *resampler;
+	Uint8 *src_buf;
+	Uint32 out_chunk;
+
+	/* The source frame size and rates, to convert loop points */
+	Uint32 in_frame;
+	int in_rate;
+	int out_rate;
+
+	/* What the feeder has ready for the audio callback */
+	Uint8 *ring;
+	Uint32 ring_frames;		/* Always a power of two */
+	volatile Uint32 ring_write;	/* Only changed by the feeder */
+	volatile Uint32 ring_read;	/* Only changed by the audio callback */
+	volatile int ring_done;		/* The feeder reached the end */
+
+	/* Mixing channels, and the volume of each from 0 to 128 */
+	int channels;
+	int gain[6];
+	int playing;
+
+	struct SDL_Voice *next;
+	struct SDL_Voice *next_stream;
+};
+
+/* The voices and the buffer they're summed in.  The list is changed with
+   the audio locked, and only the audio callback uses the buffer, which
+   is sized when the audio is opened. */
+static SDL_Voice *SDL_voices = NULL;
+static Sint32 *SDL_voice_mix = NULL;
+static int SDL_voice_mixlen = 0;
+
+/* The length of a stream voice's ring, in callback buffers */
+#define VOICE_RING_BUFFERS	4
+
+/* The thread refilling stream voices, started with the first one */
+static struct {
+	SDL_Thread *thread;
+	SDL_sem *wake;			/* Posted by the audio callback */
+	SDL_mutex *lock;		/* Held while refilling */
+	SDL_Voice *streams;		/* Changed with the lock held */
+	volatile int quit;
+#ifndef SDL_MemoryBarrier
+	SDL_mutex *barrier;
+#endif
+} SDL_feeder;
+
+#ifdef SDL_MemoryBarrier
+#define VoiceBarrier()	SDL_MemoryBarrier()
+#else
+/* Taking and releasing a mutex orders memory just as well, and it is
+   never held for more than that, so neither thread waits on the other.
+*/
+#define VoiceBarrier()	{ SDL_mutexP(SDL_feeder.barrier); SDL_mutexV(SDL_feeder.barrier); }
+#endif
+
+static int SDLCALL SDL_RunVoiceFeeder(void *unused);
+static void SDL_StopVoiceFeeder(void);
+
+int SDL_OpenVoices(const SDL_AudioSpec *spec, int len)
+{
+	SDL_voice_mixlen = len / ((spec->format & 0xFF) / 8);
+	SDL_voice_mixlen -= (SDL_voice_mixlen % spec->channels);
+	SDL_voice_mix = (Sint32 *)SDL_malloc(SDL_voice_mixlen *
+	                                     sizeof(*SDL_voice_mix));
+	if ( SDL_voice_mix == NULL ) {
+		SDL_voice_mixlen = 0;
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	return(0);
+}
+
+static int SDL_StartVoiceFeeder(void)
+{
+	if ( SDL_feeder.thread ) {
+		return(0);
+	}
+	SDL_feeder.quit = 0;
+	SDL_feeder.wake = SDL_CreateSemaphore(0);
+	SDL_feeder.lock = SDL_CreateMutex();
+#ifndef SDL_MemoryBarrier
+	SDL_feeder.barrier = SDL_CreateMutex();
+	if ( SDL_feeder.barrier == NULL ) {
+		SDL_StopVoiceFeeder();
+		return(-1);
+	}
+#endif
+	if ( (SDL_feeder.wake == NULL) || (SDL_feeder.lock == NULL) ) {
+		SDL_StopVoiceFeeder();
+		return(-1);
+	}
+#if (defined(__WIN32__) && !defined(_WIN32_WCE)) && !defined(HAVE_LIBC) && !defined(__SYMBIAN32__)
+#undef SDL_CreateThread
+	SDL_feeder.thread = SDL_CreateThread(SDL_RunVoiceFeeder, NULL, NULL, NULL);
+#else
+	SDL_feeder.thread = SDL_CreateThread(SDL_RunVoiceFeeder, NULL);
+#endif
+	if ( SDL_feeder.thread == NULL ) {
+		SDL_StopVoiceFeeder();
+		SDL_SetError("Couldn't create voice feeder thread");
+		return(-1);
+	}
+	return(0);
+}
+
+static void SDL_StopVoiceFeeder(void)
+{
+	if ( SDL_feeder.thread ) {
+		SDL_feeder.quit = 1;
+		SDL_SemPost(SDL_feeder.wake);
+		SDL_WaitThread(SDL_feeder.thread, NULL);
+	}
+	if ( SDL_feeder.wake ) {
+		SDL_DestroySemaphore(SDL_feeder.wake);
+	}
+	if ( SDL_feeder.lock ) {
+		SDL_DestroyMutex(SDL_feeder.lock);
+	}
+#ifndef SDL_MemoryBarrier
+	if ( SDL_feeder.barrier ) {
+		SDL_DestroyMutex(SDL_feeder.barrier);
+	}
+#endif
+	SDL_memset(&SDL_feeder, 0, sizeof(SDL_feeder));
+}
+
+/* Find the audio specification voices are converted to */
+static int SDL_GetVoiceSpec(SDL_AudioSpec *spec)
+{
+	if ( (current_audio == NULL) || !current_audio->opened ) {
+		SDL_SetError("Audio device hasn't been opened");
+		return(-1);
+	}
+	*spec = current_audio->callback_spec;
+	return(0);
+}
+
+static SDL_Voice *SDL_AllocVoice(const SDL_AudioSpec *spec,
+                                 const SDL_AudioSpec *mix, int stream)
+{
+	SDL_Voice *voice;
+
+	if ( (spec->channels < 1) || (spec->format & 0xFF) < 8 ) {
+		SDL_SetError("Invalid voice format");
+		return(NULL);
+	}
+	voice = (SDL_Voice *)SDL_malloc(sizeof(*voice));
+	if ( voice == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_memset(voice, 0, sizeof(*voice));
+	if ( SDL_BuildAudioCVT(&voice->cvt, spec->format, spec->channels,
+	                       spec->freq, AUDIO_S16SYS, mix->channels,
+	                       stream ? spec->freq : mix->freq) < 0 ) {
+		SDL_free(voice);
+		return(NULL);
+	}
+	voice->in_frame = spec->channels * ((spec->format & 0xFF) / 8);
+	voice->in_rate = spec->freq;
+	voice->out_rate = mix->freq;
+	voice->channels = mix->channels;
+	SDL_SetVoiceVolume(voice, SDL_MIX_MAXVOLUME, 0);
+	return(voice);
+}
+
+static void SDL_LinkVoice(SDL_Voice *voice)
+{
+	SDL_LockAudio();
+	voice->next = SDL_voices;
+	SDL_voices = voice;
+	SDL_UnlockAudio();
+}
+
+SDL_Voice *SDL_CreateVoice(const SDL_AudioSpec *spec, const Uint8 *buf, Uint32 len)
+{
+	SDL_AudioSpec mix;
+	SDL_Voice *voice;
+
+	if ( SDL_GetVoiceSpec(&mix) < 0 ) {
+		return(NULL);
+	}
+	voice = SDL_AllocVoice(spec, &mix, 0);
+	if ( voice == NULL ) {
+		return(NULL);
+	}
+	len -= (len % voice->in_frame);
+
+	/* Convert the whole sound up front */
+	voice->cvt.len = len;
+	voice->data = (Uint8 *)SDL_malloc(len * voice->cvt.len_mult + 1);
+	if ( voice->data == NULL ) {
+		SDL_free(voice);
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_memcpy(voice->data, buf, len);
+	voice->cvt.buf = voice->data;
+	if ( voice->cvt.needed ) {
+		if ( SDL_ConvertAudio(&voice->cvt) < 0 ) {
+			SDL_free(voice->data);
+			SDL_free(voice);
+			return(NULL);
+		}
+		voice->len = voice->cvt.len_cvt;
+	} else {
+		voice->len = len;
+	}
+	voice->len -= voice->len % (2 * mix.channels);
+	SDL_LinkVoice(voice);
+	return(voice);
+}
+
+SDL_Voice *SDL_CreateVoiceRW(SDL_RWops *src, int freesrc, const SDL_AudioSpec *spec)
+{
+	SDL_AudioSpec mix;
+	SDL_Voice *voice;
+	Uint32 frames;
+
+	if ( src == NULL ) {
+		SDL_SetError("Passed a NULL data source");
+		return(NULL);
+	}
+	if ( SDL_GetVoiceSpec(&mix) < 0 ) {
+		return(NULL);
+	}
+	voice = SDL_AllocVoice(spec, &mix, 1);
+	if ( voice == NULL ) {
+		return(NULL);
+	}
+
+	/* Read about a callback's worth of audio at a time */
+	frames = (Uint32)(((double)mix.samples * spec->freq) / mix.freq) + 1;
+	voice->src_chunk = frames * voice->in_frame;
+	if ( spec->freq != mix.freq ) {
+		voice->resampler = SDL_CreateResampler(AUDIO_S16SYS,
+		                                       mix.channels, spec->freq,
+		                                       mix.freq, frames);
+		if ( voice->resampler == NULL ) {
+			SDL_free(voice);
+			return(NULL);
+		}
+		voice->out_chunk = mix.samples * 2 * mix.channels;
+		voice->src_buf = (Uint8 *)SDL_malloc(voice->src_chunk *
+		                                     voice->cvt.len_mult + 1);
+		voice->data = (Uint8 *)SDL_malloc(voice->out_chunk);
+	} else {
+		voice->data = (Uint8 *)SDL_malloc(voice->src_chunk *
+		                                  voice->cvt.len_mult + 1);
+		voice->src_buf = voice->data;
+	}
+	for ( voice->ring_frames = 1024;
+	      voice->ring_frames < mix.samples * VOICE_RING_BUFFERS;
+	      voice->ring_frames *= 2 ) {
+		;
+	}
+	voice->ring = (Uint8 *)SDL_malloc(voice->ring_frames * 2 * mix.channels);
+	if ( (voice->data == NULL) || (voice->src_buf == NULL) ||
+	     (voice->ring == NULL) ) {
+		SDL_FreeVoice(voice);
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	if ( SDL_StartVoiceFeeder() < 0 ) {
+		SDL_FreeVoice(voice);
+		return(NULL);
+	}
+	voice->src = src;
+	voice->freesrc = freesrc;
+	voice->src_start = SDL_RWtell(src);
+
+	SDL_mutexP(SDL_feeder.lock);
+	voice->next_stream = SDL_feeder.streams;
+	SDL_feeder.streams = voice;
+	SDL_mutexV(SDL_feeder.lock);
+	SDL_LinkVoice(voice);
+	return(voice);
+}
+
+void SDL_SetVoiceVolume(SDL_Voice *voice, int volume, int pan)
+{
+	int left, right, i;
+
+	if ( volume < 0 ) {
+		volume = 0;
+	} else if ( volume > SDL_MIX_MAXVOLUME ) {
+		volume = SDL_MIX_MAXVOLUME;
+	}
+	if ( pan < -128 ) {
+		pan = -128;
+	} else if ( pan > 128 ) {
+		pan = 128;
+	}
+	left = volume;
+	right = volume;
+	if ( pan > 0 ) {
+		left = (volume * (128 - pan)) / 128;
+	} else {
+		right = (volume * (128 + pan)) / 128;
+	}
+
+	/* Pairs are left and right, except for the 5.1 center and LFE */
+	SDL_LockAudio();
+	for ( i = 0; i < 6; i += 2 ) {
+		voice->gain[i] = left;
+		voice->gain[i+1] = right;
+	}
+	switch (voice->channels) {
+		case 1:
+			voice->gain[0] = volume;
+			break;
+		case 6:
+			voice->gain[2] = volume;
+			voice->gain[3] = volume;
+			break;
+	}
+	SDL_UnlockAudio();
+}
+
+void SDL_SetVoiceLoop(SDL_Voice *voice, Uint32 start, Uint32 end, int loops)
+{
+	/* The feeder loops streams */
+	if ( voice->src ) {
+		SDL_mutexP(SDL_feeder.lock);
+	}
+	SDL_LockAudio();
+	if ( voice->src ) {
+		voice->loop_start = start * voice->in_frame;
+		voice->loop_end = end * voice->in_frame;
+	} else {
+		/* Move the loop points to the converted data */
+		Uint32 frame = 2 * voice->channels;
+
+		voice->loop_start = (Uint32)(((double)start * voice->out_rate) /
+		                             voice->in_rate) * frame;
+		voice->loop_end = (Uint32)(((double)end * voice->out_rate) /
+		                           voice->in_rate) * frame;
+		if ( voice->loop_start >= voice->len ) {
+			voice->loop_start = 0;
+		}
+		if ( voice->loop_end > voice->len ) {
+			voice->loop_end = 0;
+		}
+	}
+	voice->loops = loops;
+	voice->loops_left = loops;
+	SDL_UnlockAudio();
+	if ( voice->src ) {
+		SDL_mutexV(SDL_feeder.lock);
+	}
+}
+
+static void SDL_RefillVoice(SDL_Voice *voice);
+
+void SDL_PlayVoice(SDL_Voice *voice)
+{
+	if ( voice->src ) {
+		/* Start the stream over and fill its ring here, while the
+		   audio callback leaves the voice alone */
+		SDL_mutexP(SDL_feeder.lock);
+		SDL_LockAudio();
+		voice->playing = 0;
+		SDL_UnlockAudio();
+		voice->loops_left = voice->loops;
+		voice->len = 0;
+		voice->pos = 0;
+		voice->src_pos = 0;
+		if ( voice->resampler ) {
+			SDL_ResetResampler(voice->resampler);
+		}
+		voice->ring_write = 0;
+		voice->ring_read = 0;
+		voice->ring_done = 0;
+		SDL_RefillVoice(voice);
+		SDL_LockAudio();
+		voice->playing = 1;
+		SDL_UnlockAudio();
+		SDL_mutexV(SDL_feeder.lock);
+		return;
+	}
+	SDL_LockAudio();
+	voice->loops_left = voice->loops;
+	voice->pos = 0;
+	voice->playing = 1;
+	SDL_UnlockAudio();
+}
+
+void SDL_StopVoice(SDL_Voice *voice)
+{
+	SDL_LockAudio();
+	voice->playing = 0;
+	SDL_UnlockAudio();
+}
+
+int SDL_VoicePlaying(SDL_Voice *voice)
+{
+	return(voice->playing);
+}
+
+void SDL_FreeVoice(SDL_Voice *voice)
+{
+	SDL_Voice *prev, *here;
+
+	if ( voice == NULL ) {
+		return;
+	}
+	if ( voice->src && SDL_feeder.lock ) {
+		SDL_mutexP(SDL_feeder.lock);
+		prev = NULL;
+		for ( here = SDL_feeder.streams; here; here = here->next_stream ) {
+			if ( here == voice ) {
+				if ( prev ) {
+					prev->next_stream = here->next_stream;
+				} else {
+					SDL_feeder.streams = here->next_stream;
+				}
+				break;
+			}
+			prev = here;
+		}
+		SDL_mutexV(SDL_feeder.lock);
+	}
+	SDL_LockAudio();
+	prev = NULL;
+	for ( here = SDL_voices; here; here = here->next ) {
+		if ( here == voice ) {
+			if ( prev ) {
+				prev->next = here->next;
+			} else {
+				SDL_voices = here->next;
+			}
+			break;
+		}
+		prev = here;
+	}
+	SDL_UnlockAudio();
+
+	if ( voice->src && voice->freesrc ) {
+		SDL_RWclose(voice->src);
+	}
+	if ( voice->src_buf != voice->data ) {
+		SDL_free(voice->src_buf);
+	}
+	SDL_FreeResampler(voice->resampler);
+	if ( voice->ring ) {
+		SDL_free(voice->ring);
+	}
+	SDL_free(voice->data);
+	SDL_free(voice);
+}
+
+/* Read and convert the next piece of a stream into src_buf, returning
+   its length, or 0 at the end */
+static int SDL_ReadVoiceSource(SDL_Voice *voice)
+{
+	Uint32 want;
+	int got;
+
+	want = voice->src_chunk;
+	if ( voice->loop_end ) {
+		if ( voice->src_pos >= voice->loop_end ) {
+			return(0);
+		}
+		if ( want > voice->loop_end - voice->src_pos ) {
+			want = voice->loop_end - voice->src_pos;
+		}
+	}
+	if ( SDL_RWseek(voice->src, voice->src_start + voice->src_pos,
+	                RW_SEEK_SET) < 0 ) {
+		return(0);
+	}
+	got = SDL_RWread(voice->src, voice->src_buf, 1, want);
+	if ( got <= 0 ) {
+		return(0);
+	}
+	got -= (got % voice->in_frame);
+	voice->src_pos += got;
+	voice->cvt.buf = voice->src_buf;
+	voice->cvt.len = got;
+	if ( voice->cvt.needed ) {
+		SDL_ConvertAudio(&voice->cvt);
+		got = voice->cvt.len_cvt;
+	}
+	return(got);
+}
+
+/* Fill the voice's data with the next piece of a stream, returns 0 at the
+   end.  The resampler may still hold a few frames then, which come out
+   after the loop start if the voice loops. */
+static int SDL_ReadVoice(SDL_Voice *voice)
+{
+	int got;
+
+	voice->pos = 0;
+	if ( voice->resampler == NULL ) {
+		voice->len = SDL_ReadVoiceSource(voice);
+		return(voice->len > 0);
+	}
+	voice->len = SDL_ReadResampler(voice->resampler, voice->data,
+	                               voice->out_chunk);
+	while ( voice->len == 0 ) {
+		got = SDL_ReadVoiceSource(voice);
+		if ( got <= 0 ) {
+			return(0);
+		}
+		SDL_FeedResampler(voice->resampler, voice->src_buf, got);
+		voice->len = SDL_ReadResampler(voice->resampler, voice->data,
+		                               voice->out_chunk);
+	}
+	return(1);
+}
+
+/* Make sure there's data to mix, handling loops, returns 0 at the end.
+   Streams are only filled by the feeder. */
+static int SDL_FillVoice(SDL_Voice *voice)
+{
+	Uint32 end;
+	int tries;
+
+	for ( tries = 0; tries < 2; ++tries ) {
+		if ( voice->src ) {
+			if ( (voice->pos < voice->len) || SDL_ReadVoice(voice) ) {
+				return(1);
+			}
+		} else {
+			end = voice->loop_end ? voice->loop_end : voice->len;
+			if ( voice->pos < end ) {
+				return(1);
+			}
+		}
+		if ( voice->loops_left == 0 ) {
+			break;
+		}
+		if ( voice->loops_left > 0 ) {
+			--voice->loops_left;
+		}
+		if ( voice->src ) {
+			voice->src_pos = voice->loop_start;
+			voice->len = 0;
+			voice->pos = 0;
+		} else {
+			voice->pos = voice->loop_start;
+		}
+	}
+	return(0);
+}
+
+/* Copy the stream into the ring until it's full, from the feeder thread
+   or SDL_PlayVoice() with the feeder lock held */
+static void SDL_RefillVoice(SDL_Voice *voice)
+{
+	const Uint32 frame = 2 * voice->channels;
+	Uint32 write, space, frames, at, part;
+	int done = 0;
+
+	write = voice->ring_write;
+	space = voice->ring_frames - (write - voice->ring_read);
+	VoiceBarrier();
+	while ( space > 0 ) {
+		if ( !SDL_FillVoice(voice) ) {
+			done = 1;
+			break;
+		}
+		frames = (voice->len - voice->pos) / frame;
+		if ( frames == 0 ) {
+			/* Drop a stray partial frame */
+			voice->pos = voice->len;
+			continue;
+		}
+		if ( frames > space ) {
+			frames = space;
+		}
+		at = write & (voice->ring_frames - 1);
+		part = voice->ring_frames - at;
+		if ( part > frames ) {
+			part = frames;
+		}
+		SDL_memcpy(voice->ring + at * frame,
+		           voice->data + voice->pos, part * frame);
+		SDL_memcpy(voice->ring, voice->data + voice->pos + part * frame,
+		           (frames - part) * frame);
+		voice->pos += frames * frame;
+		write += frames;
+		space -= frames;
+	}
+
+	VoiceBarrier();
+	voice->ring_write = write;
+	if ( done ) {
+		VoiceBarrier();
+		voice->ring_done = 1;
+	}
+}
+
+static int SDLCALL SDL_RunVoiceFeeder(void *unused)
+{
+	SDL_Voice *voice;
+
+	for ( ; ; ) {
+		SDL_SemWait(SDL_feeder.wake);
+		if ( SDL_feeder.quit ) {
+			break;
+		}
+		SDL_mutexP(SDL_feeder.lock);
+		for ( voice = SDL_feeder.streams; voice; voice = voice->next_stream ) {
+			if ( voice->playing && !voice->ring_done ) {
+				SDL_RefillVoice(voice);
+			}
+		}
+		SDL_mutexV(SDL_feeder.lock);
+	}
+	return(0);
+}
+
+/* Add 'count' samples of a voice's data into 'mix', from a frame start */
+static void SDL_MixVoiceData(SDL_Voice *voice, Sint32 *mix,
+                             const Sint16 *data, int count, int channels)
+{
+	int i, c;
+
+	switch (channels) {
+		case 1: {
+			const Sint32 gain = voice->gain[0];
+			i = 0;
+#ifdef HasSIMD
+			if ( HasSIMD() ) {
+				i = SDL_MixVoice_SIMD(mix, data, count,
+				                      gain, gain);
+			}
+#endif
+			for ( ; i < count; ++i ) {
+				mix[i] += data[i] * gain;
+			}
+		}
+		break;
+
+		case 2: {
+			const Sint32 left = voice->gain[0];
+			const Sint32 right = voice->gain[1];
+			i = 0;
+#ifdef HasSIMD
+			if ( HasSIMD() ) {
+				i = SDL_MixVoice_SIMD(mix, data, count,
+				                      left, right);
+			}
+#endif
+			for ( ; i < count; i += 2 ) {
+				mix[i] += data[i] * left;
+				mix[i+1] += data[i+1] * right;
+			}
+		}
+		break;
+
+		default:
+			for ( i = 0; i < count; i += channels ) {
+				for ( c = 0; c < channels; ++c ) {
+					mix[i+c] += data[i+c] *
+					            voice->gain[c];
+				}
+			}
+			break;
+	}
+}
+
+static void SDL_AccumulateVoice(SDL_Voice *voice, Sint32 *mix, int samples,
+                                int channels)
+{
+	Uint32 end;
+	int count;
+
+	while ( samples > 0 ) {
+		if ( !SDL_FillVoice(voice) ) {
+			voice->playing = 0;
+			break;
+		}
+		end = voice->loop_end ? voice->loop_end : voice->len;
+		count = (end - voice->pos) / 2;
+		if ( count > samples ) {
+			count = samples;
+		}
+		SDL_MixVoiceData(voice, mix,
+		                 (const Sint16 *)(voice->data + voice->pos),
+		                 count, channels);
+		voice->pos += count * 2;
+		mix += count;
+		samples -= count;
+	}
+}
+
+/* Mix what the feeder has ready for a stream, returns 1 if it wants more.
+   Running short before the end leaves a gap rather than waiting. */
+static int SDL_AccumulateStream(SDL_Voice *voice, Sint32 *mix, int samples,
+                                int channels)
+{
+	const Uint32 frame = 2 * channels;
+	Uint32 read, frames, at, part;
+	int done;
+
+	done = voice->ring_done;
+	VoiceBarrier();
+	read = voice->ring_read;
+	frames = voice->ring_write - read;
+	VoiceBarrier();
+	if ( frames > (Uint32)(samples / channels) ) {
+		frames = samples / channels;
+	} else if ( done ) {
+		voice->playing = 0;
+	}
+
+	at = read & (voice->ring_frames - 1);
+	part = voice->ring_frames - at;
+	if ( part > frames ) {
+		part = frames;
+	}
+	SDL_MixVoiceData(voice, mix, (const Sint16 *)(voice->ring + at * frame),
+	                 part * channels, channels);
+	if ( frames > part ) {
+		SDL_MixVoiceData(voice, mix + part * channels,
+		                 (const Sint16 *)voice->ring,
+		                 (frames - part) * channels, channels);
+	}
+
+	VoiceBarrier();
+	voice->ring_read = read + frames;
+	return(!done);
+}
+
+/* Mix into up to SDL_voice_mixlen samples, returns 1 if a stream wants
+   refilling */
+static int SDL_MixVoiceBlock(Uint8 *stream, int samples, Uint16 format,
+                             int channels)
+{
+	int first, i, refill;
+	const int big = 0x1000;
+	Sint32 *mix, sample;
+	Uint32 flip;
+	SDL_Voice *voice;
+
+	mix = SDL_voice_mix;
+
+	/* Start from what's already in the stream, at 16-bit scaled up by
+	   the volume, so each voice adds in with a single multiply. */
+	flip = (format & 0x8000) ? 0 : 0x8000;
+	i = 0;
+#ifdef HasSIMD
+	if ( (format == AUDIO_S16SYS) && HasSIMD() ) {
+		i = SDL_MixVoices_SIMD_Load(mix, (Sint16 *)stream, samples);
+	}
+#endif
+	if ( (format & 0xFF) == 8 ) {
+		for ( ; i < samples; ++i ) {
+			mix[i] = (Sint16)((stream[i] << 8) ^ flip) *
+			         SDL_MIX_MAXVOLUME;
+		}
+	} else if ( format & big ) {
+		for ( ; i < samples; ++i ) {
+			mix[i] = (Sint16)(((stream[i*2] << 8) |
+			                   stream[i*2+1]) ^ flip) *
+			         SDL_MIX_MAXVOLUME;
+		}
+	} else {
+		for ( ; i < samples; ++i ) {
+			mix[i] = (Sint16)(((stream[i*2+1] << 8) |
+			                   stream[i*2]) ^ flip) *
+			         SDL_MIX_MAXVOLUME;
+		}
+	}
+
+	refill = 0;
+	for ( voice = SDL_voices; voice; voice = voice->next ) {
+		if ( !voice->playing ) {
+			continue;
+		}
+		if ( voice->src ) {
+			refill |= SDL_AccumulateStream(voice, mix, samples,
+			                               channels);
+		} else {
+			SDL_AccumulateVoice(voice, mix, samples, channels);
+		}
+	}
+
+	/* Clip once and write the sum back */
+	i = 0;
+#ifdef HasSIMD
+	if ( (format == AUDIO_S16SYS) && HasSIMD() ) {
+		i = SDL_MixVoices_SIMD_Store((Sint16 *)stream, mix, samples);
+	}
+#endif
+	first = i;
+	for ( ; i < samples; ++i ) {
+		sample = mix[i] / SDL_MIX_MAXVOLUME;
+		if ( sample > 32767 ) {
+			sample = 32767;
+		} else if ( sample < -32768 ) {
+			sample = -32768;
+		}
+		mix[i] = (sample ^ flip) & 0xFFFF;
+	}
+	if ( (format & 0xFF) == 8 ) {
+		for ( i = first; i < samples; ++i ) {
+			stream[i] = (Uint8)(mix[i] >> 8);
+		}
+	} else if ( format & big ) {
+		for ( i = first; i < samples; ++i ) {
+			stream[i*2] = (Uint8)(mix[i] >> 8);
+			stream[i*2+1] = (Uint8)(mix[i] & 0xFF);
+		}
+	} else {
+		for ( i = first; i < samples; ++i ) {
+			stream[i*2] = (Uint8)(mix[i] & 0xFF);
+			stream[i*2+1] = (Uint8)(mix[i] >> 8);
+		}
+	}
+	return(refill);
+}
+
+void SDL_MixVoices(Uint8 *stream, int len)
+{
+	Uint16 format;
+	int channels, size, samples, chunk, refill;
+
+	if ( (current_audio == NULL) || (SDL_voices == NULL) ||
+	     (SDL_voice_mixlen <= 0) ) {
+		return;
+	}
+	format = current_audio->callback_spec.format;
+	channels = current_audio->callback_spec.channels;
+	size = (format & 0xFF) / 8;
+	samples = len / size;
+	samples -= (samples % channels);
+
+	/* The mixing buffer holds a callback's worth, mix longer buffers a
+	   piece at a time rather than allocating here */
+	refill = 0;
+	while ( samples > 0 ) {
+		chunk = samples;
+		if ( chunk > SDL_voice_mixlen ) {
+			chunk = SDL_voice_mixlen;
+		}
+		refill |= SDL_MixVoiceBlock(stream, chunk, format, channels);
+		stream += chunk * size;
+		samples -= chunk;
+	}
+	if ( refill ) {
+		SDL_SemPost(SDL_feeder.wake);
+	}
+}
+
+void SDL_QuitVoices(void)
+{
+	SDL_Voice *voice;
+
+	SDL_StopVoiceFeeder();
+
+	/* The voices belong to the application, just forget them */
+	while ( SDL_voices ) {
+		voice = SDL_voices;
+		SDL_voices = voice->next;
+		voice->playing = 0;
+		voice->next = NULL;
+		voice->next_stream = NULL;
+	}
+	if ( SDL_voice_mix ) {
+		SDL_free(SDL_voice_mix);
+		SDL_voice_mix = NULL;
+		SDL_voice_mixlen = 0;
+	}
+}
@@ -27,7 +27,7 @@
 #include "SDL_wave.h"
 
 
-static int ReadChunk(SDL_RWops *src, Chunk *chunk);
+static int ReadChunk(SDL_RWops *src, Chunk *chunk, int borrow);
 
 struct MS_ADPCM_decodestate {
 	Uint8 hPredictor;
@@ -35,46 +35,52 @@ struct MS_ADPCM_decodestate {
 	Sint16 iSamp1;
 	Sint16 iSamp2;
 };
-static struct MS_ADPCM_decoder {
+struct MS_ADPCM_decoder {
 	WaveFMT wavefmt;
 	Uint16 wSamplesPerBlock;
 	Uint16 wNumCoef;
 	Sint16 aCoeff[7][2];
 	/* * * */
 	struct MS_ADPCM_decodestate state[2];
-} MS_ADPCM_state;
+};
 
-static int InitMS_ADPCM(WaveFMT *format)
+static int InitMS_ADPCM(struct MS_ADPCM_decoder *dec, WaveFMT *format)
 {
 	Uint8 *rogue_feel;
 	Uint16 extra_info;
 	int i;
 
 	/* Set the rogue pointer to the MS_ADPCM specific data */
-	MS_ADPCM_state.wavefmt.encoding = SDL_SwapLE16(format->encoding);
-	MS_ADPCM_state.wavefmt.channels = SDL_SwapLE16(format->channels);
-	MS_ADPCM_state.wavefmt.frequency = SDL_SwapLE32(format->frequency);
-	MS_ADPCM_state.wavefmt.byterate = SDL_SwapLE32(format->byterate);
-	MS_ADPCM_state.wavefmt.blockalign = SDL_SwapLE16(format->blockalign);
-	MS_ADPCM_state.wavefmt.bitspersample =
-					 SDL_SwapLE16(format->bitspersample);
+	dec->wavefmt.encoding = SDL_SwapLE16(format->encoding);
+	dec->wavefmt.channels = SDL_SwapLE16(format->channels);
+	dec->wavefmt.frequency = SDL_SwapLE32(format->frequency);
+	dec->wavefmt.byterate = SDL_SwapLE32(format->byterate);
+	dec->wavefmt.blockalign = SDL_SwapLE16(format->blockalign);
+	dec->wavefmt.bitspersample = SDL_SwapLE16(format->bitspersample);
 	rogue_feel = (Uint8 *)format+sizeof(*format);
 	if ( sizeof(*format) == 16 ) {
 		extra_info = ((rogue_feel[1]<<8)|rogue_feel[0]);
 		rogue_feel += sizeof(Uint16);
 	}
-	MS_ADPCM_state.wSamplesPerBlock = ((rogue_feel[1]<<8)|rogue_feel[0]);
+	dec->wSamplesPerBlock = ((rogue_feel[1]<<8)|rogue_feel[0]);
 	rogue_feel += sizeof(Uint16);
-	MS_ADPCM_state.wNumCoef = ((rogue_feel[1]<<8)|rogue_feel[0]);
+
+	/* After the first two, samples are decoded two at a time */
+	if ( (dec->wSamplesPerBlock < 2) ||
+	     (((dec->wSamplesPerBlock-2)*dec->wavefmt.channels) & 1) ) {
+		SDL_SetError("Invalid ADPCM block size");
+		return(-1);
+	}
+	dec->wNumCoef = ((rogue_feel[1]<<8)|rogue_feel[0]);
 	rogue_feel += sizeof(Uint16);
-	if ( MS_ADPCM_state.wNumCoef != 7 ) {
+	if ( dec->wNumCoef != 7 ) {
 		SDL_SetError("Unknown set of MS_ADPCM coefficients");
 		return(-1);
 	}
-	for ( i=0; i<MS_ADPCM_state.wNumCoef; ++i ) {
-		MS_ADPCM_state.aCoeff[i][0] = ((rogue_feel[1]<<8)|rogue_feel[0]);
+	for ( i=0; i<dec->wNumCoef; ++i ) {
+		dec->aCoeff[i][0] = ((rogue_feel[1]<<8)|rogue_feel[0]);
 		rogue_feel += sizeof(Uint16);
-		MS_ADPCM_state.aCoeff[i][1] = ((rogue_feel[1]<<8)|rogue_feel[0]);
+		dec->aCoeff[i][1] = ((rogue_feel[1]<<8)|rogue_feel[0]);
 		rogue_feel += sizeof(Uint16);
 	}
 	return(0);
@@ -114,22 +120,96 @@ static Sint32 MS_ADPCM_nibble(struct MS_ADPCM_decodestate *state,
 	return(new_sample);
 }
 
-static int MS_ADPCM_decode(Uint8 **audio_buf, Uint32 *audio_len)
+/* Decode one block of wSamplesPerBlock sample frames */
+static void MS_ADPCM_decode_block(struct MS_ADPCM_decoder *dec,
+				const Uint8 *encoded, Uint8 *decoded)
 {
 	struct MS_ADPCM_decodestate *state[2];
-	Uint8 *freeable, *encoded, *decoded;
-	Sint32 encoded_len, samplesleft;
+	Sint32 samplesleft;
 	Sint8 nybble, stereo;
 	Sint16 *coeff[2];
 	Sint32 new_sample;
 
+	stereo = (dec->wavefmt.channels == 2);
+	state[0] = &dec->state[0];
+	state[1] = &dec->state[stereo];
+
+	/* Grab the initial information for this block */
+	state[0]->hPredictor = *encoded++;
+	if ( stereo ) {
+		state[1]->hPredictor = *encoded++;
+	}
+	state[0]->iDelta = ((encoded[1]<<8)|encoded[0]);
+	encoded += sizeof(Sint16);
+	if ( stereo ) {
+		state[1]->iDelta = ((encoded[1]<<8)|encoded[0]);
+		encoded += sizeof(Sint16);
+	}
+	state[0]->iSamp1 = ((encoded[1]<<8)|encoded[0]);
+	encoded += sizeof(Sint16);
+	if ( stereo ) {
+		state[1]->iSamp1 = ((encoded[1]<<8)|encoded[0]);
+		encoded += sizeof(Sint16);
+	}
+	state[0]->iSamp2 = ((encoded[1]<<8)|encoded[0]);
+	encoded += sizeof(Sint16);
+	if ( stereo ) {
+		state[1]->iSamp2 = ((encoded[1]<<8)|encoded[0]);
+		encoded += sizeof(Sint16);
+	}
+	coeff[0] = dec->aCoeff[state[0]->hPredictor];
+	coeff[1] = dec->aCoeff[state[1]->hPredictor];
+
+	/* Store the two initial samples we start with */
+	decoded[0] = state[0]->iSamp2&0xFF;
+	decoded[1] = state[0]->iSamp2>>8;
+	decoded += 2;
+	if ( stereo ) {
+		decoded[0] = state[1]->iSamp2&0xFF;
+		decoded[1] = state[1]->iSamp2>>8;
+		decoded += 2;
+	}
+	decoded[0] = state[0]->iSamp1&0xFF;
+	decoded[1] = state[0]->iSamp1>>8;
+	decoded += 2;
+	if ( stereo ) {
+		decoded[0] = state[1]->iSamp1&0xFF;
+		decoded[1] = state[1]->iSamp1>>8;
+		decoded += 2;
+	}
+
+	/* Decode and store the other samples in this block */
+	samplesleft = (dec->wSamplesPerBlock-2)*dec->wavefmt.channels;
+	while ( samplesleft > 0 ) {
+		nybble = (*encoded)>>4;
+		new_sample = MS_ADPCM_nibble(state[0],nybble,coeff[0]);
+		decoded[0] = new_sample&0xFF;
+		new_sample >>= 8;
+		decoded[1] = new_sample&0xFF;
+		decoded += 2;
+
+		nybble = (*encoded)&0x0F;
+		new_sample = MS_ADPCM_nibble(state[1],nybble,coeff[1]);
+		decoded[0] = new_sample&0xFF;
+		new_sample >>= 8;
+		decoded[1] = new_sample&0xFF;
+		decoded += 2;
+
+		++encoded;
+		samplesleft -= 2;
+	}
+}
+
+static int MS_ADPCM_decode(struct MS_ADPCM_decoder *dec, const Uint8 *encoded,
+				Uint8 **audio_buf, Uint32 *audio_len)
+{
+	Uint8 *decoded;
+	Sint32 encoded_len, decoded_block;
+
 	/* Allocate the proper sized output buffer */
 	encoded_len = *audio_len;
-	encoded = *audio_buf;
-	freeable = *audio_buf;
-	*audio_len = (encoded_len/MS_ADPCM_state.wavefmt.blockalign) * 
-				MS_ADPCM_state.wSamplesPerBlock*
-				MS_ADPCM_state.wavefmt.channels*sizeof(Sint16);
+	decoded_block = dec->wSamplesPerBlock*dec->wavefmt.channels*sizeof(Sint16);
+	*audio_len = (encoded_len/dec->wavefmt.blockalign) * decoded_block;
 	*audio_buf = (Uint8 *)SDL_malloc(*audio_len);
 	if ( *audio_buf == NULL ) {
 		SDL_Error(SDL_ENOMEM);
@@ -138,78 +218,12 @@ static int MS_ADPCM_decode(Uint8 **audio_buf, Uint32 *audio_len)
 	decoded = *audio_buf;
 
 	/* Get ready... Go! */
-	stereo = (MS_ADPCM_state.wavefmt.channels == 2);
-	state[0] = &MS_ADPCM_state.state[0];
-	state[1] = &MS_ADPCM_state.state[stereo];
-	while ( encoded_len >= MS_ADPCM_state.wavefmt.blockalign ) {
-		/* Grab the initial information for this block */
-		state[0]->hPredictor = *encoded++;
-		if ( stereo ) {
-			state[1]->hPredictor = *encoded++;
-		}
-		state[0]->iDelta = ((encoded[1]<<8)|encoded[0]);
-		encoded += sizeof(Sint16);
-		if ( stereo ) {
-			state[1]->iDelta = ((encoded[1]<<8)|encoded[0]);
-			encoded += sizeof(Sint16);
-		}
-		state[0]->iSamp1 = ((encoded[1]<<8)|encoded[0]);
-		encoded += sizeof(Sint16);
-		if ( stereo ) {
-			state[1]->iSamp1 = ((encoded[1]<<8)|encoded[0]);
-			encoded += sizeof(Sint16);
-		}
-		state[0]->iSamp2 = ((encoded[1]<<8)|encoded[0]);
-		encoded += sizeof(Sint16);
-		if ( stereo ) {
-			state[1]->iSamp2 = ((encoded[1]<<8)|encoded[0]);
-			encoded += sizeof(Sint16);
-		}
-		coeff[0] = MS_ADPCM_state.aCoeff[state[0]->hPredictor];
-		coeff[1] = MS_ADPCM_state.aCoeff[state[1]->hPredictor];
-
-		/* Store the two initial samples we start with */
-		decoded[0] = state[0]->iSamp2&0xFF;
-		decoded[1] = state[0]->iSamp2>>8;
-		decoded += 2;
-		if ( stereo ) {
-			decoded[0] = state[1]->iSamp2&0xFF;
-			decoded[1] = state[1]->iSamp2>>8;
-			decoded += 2;
-		}
-		decoded[0] = state[0]->iSamp1&0xFF;
-		decoded[1] = state[0]->iSamp1>>8;
-		decoded += 2;
-		if ( stereo ) {
-			decoded[0] = state[1]->iSamp1&0xFF;
-			decoded[1] = state[1]->iSamp1>>8;
-			decoded += 2;
-		}
-
-		/* Decode and store the other samples in this block */
-		samplesleft = (MS_ADPCM_state.wSamplesPerBlock-2)*
-					MS_ADPCM_state.wavefmt.channels;
-		while ( samplesleft > 0 ) {
-			nybble = (*encoded)>>4;
-			new_sample = MS_ADPCM_nibble(state[0],nybble,coeff[0]);
-			decoded[0] = new_sample&0xFF;
-			new_sample >>= 8;
-			decoded[1] = new_sample&0xFF;
-			decoded += 2;
-
-			nybble = (*encoded)&0x0F;
-			new_sample = MS_ADPCM_nibble(state[1],nybble,coeff[1]);
-			decoded[0] = new_sample&0xFF;
-			new_sample >>= 8;
-			decoded[1] = new_sample&0xFF;
-			decoded += 2;
-
-			++encoded;
-			samplesleft -= 2;
-		}
-		encoded_len -= MS_ADPCM_state.wavefmt.blockalign;
+	while ( encoded_len >= dec->wavefmt.blockalign ) {
+		MS_ADPCM_decode_block(dec, encoded, decoded);
+		encoded += dec->wavefmt.blockalign;
+		encoded_len -= dec->wavefmt.blockalign;
+		decoded += decoded_block;
 	}
-	SDL_free(freeable);
 	return(0);
 }
 
@@ -217,32 +231,38 @@ struct IMA_ADPCM_decodestate {
 	Sint32 sample;
 	Sint8 index;
 };
-static struct IMA_ADPCM_decoder {
+struct IMA_ADPCM_decoder {
 	WaveFMT wavefmt;
 	Uint16 wSamplesPerBlock;
 	/* * * */
 	struct IMA_ADPCM_decodestate state[2];
-} IMA_ADPCM_state;
+};
 
-static int InitIMA_ADPCM(WaveFMT *format)
+static int InitIMA_ADPCM(struct IMA_ADPCM_decoder *dec, WaveFMT *format)
 {
 	Uint8 *rogue_feel;
 	Uint16 extra_info;
 
 	/* Set the rogue pointer to the IMA_ADPCM specific data */
-	IMA_ADPCM_state.wavefmt.encoding = SDL_SwapLE16(format->encoding);
-	IMA_ADPCM_state.wavefmt.channels = SDL_SwapLE16(format->channels);
-	IMA_ADPCM_state.wavefmt.frequency = SDL_SwapLE32(format->frequency);
-	IMA_ADPCM_state.wavefmt.byterate = SDL_SwapLE32(format->byterate);
-	IMA_ADPCM_state.wavefmt.blockalign = SDL_SwapLE16(format->blockalign);
-	IMA_ADPCM_state.wavefmt.bitspersample =
-					 SDL_SwapLE16(format->bitspersample);
+	dec->wavefmt.encoding = SDL_SwapLE16(format->encoding);
+	dec->wavefmt.channels = SDL_SwapLE16(format->channels);
+	dec->wavefmt.frequency = SDL_SwapLE32(format->frequency);
+	dec->wavefmt.byterate = SDL_SwapLE32(format->byterate);
+	dec->wavefmt.blockalign = SDL_SwapLE16(format->blockalign);
+	dec->wavefmt.bitspersample = SDL_SwapLE16(format->bitspersample);
 	rogue_feel = (Uint8 *)format+sizeof(*format);
 	if ( sizeof(*format) == 16 ) {
 		extra_info = ((rogue_feel[1]<<8)|rogue_feel[0]);
 		rogue_feel += sizeof(Uint16);
 	}
-	IMA_ADPCM_state.wSamplesPerBlock = ((rogue_feel[1]<<8)|rogue_feel[0]);
+	dec->wSamplesPerBlock = ((rogue_feel[1]<<8)|rogue_feel[0]);
+
+	/* Check to make sure we have enough variables in the state array */
+	if ( dec->wavefmt.channels > SDL_arraysize(dec->state) ) {
+		SDL_SetError("IMA ADPCM decoder can only handle %d channels",
+					SDL_arraysize(dec->state));
+		return(-1);
+	}
 	return(0);
 }
 
@@ -297,7 +317,7 @@ static Sint32 IMA_ADPCM_nibble(struct IMA_ADPCM_decodestate *state,Uint8 nybble)
 }
 
 /* Fill the decode buffer with a channel block of data (8 samples) */
-static void Fill_IMA_ADPCM_block(Uint8 *decoded, Uint8 *encoded,
+static void Fill_IMA_ADPCM_block(Uint8 *decoded, const Uint8 *encoded,
 	int channel, int numchannels, struct IMA_ADPCM_decodestate *state)
 {
 	int i;
@@ -324,30 +344,65 @@ static void Fill_IMA_ADPCM_block(Uint8 *decoded, Uint8 *encoded,
 	}
 }
 
-static int IMA_ADPCM_decode(Uint8 **audio_buf, Uint32 *audio_len)
+/* Decode one block of wSamplesPerBlock sample frames, rounded up to the
+   next group of 8 after the first
+ */
+static void IMA_ADPCM_decode_block(struct IMA_ADPCM_decoder *dec,
+				const Uint8 *encoded, Uint8 *decoded)
 {
 	struct IMA_ADPCM_decodestate *state;
-	Uint8 *freeable, *encoded, *decoded;
-	Sint32 encoded_len, samplesleft;
+	Sint32 samplesleft;
 	unsigned int c, channels;
 
-	/* Check to make sure we have enough variables in the state array */
-	channels = IMA_ADPCM_state.wavefmt.channels;
-	if ( channels > SDL_arraysize(IMA_ADPCM_state.state) ) {
-		SDL_SetError("IMA ADPCM decoder can only handle %d channels",
-					SDL_arraysize(IMA_ADPCM_state.state));
-		return(-1);
+	channels = dec->wavefmt.channels;
+	state = dec->state;
+
+	/* Grab the initial information for this block */
+	for ( c=0; c<channels; ++c ) {
+		/* Fill the state information for this block */
+		state[c].sample = ((encoded[1]<<8)|encoded[0]);
+		encoded += 2;
+		if ( state[c].sample & 0x8000 ) {
+			state[c].sample -= 0x10000;
+		}
+		state[c].index = *encoded++;
+		/* Reserved byte in buffer header, should be 0 */
+		if ( *encoded++ != 0 ) {
+			/* Uh oh, corrupt data?  Buggy code? */;
+		}
+
+		/* Store the initial sample we start with */
+		decoded[0] = (Uint8)(state[c].sample&0xFF);
+		decoded[1] = (Uint8)(state[c].sample>>8);
+		decoded += 2;
 	}
-	state = IMA_ADPCM_state.state;
 
-	/* Allocate the proper sized output buffer */
+	/* Decode and store the other samples in this block */
+	samplesleft = (dec->wSamplesPerBlock-1)*channels;
+	while ( samplesleft > 0 ) {
+		for ( c=0; c<channels; ++c ) {
+			Fill_IMA_ADPCM_block(decoded, encoded,
+					c, channels, &state[c]);
+			encoded += 4;
+			samplesleft -= 8;
+		}
+		decoded += (channels * 8 * 2);
+	}
+}
+
+static int IMA_ADPCM_decode(struct IMA_ADPCM_decoder *dec, const Uint8 *encoded,
+				Uint8 **audio_buf, Uint32 *audio_len)
+{
+	Uint8 *decoded;
+	Sint32 encoded_len, decoded_block;
+
+	/* Allocate the proper sized output buffer, with room for the
+	   rounding at the end of the last block */
 	encoded_len = *audio_len;
-	encoded = *audio_buf;
-	freeable = *audio_buf;
-	*audio_len = (encoded_len/IMA_ADPCM_state.wavefmt.blockalign) * 
-				IMA_ADPCM_state.wSamplesPerBlock*
-				IMA_ADPCM_state.wavefmt.channels*sizeof(Sint16);
-	*audio_buf = (Uint8 *)SDL_malloc(*audio_len);
+	decoded_block = dec->wSamplesPerBlock*dec->wavefmt.channels*sizeof(Sint16);
+	*audio_len = (encoded_len/dec->wavefmt.blockalign) * decoded_block;
+	*audio_buf = (Uint8 *)SDL_malloc(*audio_len +
+				dec->wavefmt.channels*8*sizeof(Sint16));
 	if ( *audio_buf == NULL ) {
 		SDL_Error(SDL_ENOMEM);
 		return(-1);
@@ -355,42 +410,71 @@ static int IMA_ADPCM_decode(Uint8 **audio_buf, Uint32 *audio_len)
 	decoded = *audio_buf;
 
 	/* Get ready... Go! */
-	while ( encoded_len >= IMA_ADPCM_state.wavefmt.blockalign ) {
-		/* Grab the initial information for this block */
-		for ( c=0; c<channels; ++c ) {
-			/* Fill the state information for this block */
-			state[c].sample = ((encoded[1]<<8)|encoded[0]);
-			encoded += 2;
-			if ( state[c].sample & 0x8000 ) {
-				state[c].sample -= 0x10000;
-			}
-			state[c].index = *encoded++;
-			/* Reserved byte in buffer header, should be 0 */
-			if ( *encoded++ != 0 ) {
-				/* Uh oh, corrupt data?  Buggy code? */;
-			}
+	while ( encoded_len >= dec->wavefmt.blockalign ) {
+		IMA_ADPCM_decode_block(dec, encoded, decoded);
+		encoded += dec->wavefmt.blockalign;
+		encoded_len -= dec->wavefmt.blockalign;
+		decoded += decoded_block;
+	}
+	return(0);
+}
 
-			/* Store the initial sample we start with */
-			decoded[0] = (Uint8)(state[c].sample&0xFF);
-			decoded[1] = (Uint8)(state[c].sample>>8);
-			decoded += 2;
-		}
+/* Check the format chunk, set up any decoder it needs and fill in the
+   spec of the decoded audio.  Returns the WAVE encoding, or -1 on error.
+ */
+static int InitWAVFormat(WaveFMT *format, SDL_AudioSpec *spec,
+			struct MS_ADPCM_decoder *MS_ADPCM_state,
+			struct IMA_ADPCM_decoder *IMA_ADPCM_state)
+{
+	int encoding;
 
-		/* Decode and store the other samples in this block */
-		samplesleft = (IMA_ADPCM_state.wSamplesPerBlock-1)*channels;
-		while ( samplesleft > 0 ) {
-			for ( c=0; c<channels; ++c ) {
-				Fill_IMA_ADPCM_block(decoded, encoded,
-						c, channels, &state[c]);
-				encoded += 4;
-				samplesleft -= 8;
+	encoding = SDL_SwapLE16(format->encoding);
+	switch (encoding) {
+		case PCM_CODE:
+			/* We can understand this */
+			break;
+		case MS_ADPCM_CODE:
+			/* Try to understand this */
+			if ( InitMS_ADPCM(MS_ADPCM_state, format) < 0 ) {
+				return(-1);
 			}
-			decoded += (channels * 8 * 2);
-		}
-		encoded_len -= IMA_ADPCM_state.wavefmt.blockalign;
+			break;
+		case IMA_ADPCM_CODE:
+			/* Try to understand this */
+			if ( InitIMA_ADPCM(IMA_ADPCM_state, format) < 0 ) {
+				return(-1);
+			}
+			break;
+		case MP3_CODE:
+			SDL_SetError("MPEG Layer 3 data not supported");
+			return(-1);
+		default:
+			SDL_SetError("Unknown WAVE data format: 0x%.4x", encoding);
+			return(-1);
 	}
-	SDL_free(freeable);
-	return(0);
+	SDL_memset(spec, 0, (sizeof *spec));
+	spec->freq = SDL_SwapLE32(format->frequency);
+	switch (SDL_SwapLE16(format->bitspersample)) {
+		case 4:
+			if ( encoding != PCM_CODE ) {
+				spec->format = AUDIO_S16;
+			}
+			break;
+		case 8:
+			spec->format = AUDIO_U8;
+			break;
+		case 16:
+			spec->format = AUDIO_S16;
+			break;
+	}
+	if ( spec->format == 0 ) {
+		SDL_SetError("Unknown %d-bit PCM data format",
+			SDL_SwapLE16(format->bitspersample));
+		return(-1);
+	}
+	spec->channels = (Uint8)SDL_SwapLE16(format->channels);
+	spec->samples = 4096;		/* Good default buffer size */
+	return(encoding);
 }
 
 SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
@@ -399,8 +483,11 @@ SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
 	int was_error;
 	Chunk chunk;
 	int lenread;
-	int MS_ADPCM_encoded, IMA_ADPCM_encoded;
+	int encoding;
 	int samplesize;
+	struct MS_ADPCM_decoder MS_ADPCM_state;
+	struct IMA_ADPCM_decoder IMA_ADPCM_state;
+	int borrow;
 
 	/* WAV magic header */
 	Uint32 RIFFchunk;
@@ -413,6 +500,8 @@ SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
 
 	/* Make sure we are passed a valid data source */
 	was_error = 0;
+	chunk.data = NULL;
+	chunk.borrowed = 0;
 	if ( src == NULL ) {
 		was_error = 1;
 		goto done;
@@ -436,13 +525,12 @@ SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
 	headerDiff += sizeof(Uint32); /* for WAVE */
 
 	/* Read the audio data format chunk */
-	chunk.data = NULL;
 	do {
 		if ( chunk.data != NULL ) {
 			SDL_free(chunk.data);
 			chunk.data = NULL;
 		}
-		lenread = ReadChunk(src, &chunk);
+		lenread = ReadChunk(src, &chunk, 0);
 		if ( lenread < 0 ) {
 			was_error = 1;
 			goto done;
@@ -453,100 +541,51 @@ SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
 
 	/* Decode the audio data format */
 	format = (WaveFMT *)chunk.data;
+	chunk.data = NULL;
 	if ( chunk.magic != FMT ) {
 		SDL_SetError("Complex WAVE files not supported");
 		was_error = 1;
 		goto done;
 	}
-	MS_ADPCM_encoded = IMA_ADPCM_encoded = 0;
-	switch (SDL_SwapLE16(format->encoding)) {
-		case PCM_CODE:
-			/* We can understand this */
-			break;
-		case MS_ADPCM_CODE:
-			/* Try to understand this */
-			if ( InitMS_ADPCM(format) < 0 ) {
-				was_error = 1;
-				goto done;
-			}
-			MS_ADPCM_encoded = 1;
-			break;
-		case IMA_ADPCM_CODE:
-			/* Try to understand this */
-			if ( InitIMA_ADPCM(format) < 0 ) {
-				was_error = 1;
-				goto done;
-			}
-			IMA_ADPCM_encoded = 1;
-			break;
-		case MP3_CODE:
-			SDL_SetError("MPEG Layer 3 data not supported",
-					SDL_SwapLE16(format->encoding));
-			was_error = 1;
-			goto done;
-		default:
-			SDL_SetError("Unknown WAVE data format: 0x%.4x",
-					SDL_SwapLE16(format->encoding));
-			was_error = 1;
-			goto done;
-	}
-	SDL_memset(spec, 0, (sizeof *spec));
-	spec->freq = SDL_SwapLE32(format->frequency);
-	switch (SDL_SwapLE16(format->bitspersample)) {
-		case 4:
-			if ( MS_ADPCM_encoded || IMA_ADPCM_encoded ) {
-				spec->format = AUDIO_S16;
-			} else {
-				was_error = 1;
-			}
-			break;
-		case 8:
-			spec->format = AUDIO_U8;
-			break;
-		case 16:
-			spec->format = AUDIO_S16;
-			break;
-		default:
-			was_error = 1;
-			break;
-	}
-	if ( was_error ) {
-		SDL_SetError("Unknown %d-bit PCM data format",
-			SDL_SwapLE16(format->bitspersample));
+	encoding = InitWAVFormat(format, spec, &MS_ADPCM_state, &IMA_ADPCM_state);
+	if ( encoding < 0 ) {
+		was_error = 1;
 		goto done;
 	}
-	spec->channels = (Uint8)SDL_SwapLE16(format->channels);
-	spec->samples = 4096;		/* Good default buffer size */
 
-	/* Read the audio data chunk */
+	/* Read the audio data chunk.  Compressed audio is decoded straight
+	   from memory and mapped sources, instead of from a copy.
+	 */
 	*audio_buf = NULL;
+	borrow = (encoding != PCM_CODE);
 	do {
-		if ( *audio_buf != NULL ) {
-			SDL_free(*audio_buf);
-			*audio_buf = NULL;
+		if ( (chunk.data != NULL) && !chunk.borrowed ) {
+			SDL_free(chunk.data);
 		}
-		lenread = ReadChunk(src, &chunk);
+		chunk.data = NULL;
+		lenread = ReadChunk(src, &chunk, borrow);
 		if ( lenread < 0 ) {
 			was_error = 1;
 			goto done;
 		}
-		*audio_len = lenread;
-		*audio_buf = chunk.data;
 		if(chunk.magic != DATA) headerDiff += lenread + 2 * sizeof(Uint32);
 	} while ( chunk.magic != DATA );
 	headerDiff += 2 * sizeof(Uint32); /* for the data chunk and len */
+	*audio_len = lenread;
 
-	if ( MS_ADPCM_encoded ) {
-		if ( MS_ADPCM_decode(audio_buf, audio_len) < 0 ) {
+	if ( encoding == MS_ADPCM_CODE ) {
+		if ( MS_ADPCM_decode(&MS_ADPCM_state, chunk.data, audio_buf, audio_len) < 0 ) {
 			was_error = 1;
 			goto done;
 		}
-	}
-	if ( IMA_ADPCM_encoded ) {
-		if ( IMA_ADPCM_decode(audio_buf, audio_len) < 0 ) {
+	} else if ( encoding == IMA_ADPCM_CODE ) {
+		if ( IMA_ADPCM_decode(&IMA_ADPCM_state, chunk.data, audio_buf, audio_len) < 0 ) {
 			was_error = 1;
 			goto done;
 		}
+	} else {
+		*audio_buf = chunk.data;
+		chunk.data = NULL;
 	}
 
 	/* Don't return a buffer that isn't a multiple of samplesize */
@@ -557,6 +596,9 @@ done:
 	if ( format != NULL ) {
 		SDL_free(format);
 	}
+	if ( (chunk.data != NULL) && !chunk.borrowed ) {
+		SDL_free(chunk.data);
+	}
 	if ( src ) {
 		if ( freesrc ) {
 			SDL_RWclose(src);
@@ -581,10 +623,22 @@ void SDL_FreeWAV(Uint8 *audio_buf)
 	}
 }
 
-static int ReadChunk(SDL_RWops *src, Chunk *chunk)
+static int ReadChunk(SDL_RWops *src, Chunk *chunk, int borrow)
 {
 	chunk->magic	= SDL_ReadLE32(src);
 	chunk->length	= SDL_ReadLE32(src);
+
+	/* If asked to, point at the data where it is instead of copying it */
+	chunk->borrowed = 0;
+	if ( borrow ) {
+		chunk->data = (Uint8 *)SDL_RWBorrow(src, SDL_RWtell(src), chunk->length);
+		if ( chunk->data != NULL ) {
+			SDL_RWseek(src, chunk->length, RW_SEEK_CUR);
+			chunk->borrowed = 1;
+			return(chunk->length);
+		}
+	}
+
 	chunk->data = (Uint8 *)SDL_malloc(chunk->length);
 	if ( chunk->data == NULL ) {
 		SDL_Error(SDL_ENOMEM);
@@ -598,3 +652,333 @@ static int ReadChunk(SDL_RWops *src, Chunk *chunk)
 	}
 	return(chunk->length);
 }
+
+/* Incremental WAVE reading, for audio too long to load all at once.
+
+   The headers are parsed once when the stream is opened, and the audio
+   data is then read or decoded a block at a time into a buffer supplied
+   by the caller.  If the source is a memory stream, the data is used in
+   place: PCM can be handed out without copying it at all, and ADPCM is
+   decoded straight from memory.
+*/
+
+#define NO_BLOCK	0xFFFFFFFF
+
+struct SDL_WAVStream {
+	SDL_RWops *src;
+	int freesrc;
+	int encoding;
+	Uint32 frame_size;	/* Bytes per decoded sample frame */
+	Uint32 block_size;	/* Bytes per encoded block */
+	Uint32 block_frames;	/* Sample frames per block, 1 for PCM */
+	int data_start;		/* Offset of the audio data in the source */
+	Uint32 frames;		/* Sample frames in the stream */
+	Uint32 position;	/* Next sample frame to read */
+	const Uint8 *mapped;	/* The audio data, when the source is memory */
+	Uint32 src_block;	/* Block the source is positioned at */
+	Uint32 decoded_block;	/* Block held in 'decoded', or NO_BLOCK */
+	Uint8 *encoded;
+	Uint8 *decoded;
+	struct MS_ADPCM_decoder MS_ADPCM_state;
+	struct IMA_ADPCM_decoder IMA_ADPCM_state;
+};
+
+SDL_WAVStream * SDL_OpenWAVStream_RW(SDL_RWops *src, int freesrc,
+						SDL_AudioSpec *spec)
+{
+	SDL_WAVStream *stream;
+	Chunk chunk;
+	WaveFMT *format;
+	Uint32 RIFFchunk, WAVEmagic, data_len, header[2];
+	Uint32 channels, samples, needed;
+	int end;
+
+	/* Make sure we are passed a valid data source */
+	if ( src == NULL ) {
+		return(NULL);
+	}
+	stream = (SDL_WAVStream *)SDL_malloc(sizeof(*stream));
+	if ( stream == NULL ) {
+		SDL_OutOfMemory();
+		if ( freesrc ) {
+			SDL_RWclose(src);
+		}
+		return(NULL);
+	}
+	SDL_memset(stream, 0, sizeof(*stream));
+	stream->src = src;
+	stream->freesrc = freesrc;
+
+	/* Check the magic header, as SDL_LoadWAV_RW() does */
+	RIFFchunk	= SDL_ReadLE32(src);
+	WAVEmagic	= SDL_ReadLE32(src);
+	if ( WAVEmagic == WAVE ) { /* The RIFFchunk has already been read */
+		RIFFchunk = RIFF;
+	} else {
+		WAVEmagic = SDL_ReadLE32(src);
+	}
+	if ( (RIFFchunk != RIFF) || (WAVEmagic != WAVE) ) {
+		SDL_SetError("Unrecognized file type (not WAVE)");
+		goto error;
+	}
+
+	/* Read the audio data format chunk */
+	chunk.data = NULL;
+	do {
+		if ( chunk.data != NULL ) {
+			SDL_free(chunk.data);
+			chunk.data = NULL;
+		}
+		if ( ReadChunk(src, &chunk, 0) < 0 ) {
+			goto error;
+		}
+	} while ( (chunk.magic == FACT) || (chunk.magic == LIST) );
+
+	/* Decode the audio data format */
+	format = (WaveFMT *)chunk.data;
+	if ( chunk.magic != FMT ) {
+		SDL_SetError("Complex WAVE files not supported");
+		SDL_free(format);
+		goto error;
+	}
+	stream->encoding = InitWAVFormat(format, spec,
+			&stream->MS_ADPCM_state, &stream->IMA_ADPCM_state);
+	SDL_free(format);
+	if ( stream->encoding < 0 ) {
+		goto error;
+	}
+
+	/* Find the audio data chunk, skipping over anything else */
+	for ( ; ; ) {
+		if ( SDL_RWread(src, header, sizeof(header), 1) != 1 ) {
+			SDL_SetError("No audio data in WAVE file");
+			goto error;
+		}
+		if ( SDL_SwapLE32(header[0]) == DATA ) {
+			break;
+		}
+		if ( SDL_RWseek(src, SDL_SwapLE32(header[1]), RW_SEEK_CUR) < 0 ) {
+			goto error;
+		}
+	}
+	data_len = SDL_SwapLE32(header[1]);
+	stream->data_start = SDL_RWtell(src);
+
+	/* Files that were still being written may claim more data */
+	end = SDL_RWseek(src, 0, RW_SEEK_END);
+	if ( (end >= stream->data_start) &&
+	     (data_len > (Uint32)(end - stream->data_start)) ) {
+		data_len = end - stream->data_start;
+	}
+	SDL_RWseek(src, stream->data_start, RW_SEEK_SET);
+
+	/* Work out the size of the blocks we'll be reading */
+	channels = spec->channels;
+	stream->frame_size = ((spec->format & 0xFF)/8)*channels;
+	if ( stream->frame_size == 0 ) {
+		SDL_SetError("No channels in WAVE file");
+		goto error;
+	}
+	switch (stream->encoding) {
+		case MS_ADPCM_CODE:
+			samples = stream->MS_ADPCM_state.wSamplesPerBlock;
+			stream->block_size = stream->MS_ADPCM_state.wavefmt.blockalign;
+			stream->block_frames = samples;
+			needed = 7*channels + ((samples-2)*channels+1)/2;
+			if ( (channels > 2) || (samples < 2) ) {
+				needed = 0xFFFFFFFF;
+			}
+			break;
+		case IMA_ADPCM_CODE:
+			samples = stream->IMA_ADPCM_state.wSamplesPerBlock;
+			stream->block_size = stream->IMA_ADPCM_state.wavefmt.blockalign;
+			stream->block_frames = samples;
+			/* Decoding goes in groups of 8 after the first sample */
+			samples = 1 + ((samples+6)/8)*8;
+			needed = 4*channels + ((samples-1)/8)*4*channels;
+			if ( stream->block_frames < 1 ) {
+				needed = 0xFFFFFFFF;
+			}
+			break;
+		default:
+			samples = 1;
+			stream->block_size = stream->frame_size;
+			stream->block_frames = 1;
+			needed = stream->frame_size;
+			break;
+	}
+	if ( stream->block_size < needed ) {
+		SDL_SetError("Invalid ADPCM block size");
+		goto error;
+	}
+	stream->frames = (data_len / stream->block_size) * stream->block_frames;
+	stream->src_block = 0;
+	stream->decoded_block = NO_BLOCK;
+
+	/* Use the data in place if it's already in memory */
+	if ( (src->read == SDL_RWReadWindow) &&
+	     ((src->type == SDL_RWOPS_MEMORY) ||
+	      (src->type == SDL_RWOPS_MEMORY_RO)) ) {
+		stream->mapped = src->hidden.mem.base + stream->data_start;
+	}
+
+	if ( stream->encoding != PCM_CODE ) {
+		if ( ! stream->mapped ) {
+			stream->encoded = (Uint8 *)SDL_malloc(stream->block_size);
+		}
+		stream->decoded = (Uint8 *)SDL_malloc(samples*stream->frame_size);
+		if ( (!stream->mapped && !stream->encoded) || !stream->decoded ) {
+			SDL_OutOfMemory();
+			goto error;
+		}
+	}
+	return(stream);
+
+error:
+	SDL_CloseWAVStream(stream);
+	return(NULL);
+}
+
+/* Decode the given block of ADPCM data into stream->decoded */
+static int DecodeWAVBlock(SDL_WAVStream *stream, Uint32 block)
+{
+	const Uint8 *encoded;
+
+	if ( stream->mapped ) {
+		encoded = stream->mapped + block*stream->block_size;
+	} else {
+		if ( stream->src_block != block ) {
+			SDL_RWseek(stream->src,
+				stream->data_start + block*stream->block_size,
+				RW_SEEK_SET);
+		}
+		if ( SDL_RWread(stream->src, stream->encoded,
+					stream->block_size, 1) != 1 ) {
+			stream->src_block = NO_BLOCK;
+			SDL_Error(SDL_EFREAD);
+			return(-1);
+		}
+		stream->src_block = block + 1;
+		encoded = stream->encoded;
+	}
+	if ( stream->encoding == MS_ADPCM_CODE ) {
+		MS_ADPCM_decode_block(&stream->MS_ADPCM_state,
+					encoded, stream->decoded);
+	} else {
+		IMA_ADPCM_decode_block(&stream->IMA_ADPCM_state,
+					encoded, stream->decoded);
+	}
+	stream->decoded_block = block;
+	return(0);
+}
+
+int SDL_ReadWAVStream(SDL_WAVStream *stream, Uint8 *buf, Uint32 frames)
+{
+	Uint32 done, block, offset, amount;
+	int got;
+
+	if ( frames > (stream->frames - stream->position) ) {
+		frames = stream->frames - stream->position;
+	}
+
+	/* Uncompressed data is read straight into the caller's buffer */
+	if ( stream->encoding == PCM_CODE ) {
+		if ( stream->mapped ) {
+			SDL_memcpy(buf, stream->mapped +
+				stream->position*stream->frame_size,
+				frames*stream->frame_size);
+			stream->position += frames;
+			return(frames);
+		}
+		if ( stream->src_block != stream->position ) {
+			SDL_RWseek(stream->src, stream->data_start +
+				stream->position*stream->frame_size,
+				RW_SEEK_SET);
+		}
+		got = 0;
+		if ( frames > 0 ) {
+			got = SDL_RWread(stream->src, buf,
+					stream->frame_size, frames);
+		}
+		if ( got < 0 ) {
+			stream->src_block = NO_BLOCK;
+			return(-1);
+		}
+		stream->position += got;
+		stream->src_block = stream->position;
+		return(got);
+	}
+
+	/* ADPCM is decoded a block at a time and copied out */
+	for ( done = 0; done < frames; done += amount ) {
+		block = stream->position / stream->block_frames;
+		if ( block != stream->decoded_block ) {
+			if ( DecodeWAVBlock(stream, block) < 0 ) {
+				return(done ? (int)done : -1);
+			}
+		}
+		offset = stream->position - block*stream->block_frames;
+		amount = stream->block_frames - offset;
+		if ( amount > (frames - done) ) {
+			amount = frames - done;
+		}
+		SDL_memcpy(buf, stream->decoded + offset*stream->frame_size,
+					amount*stream->frame_size);
+		buf += amount*stream->frame_size;
+		stream->position += amount;
+	}
+	return(done);
+}
+
+const Uint8 * SDL_MapWAVStream(SDL_WAVStream *stream, Uint32 *frames)
+{
+	const Uint8 *data;
+
+	if ( (stream->encoding != PCM_CODE) || !stream->mapped ) {
+		SDL_SetError("WAVE stream isn't PCM in memory");
+		return(NULL);
+	}
+	if ( *frames > (stream->frames - stream->position) ) {
+		*frames = stream->frames - stream->position;
+	}
+	data = stream->mapped + stream->position*stream->frame_size;
+	stream->position += *frames;
+	return(data);
+}
+
+int SDL_SeekWAVStream(SDL_WAVStream *stream, Uint32 frame)
+{
+	if ( frame > stream->frames ) {
+		SDL_SetError("Seek past the end of the WAVE stream");
+		return(-1);
+	}
+	/* The source is moved, and a block decoded, on the next read */
+	stream->position = frame;
+	return(0);
+}
+
+Uint32 SDL_TellWAVStream(SDL_WAVStream *stream)
+{
+	return(stream->position);
+}
+
+Uint32 SDL_GetWAVStreamLength(SDL_WAVStream *stream)
+{
+	return(stream->frames);
+}
+
+void SDL_CloseWAVStream(SDL_WAVStream *stream)
+{
+	if ( stream != NULL ) {
+		if ( stream->freesrc ) {
+			SDL_RWclose(stream->src);
+		}
+		if ( stream->encoded ) {
+			SDL_free(stream->encoded);
+		}
+		if ( stream->decoded ) {
+			SDL_free(stream->decoded);
+		}
+		SDL_free(stream);
+	}
+}
@@ -58,5 +58,6 @@ typedef struct Chunk {
 	Uint32 magic;
 	Uint32 length;
 	Uint8 *data;
+	int borrowed;		/* data points into the source */
 } Chunk;
 
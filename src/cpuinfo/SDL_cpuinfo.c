@@ -26,6 +26,13 @@
 #include "SDL.h"
 #include "SDL_cpuinfo.h"
 
+#if defined(__WIN32__)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>	/* For the CPU count */
+#elif defined(HAVE_SYSCONF)
+#include <unistd.h>	/* For the CPU count */
+#endif
+
 #if defined(__MACOSX__) && defined(__ppc__)
 #include <sys/sysctl.h> /* For AltiVec check */
 #elif SDL_ALTIVEC_BLITTERS && HAVE_SETJMP
@@ -41,6 +48,7 @@
 #define CPU_HAS_SSE	0x00000040
 #define CPU_HAS_SSE2	0x00000080
 #define CPU_HAS_ALTIVEC	0x00000100
+#define CPU_HAS_NEON	0x00000200
 
 #if SDL_ALTIVEC_BLITTERS && HAVE_SETJMP && !__MACOSX__
 /* This is the brute force way of detecting instruction sets...
@@ -361,6 +369,16 @@ static __inline__ int CPU_haveAltiVec(void)
 	return altivec; 
 }
 
+static __inline__ int CPU_haveNEON(void)
+{
+	int neon = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+	/* The compiler only emits NEON code when the target ABI guarantees it */
+	neon = 1;
+#endif
+	return neon;
+}
+
 static Uint32 SDL_CPUFeatures = 0xFFFFFFFF;
 
 static Uint32 SDL_GetCPUFeatures(void)
@@ -391,6 +409,9 @@ static Uint32 SDL_GetCPUFeatures(void)
 		if ( CPU_haveAltiVec() ) {
 			SDL_CPUFeatures |= CPU_HAS_ALTIVEC;
 		}
+		if ( CPU_haveNEON() ) {
+			SDL_CPUFeatures |= CPU_HAS_NEON;
+		}
 	}
 	return SDL_CPUFeatures;
 }
@@ -459,6 +480,33 @@ SDL_bool SDL_HasAltiVec(void)
 	return SDL_FALSE;
 }
 
+SDL_bool SDL_HasNEON(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_NEON ) {
+		return SDL_TRUE;
+	}
+	return SDL_FALSE;
+}
+
+static int SDL_CPUCount = 0;
+
+int SDL_GetCPUCount(void)
+{
+	if ( SDL_CPUCount <= 0 ) {
+#if defined(__WIN32__)
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		SDL_CPUCount = (int)info.dwNumberOfProcessors;
+#elif defined(HAVE_SYSCONF) && defined(_SC_NPROCESSORS_ONLN)
+		SDL_CPUCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+		if ( SDL_CPUCount <= 0 ) {
+			SDL_CPUCount = 1;
+		}
+	}
+	return SDL_CPUCount;
+}
+
 #ifdef TEST_MAIN
 
 #include <stdio.h>
@@ -473,6 +521,8 @@ int main()
 	printf("SSE: %d\n", SDL_HasSSE());
 	printf("SSE2: %d\n", SDL_HasSSE2());
 	printf("AltiVec: %d\n", SDL_HasAltiVec());
+	printf("NEON: %d\n", SDL_HasNEON());
+	printf("CPUs: %d\n", SDL_GetCPUCount());
 	return 0;
 }
 
@@ -37,18 +37,36 @@ SDL_EventFilter SDL_EventOK = NULL;
 Uint8 SDL_ProcessEvents[SDL_NUMEVENTS];
 static Uint32 SDL_eventstate = 0;
 
-/* Private data -- event queue */
+/* Private data -- event queue
+   The queue starts out with MAXEVENTS slots and doubles whenever it fills
+   up, until it reaches MAXQUEUEDEVENTS.  Events cut from the middle of the
+   queue are only marked as cut, and skipped until the queue is compacted.
+ */
 #define MAXEVENTS	128
+#define MAXQUEUEDEVENTS	65536
+
+/* How often SDL_WaitEvent() pumps events when nothing else can wake it */
+#define SDL_EVENT_POLL_INTERVAL	10
 static struct {
 	SDL_mutex *lock;
+	SDL_cond *wait;
+	int native_wait;	/* The waiter is blocked in the video driver */
 	int active;
 	int head;
 	int tail;
-	SDL_Event event[MAXEVENTS];
+	int size;		/* Number of slots, always a power of two */
+	int numcut;		/* Number of cut slots between head and tail */
+	SDL_Event *event;
+	Uint8 *cut;
+	SDL_EventQueueStats stats;
 	int wmmsg_next;
 	struct SDL_SysWMmsg wmmsg[MAXEVENTS];
 } SDL_EventQ;
 
+/* Private data -- merge motion events into ones still in the queue */
+#define MAXCOALESCESCAN	16
+static int SDL_CoalesceEvents = 0;
+
 /* Private data -- event locking structure */
 static struct {
 	SDL_mutex *lock;
@@ -157,6 +175,8 @@ static int SDL_StartEventThread(Uint32 flags)
 		return(-1);
 #endif
 	}
+	/* Without a wait condition SDL_WaitEvent() falls back to polling */
+	SDL_EventQ.wait = SDL_CreateCond();
 #endif /* !SDL_THREADS_DISABLED */
 	SDL_EventQ.active = 1;
 
@@ -187,12 +207,17 @@ static int SDL_StartEventThread(Uint32 flags)
 static void SDL_StopEventThread(void)
 {
 	SDL_EventQ.active = 0;
+	SDL_WakeEventWait();
 	if ( SDL_EventThread ) {
 		SDL_WaitThread(SDL_EventThread, NULL);
 		SDL_EventThread = NULL;
 		SDL_DestroyMutex(SDL_EventLock.lock);
 		SDL_EventLock.lock = NULL;
 	}
+	if ( SDL_EventQ.wait ) {
+		SDL_DestroyCond(SDL_EventQ.wait);
+		SDL_EventQ.wait = NULL;
+	}
 #ifndef IPOD
 	SDL_DestroyMutex(SDL_EventQ.lock);
 	SDL_EventQ.lock = NULL;
@@ -218,8 +243,16 @@ void SDL_StopEventLoop(void)
 	SDL_QuitQuit();
 
 	/* Clean out EventQ */
+	if ( SDL_EventQ.event ) {
+		SDL_free(SDL_EventQ.event);
+		SDL_EventQ.event = NULL;
+		SDL_EventQ.cut = NULL;
+	}
 	SDL_EventQ.head = 0;
 	SDL_EventQ.tail = 0;
+	SDL_EventQ.size = 0;
+	SDL_EventQ.numcut = 0;
+	SDL_memset(&SDL_EventQ.stats, 0, sizeof(SDL_EventQ.stats));
 	SDL_EventQ.wmmsg_next = 0;
 }
 
@@ -227,10 +260,12 @@ void SDL_StopEventLoop(void)
 int SDL_StartEventLoop(Uint32 flags)
 {
 	int retcode;
+	const char *env;
 
 	/* Clean out the event queue */
 	SDL_EventThread = NULL;
 	SDL_EventQ.lock = NULL;
+	SDL_EventQ.wait = NULL;
 	SDL_StopEventLoop();
 
 	/* No filter to start with, process most event types */
@@ -241,6 +276,13 @@ int SDL_StartEventLoop(Uint32 flags)
 	SDL_eventstate &= ~(0x00000001 << SDL_SYSWMEVENT);
 	SDL_ProcessEvents[SDL_SYSWMEVENT] = SDL_IGNORE;
 
+	/* Allow environment override to merge high rate motion events */
+	SDL_CoalesceEvents = 0;
+	env = SDL_getenv("SDL_EVENT_COALESCING");
+	if ( env ) {
+		SDL_CoalesceEvents = SDL_atoi(env);
+	}
+
 	/* Initialize event handlers */
 	retcode = 0;
 	retcode += SDL_AppActiveInit();
@@ -261,60 +303,129 @@ int SDL_StartEventLoop(Uint32 flags)
 }
 
 
+/* Move the queued events into a new buffer of 'size' slots, dropping the
+   cut slots on the way -- called with the queue locked */
+static int SDL_ResizeEventQ(int size)
+{
+	SDL_Event *event;
+	Uint8 *cut;
+	int spot, used;
+
+	event = (SDL_Event *)SDL_malloc(size*(sizeof(*event)+sizeof(*cut)));
+	if ( event == NULL ) {
+		return(-1);
+	}
+	cut = (Uint8 *)&event[size];
+	SDL_memset(cut, 0, size*sizeof(*cut));
+
+	used = 0;
+	for ( spot = SDL_EventQ.head; spot != SDL_EventQ.tail;
+	      spot = (spot+1)&(SDL_EventQ.size-1) ) {
+		if ( ! SDL_EventQ.cut[spot] ) {
+			event[used++] = SDL_EventQ.event[spot];
+		}
+	}
+	if ( SDL_EventQ.event ) {
+		SDL_free(SDL_EventQ.event);
+	}
+	SDL_EventQ.event = event;
+	SDL_EventQ.cut = cut;
+	SDL_EventQ.size = size;
+	SDL_EventQ.head = 0;
+	SDL_EventQ.tail = used;
+	SDL_EventQ.numcut = 0;
+	SDL_EventQ.stats.capacity = size-1;
+	return(0);
+}
+
 /* Add an event to the event queue -- called with the queue locked */
 static int SDL_AddEvent(SDL_Event *event)
 {
-	int tail, added;
+	int tail;
 
-	tail = (SDL_EventQ.tail+1)%MAXEVENTS;
-	if ( tail == SDL_EventQ.head ) {
-		/* Overflow, drop event */
-		added = 0;
-	} else {
-		SDL_EventQ.event[SDL_EventQ.tail] = *event;
-		if (event->type == SDL_SYSWMEVENT) {
-			/* Note that it's possible to lose an event */
-			int next = SDL_EventQ.wmmsg_next;
-			SDL_EventQ.wmmsg[next] = *event->syswm.msg;
-		        SDL_EventQ.event[SDL_EventQ.tail].syswm.msg =
-						&SDL_EventQ.wmmsg[next];
-			SDL_EventQ.wmmsg_next = (next+1)%MAXEVENTS;
+	tail = (SDL_EventQ.tail+1)&(SDL_EventQ.size-1);
+	if ( (SDL_EventQ.size == 0) || (tail == SDL_EventQ.head) ) {
+		/* Full -- reclaim the cut slots if they're worth it, else grow */
+		int size = SDL_EventQ.size;
+		if ( size == 0 ) {
+			size = MAXEVENTS;
+		} else if ( SDL_EventQ.numcut < size/4 ) {
+			size *= 2;
 		}
-		SDL_EventQ.tail = tail;
-		added = 1;
+		if ( (size > MAXQUEUEDEVENTS) || (SDL_ResizeEventQ(size) < 0) ) {
+			/* Overflow, drop event */
+			++SDL_EventQ.stats.dropped;
+			return(0);
+		}
+		tail = (SDL_EventQ.tail+1)&(SDL_EventQ.size-1);
+	}
+
+	SDL_EventQ.event[SDL_EventQ.tail] = *event;
+	SDL_EventQ.cut[SDL_EventQ.tail] = 0;
+	if (event->type == SDL_SYSWMEVENT) {
+		/* Note that it's possible to lose an event */
+		int next = SDL_EventQ.wmmsg_next;
+		SDL_EventQ.wmmsg[next] = *event->syswm.msg;
+	        SDL_EventQ.event[SDL_EventQ.tail].syswm.msg =
+					&SDL_EventQ.wmmsg[next];
+		SDL_EventQ.wmmsg_next = (next+1)%MAXEVENTS;
 	}
-	return(added);
+	SDL_EventQ.tail = tail;
+
+	++SDL_EventQ.stats.queued;
+	if ( SDL_EventQ.stats.queued > SDL_EventQ.stats.peak ) {
+		SDL_EventQ.stats.peak = SDL_EventQ.stats.queued;
+	}
+	return(1);
 }
 
 /* Cut an event, and return the next valid spot, or the tail */
 /*                           -- called with the queue locked */
 static int SDL_CutEvent(int spot)
 {
+	int mask = SDL_EventQ.size-1;
+
+	--SDL_EventQ.stats.queued;
 	if ( spot == SDL_EventQ.head ) {
-		SDL_EventQ.head = (SDL_EventQ.head+1)%MAXEVENTS;
+		/* Advance the head past any slots cut behind it */
+		SDL_EventQ.head = (spot+1)&mask;
+		while ( (SDL_EventQ.head != SDL_EventQ.tail) &&
+		        SDL_EventQ.cut[SDL_EventQ.head] ) {
+			SDL_EventQ.head = (SDL_EventQ.head+1)&mask;
+			--SDL_EventQ.numcut;
+		}
 		return(SDL_EventQ.head);
 	} else
-	if ( (spot+1)%MAXEVENTS == SDL_EventQ.tail ) {
+	if ( ((spot+1)&mask) == SDL_EventQ.tail ) {
+		/* Pull the tail back past any slots cut in front of it */
 		SDL_EventQ.tail = spot;
+		while ( (SDL_EventQ.tail != SDL_EventQ.head) &&
+		        SDL_EventQ.cut[(SDL_EventQ.tail-1)&mask] ) {
+			SDL_EventQ.tail = (SDL_EventQ.tail-1)&mask;
+			--SDL_EventQ.numcut;
+		}
 		return(SDL_EventQ.tail);
 	} else
-	/* We cut the middle -- shift everything over */
+	/* We cut the middle -- leave a hole and skip it from now on */
 	{
-		int here, next;
-
-		/* This can probably be optimized with SDL_memcpy() -- careful! */
-		if ( --SDL_EventQ.tail < 0 ) {
-			SDL_EventQ.tail = MAXEVENTS-1;
-		}
-		for ( here=spot; here != SDL_EventQ.tail; here = next ) {
-			next = (here+1)%MAXEVENTS;
-			SDL_EventQ.event[here] = SDL_EventQ.event[next];
-		}
-		return(spot);
+		SDL_EventQ.cut[spot] = 1;
+		++SDL_EventQ.numcut;
+		return((spot+1)&mask);
 	}
 	/* NOTREACHED */
 }
 
+/* Wake the thread in SDL_WaitEvent(), called with the queue locked */
+static void SDL_WakeWaiter(void)
+{
+	if ( SDL_EventQ.wait ) {
+		SDL_CondBroadcast(SDL_EventQ.wait);
+	}
+	if ( SDL_EventQ.native_wait && current_video ) {
+		current_video->WakeEvents(current_video);
+	}
+}
+
 /* Lock the event queue, take a peep at it, and unlock it */
 int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 								Uint32 mask)
@@ -332,6 +443,9 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 			for ( i=0; i<numevents; ++i ) {
 				used += SDL_AddEvent(&events[i]);
 			}
+			if ( used ) {
+				SDL_WakeWaiter();
+			}
 		} else {
 			SDL_Event tmpevent;
 			int spot;
@@ -344,15 +458,18 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 			}
 			spot = SDL_EventQ.head;
 			while ((used < numevents)&&(spot != SDL_EventQ.tail)) {
+				if ( SDL_EventQ.cut[spot] ) {
+					spot = (spot+1)&(SDL_EventQ.size-1);
+				} else
 				if ( mask & SDL_EVENTMASK(SDL_EventQ.event[spot].type) ) {
 					events[used++] = SDL_EventQ.event[spot];
 					if ( action == SDL_GETEVENT ) {
 						spot = SDL_CutEvent(spot);
 					} else {
-						spot = (spot+1)%MAXEVENTS;
+						spot = (spot+1)&(SDL_EventQ.size-1);
 					}
 				} else {
-					spot = (spot+1)%MAXEVENTS;
+					spot = (spot+1)&(SDL_EventQ.size-1);
 				}
 			}
 		}
@@ -400,16 +517,192 @@ int SDL_PollEvent (SDL_Event *event)
 	return 1;
 }
 
-int SDL_WaitEvent (SDL_Event *event)
+/* Wake up any thread blocked in SDL_WaitEvent() so it pumps events again */
+void SDL_WakeEventWait(void)
+{
+	if ( SDL_EventQ.lock && (SDL_mutexP(SDL_EventQ.lock) == 0) ) {
+		SDL_WakeWaiter();
+		SDL_mutexV(SDL_EventQ.lock);
+	}
+}
+
+/* Return 1 if SDL_WaitEvent() can block in the video driver itself, which
+   then wakes it as soon as the OS has an event for us.
+ */
+static int SDL_CanWaitNative(void)
+{
+	return( !SDL_EventThread && current_video &&
+	        current_video->WaitEvents && current_video->WakeEvents );
+}
+
+/* Return the longest time the waiting thread may block without pumping.
+   When the event thread is running it does the pumping and queues events
+   through SDL_PeepEvents(), which signals us.  A video driver that can
+   wait for its own events wakes us too.  Otherwise the native event
+   sources, key repeat and joysticks have to be polled from this thread.
+ */
+static Uint32 SDL_EventWaitSlice(void)
+{
+	if ( SDL_EventThread ) {
+		return(SDL_MUTEX_MAXWAIT);
+	}
+	if ( current_video ) {
+		if ( !SDL_CanWaitNative() || SDL_KeyRepeatPending() ) {
+			return(SDL_EVENT_POLL_INTERVAL);
+		}
+	}
+#if !SDL_JOYSTICK_DISABLED
+	if ( SDL_numjoysticks && (SDL_eventstate & SDL_JOYEVENTMASK) ) {
+		return(SDL_EVENT_POLL_INTERVAL);
+	}
+#endif
+	return(SDL_MUTEX_MAXWAIT);
+}
+
+int SDL_WaitEventTimeout (SDL_Event *event, Uint32 timeout)
 {
+	Uint32 start, elapsed, slice;
+
+	start = SDL_GetTicks();
 	while ( 1 ) {
 		SDL_PumpEvents();
 		switch(SDL_PeepEvents(event, 1, SDL_GETEVENT, SDL_ALLEVENTS)) {
 		    case -1: return 0;
 		    case 1: return 1;
-		    case 0: SDL_Delay(10);
+		    case 0: break;
+		}
+
+		slice = SDL_EventWaitSlice();
+		if ( timeout != SDL_MUTEX_MAXWAIT ) {
+			elapsed = SDL_GetTicks() - start;
+			if ( elapsed >= timeout ) {
+				return 0;
+			}
+			if ( slice > (timeout - elapsed) ) {
+				slice = (timeout - elapsed);
+			}
+		}
+
+		if ( SDL_EventQ.wait == NULL ) {
+			SDL_Delay((slice < SDL_EVENT_POLL_INTERVAL) ?
+			          slice : SDL_EVENT_POLL_INTERVAL);
+			continue;
+		}
+
+		/* Recheck under the lock so a wakeup can't slip in unseen */
+		if ( SDL_mutexP(SDL_EventQ.lock) < 0 ) {
+			return 0;
+		}
+		if ( SDL_EventQ.active && (SDL_EventQ.head == SDL_EventQ.tail) ) {
+			if ( SDL_CanWaitNative() ) {
+				SDL_EventQ.native_wait = 1;
+				SDL_mutexV(SDL_EventQ.lock);
+				current_video->WaitEvents(current_video, slice);
+				SDL_mutexP(SDL_EventQ.lock);
+				SDL_EventQ.native_wait = 0;
+			} else if ( slice == SDL_MUTEX_MAXWAIT ) {
+				SDL_CondWait(SDL_EventQ.wait, SDL_EventQ.lock);
+			} else {
+				SDL_CondWaitTimeout(SDL_EventQ.wait, SDL_EventQ.lock, slice);
+			}
+		}
+		SDL_mutexV(SDL_EventQ.lock);
+	}
+}
+
+int SDL_WaitEvent (SDL_Event *event)
+{
+	return SDL_WaitEventTimeout(event, SDL_MUTEX_MAXWAIT);
+}
+
+/* Merge a motion event into a queued one for the same device and axis,
+   returning 1 if it was merged -- called with the queue locked.
+   Only the motion events at the end of the queue are looked at, so the
+   merged event never moves past a button or key event.
+ */
+static int SDL_MergeEvent(SDL_Event *event)
+{
+	int spot, scanned;
+	SDL_Event *queued;
+
+	spot = SDL_EventQ.tail;
+	for ( scanned = 0; scanned < MAXCOALESCESCAN; ++scanned ) {
+		if ( spot == SDL_EventQ.head ) {
+			break;
+		}
+		spot = (spot-1)&(SDL_EventQ.size-1);
+		if ( SDL_EventQ.cut[spot] ) {
+			continue;
+		}
+		queued = &SDL_EventQ.event[spot];
+		if ( queued->type == SDL_MOUSEMOTION ) {
+			if ( event->type == SDL_MOUSEMOTION &&
+			     queued->motion.which == event->motion.which ) {
+				int xrel = queued->motion.xrel + event->motion.xrel;
+				int yrel = queued->motion.yrel + event->motion.yrel;
+				if ( xrel < -32768 || xrel > 32767 ||
+				     yrel < -32768 || yrel > 32767 ) {
+					break;
+				}
+				queued->motion.state = event->motion.state;
+				queued->motion.x = event->motion.x;
+				queued->motion.y = event->motion.y;
+				queued->motion.xrel = (Sint16)xrel;
+				queued->motion.yrel = (Sint16)yrel;
+				return(1);
+			}
+		} else
+		if ( queued->type == SDL_JOYAXISMOTION ) {
+			if ( event->type == SDL_JOYAXISMOTION &&
+			     queued->jaxis.which == event->jaxis.which &&
+			     queued->jaxis.axis == event->jaxis.axis ) {
+				queued->jaxis.value = event->jaxis.value;
+				return(1);
+			}
+		} else {
+			break;
 		}
 	}
+	return(0);
+}
+
+/* Queue a mouse or joystick axis motion event, merging it into a pending
+   one if SDL_EVENT_COALESCING is set in the environment.
+ */
+int SDL_PushMotionEvent(SDL_Event *event)
+{
+	int merged;
+
+	if ( ! SDL_CoalesceEvents ) {
+		return SDL_PushEvent(event);
+	}
+	if ( ! SDL_EventQ.active ) {
+		return -1;
+	}
+	if ( SDL_mutexP(SDL_EventQ.lock) < 0 ) {
+		return -1;
+	}
+	merged = SDL_MergeEvent(event);
+	SDL_mutexV(SDL_EventQ.lock);
+	if ( merged ) {
+		return 0;
+	}
+	return SDL_PushEvent(event);
+}
+
+int SDL_GetEventQueueStats(SDL_EventQueueStats *stats)
+{
+	if ( ! SDL_EventQ.active ) {
+		SDL_SetError("Event queue isn't running");
+		return(-1);
+	}
+	if ( SDL_mutexP(SDL_EventQ.lock) < 0 ) {
+		SDL_SetError("Couldn't lock event queue");
+		return(-1);
+	}
+	*stats = SDL_EventQ.stats;
+	SDL_mutexV(SDL_EventQ.lock);
+	return(0);
 }
 
 int SDL_PushEvent(SDL_Event *event)
@@ -33,6 +33,12 @@ extern void SDL_Lock_EventThread(void);
 extern void SDL_Unlock_EventThread(void);
 extern Uint32 SDL_EventThreadID(void);
 
+/* Used by drivers that get native events outside of PumpEvents() (e.g. on
+   their own input thread) to wake up a thread blocked in SDL_WaitEvent(),
+   whether it waits on the queue or in the driver's WaitEvents()
+ */
+extern void SDL_WakeEventWait(void);
+
 /* Event handler init routines */
 extern int  SDL_AppActiveInit(void);
 extern int  SDL_KeyboardInit(void);
@@ -64,6 +70,9 @@ extern int SDL_PrivateExpose(void);
 extern int SDL_PrivateQuit(void);
 extern int SDL_PrivateSysWMEvent(SDL_SysWMmsg *message);
 
+/* Used by the motion handlers to queue events that may be coalesced */
+extern int SDL_PushMotionEvent(SDL_Event *event);
+
 /* Used to clamp the mouse coordinates separately from the video surface */
 extern void SDL_SetMouseRange(int maxX, int maxY);
 
@@ -75,6 +84,7 @@ extern void SDL_ResetKeyboard(void);
 
 /* Used by the event loop to queue pending keyboard repeat events */
 extern void SDL_CheckKeyRepeat(void);
+extern int SDL_KeyRepeatPending(void);
 
 /* Used by the OS keyboard code to detect whether or not to do UNICODE */
 #ifndef DEFAULT_UNICODE_TRANSLATION
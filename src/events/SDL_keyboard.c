@@ -593,6 +593,12 @@ void SDL_CheckKeyRepeat(void)
 	}
 }
 
+/* Used by SDL_WaitEvent() to keep pumping while a key is held down */
+int SDL_KeyRepeatPending(void)
+{
+	return(SDL_KeyRepeat.timestamp != 0);
+}
+
 int SDL_EnableKeyRepeat(int delay, int interval)
 {
 	if ( (delay < 0) || (interval < 0) ) {
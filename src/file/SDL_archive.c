@@ -0,0 +1,509 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Pack files, with members read through SDL_RWops
+
+   The header, directory and name table are read with one read when the
+   pack is opened, and the directory is indexed by an open addressing hash
+   table.  Member streams only keep their own position, and read with
+   pread() on the descriptor shared by the whole archive, so they can be
+   used from any thread.  Without pread() the archive keeps a stream on
+   the pack file, and each read seeks and reads it under a mutex.
+*/
+
+#include "SDL_archive.h"
+#include "SDL_mutex.h"
+
+#ifdef HAVE_PREAD
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#define ARCHIVE_MAGIC		0x504C4453	/* "SDLP" */
+#define ARCHIVE_VERSION		1
+#define ARCHIVE_HEADER_SIZE	16
+#define ARCHIVE_ENTRY_SIZE	20
+
+typedef struct {
+	Uint32 name;		/* Offset of the name in the name table */
+	Uint32 name_length;
+	Uint32 offset;		/* Offset of the data in the pack */
+	Uint32 size;
+	Uint32 hash;
+} archive_entry;
+
+struct SDL_Archive {
+#ifdef HAVE_PREAD
+	int fd;
+#else
+	SDL_RWops *file;
+	SDL_mutex *lock;
+#endif
+	Uint32 count;
+	archive_entry *entries;
+	const char *names;
+	Uint32 *table;		/* Index of each entry plus one, or 0 */
+	Uint32 mask;		/* Size of the table minus one */
+	Uint8 *directory;	/* The entries and names as read */
+};
+
+typedef struct {
+	SDL_RWops ops;
+	SDL_Archive *archive;
+	Uint32 offset;
+	Uint32 size;
+	Uint32 here;
+} member_rwops;
+
+static Uint32 archive_get32(const Uint8 *p)
+{
+	return((Uint32)p[0] | ((Uint32)p[1] << 8) |
+	       ((Uint32)p[2] << 16) | ((Uint32)p[3] << 24));
+}
+
+static Uint32 archive_hash(const char *name)
+{
+	Uint32 hash = 2166136261u;
+
+	while ( *name ) {
+		hash ^= (Uint8)*name++;
+		hash *= 16777619u;
+	}
+	return(hash);
+}
+
+/* Read 'size' bytes at 'offset' in the pack, returning how many were read
+   or -1 on error.  This is the only place the pack file is read from.
+ */
+static int archive_read(SDL_Archive *archive, void *ptr, Uint32 offset, int size)
+{
+	int total = 0;
+#ifdef HAVE_PREAD
+	ssize_t got;
+
+	while ( total < size ) {
+		got = pread(archive->fd, (Uint8 *)ptr + total,
+		            size - total, (off_t)offset + total);
+		if ( got < 0 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+			SDL_Error(SDL_EFREAD);
+			return(-1);
+		}
+		if ( got == 0 ) {
+			break;
+		}
+		total += got;
+	}
+#else
+	SDL_mutexP(archive->lock);
+	if ( SDL_RWseek(archive->file, offset, RW_SEEK_SET) < 0 ) {
+		total = -1;
+	} else if ( size > 0 ) {
+		total = SDL_RWread(archive->file, ptr, 1, size);
+	}
+	SDL_mutexV(archive->lock);
+#endif
+	return(total);
+}
+
+/* Functions to read archive members */
+
+static int SDLCALL member_seek(SDL_RWops *context, int offset, int whence)
+{
+	member_rwops *member = (member_rwops *)context;
+	int newpos;
+
+	switch (whence) {
+		case RW_SEEK_SET:
+			newpos = offset;
+			break;
+		case RW_SEEK_CUR:
+			newpos = member->here+offset;
+			break;
+		case RW_SEEK_END:
+			newpos = member->size+offset;
+			break;
+		default:
+			SDL_SetError("Unknown value for 'whence'");
+			return(-1);
+	}
+	if ( newpos < 0 ) {
+		newpos = 0;
+	}
+	if ( newpos > (int)member->size ) {
+		newpos = member->size;
+	}
+	member->here = newpos;
+	return(newpos);
+}
+static int SDLCALL member_read(SDL_RWops *context, void *ptr, int size, int maxnum)
+{
+	member_rwops *member = (member_rwops *)context;
+	size_t total_bytes;
+	int got;
+
+	total_bytes = (maxnum * size);
+	if ( (maxnum <= 0) || (size <= 0) || ((total_bytes / maxnum) != (size_t) size) ) {
+		return 0;
+	}
+	if ( total_bytes > (member->size - member->here) ) {
+		total_bytes = (member->size - member->here);
+	}
+
+	got = archive_read(member->archive, ptr,
+	                   member->offset + member->here, (int)total_bytes);
+	if ( got < 0 ) {
+		return(-1);
+	}
+	member->here += got;
+	return(got / size);
+}
+static int SDLCALL member_write(SDL_RWops *context, const void *ptr, int size, int num)
+{
+	SDL_SetError("Can't write to an archive member");
+	return(-1);
+}
+static int SDLCALL member_close(SDL_RWops *context)
+{
+	if ( context ) {
+		SDL_FreeRW(context);
+	}
+	return(0);
+}
+
+SDL_Archive *SDL_OpenArchive(const char *file)
+{
+	SDL_Archive *archive;
+	Uint8 header[ARCHIVE_HEADER_SIZE];
+	Uint32 i, names_size, directory_size, file_size, slot;
+	Uint8 *entry;
+	archive_entry *e;
+
+	if ( !file || !*file ) {
+		SDL_SetError("SDL_OpenArchive(): No file specified");
+		return(NULL);
+	}
+	archive = (SDL_Archive *)SDL_malloc(sizeof(*archive));
+	if ( archive == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_memset(archive, 0, sizeof(*archive));
+
+#ifdef HAVE_PREAD
+	archive->fd = open(file, O_RDONLY);
+	if ( archive->fd < 0 ) {
+		SDL_SetError("Couldn't open %s", file);
+		SDL_free(archive);
+		return(NULL);
+	}
+	file_size = (Uint32)lseek(archive->fd, 0, SEEK_END);
+#else
+	archive->file = SDL_RWFromFile(file, "rb");
+	if ( archive->file == NULL ) {
+		SDL_free(archive);
+		return(NULL);
+	}
+	archive->lock = SDL_CreateMutex();
+	if ( archive->lock == NULL ) {
+		SDL_CloseArchive(archive);
+		return(NULL);
+	}
+	file_size = (Uint32)SDL_RWseek(archive->file, 0, RW_SEEK_END);
+#endif
+
+	/* Check the header, and that the directory fits in the file */
+	if ( archive_read(archive, header, 0, sizeof(header)) != sizeof(header) ) {
+		goto bad_archive;
+	}
+	archive->count = archive_get32(&header[8]);
+	names_size = archive_get32(&header[12]);
+	if ( (archive_get32(&header[0]) != ARCHIVE_MAGIC) ||
+	     (archive_get32(&header[4]) != ARCHIVE_VERSION) ||
+	     (archive->count > (file_size / ARCHIVE_ENTRY_SIZE)) ) {
+		goto bad_archive;
+	}
+	directory_size = archive->count * ARCHIVE_ENTRY_SIZE;
+	if ( (directory_size > file_size - ARCHIVE_HEADER_SIZE) ||
+	     (names_size > file_size - ARCHIVE_HEADER_SIZE - directory_size) ) {
+		goto bad_archive;
+	}
+	directory_size += names_size;
+
+	/* Read the directory, and unpack the entries in place */
+	archive->directory = (Uint8 *)SDL_malloc(directory_size + 1);
+	for ( archive->mask = 1; archive->mask < archive->count*2; archive->mask *= 2 ) {
+		;
+	}
+	archive->table = (Uint32 *)SDL_malloc(archive->mask * sizeof(Uint32));
+	if ( !archive->directory || !archive->table ) {
+		SDL_OutOfMemory();
+		SDL_CloseArchive(archive);
+		return(NULL);
+	}
+	SDL_memset(archive->table, 0, archive->mask * sizeof(Uint32));
+	archive->mask -= 1;
+	if ( archive_read(archive, archive->directory, ARCHIVE_HEADER_SIZE,
+	                  directory_size) != (int)directory_size ) {
+		goto bad_archive;
+	}
+	archive->entries = (archive_entry *)archive->directory;
+	archive->names = (const char *)archive->directory +
+	                 archive->count * ARCHIVE_ENTRY_SIZE;
+	archive->directory[directory_size] = '\0';
+
+	entry = archive->directory;
+	for ( i = 0; i < archive->count; ++i ) {
+		e = &archive->entries[i];
+		e->name = archive_get32(&entry[0]);
+		e->name_length = archive_get32(&entry[4]);
+		e->offset = archive_get32(&entry[8]);
+		e->size = archive_get32(&entry[12]);
+		e->hash = archive_get32(&entry[16]);
+		entry += ARCHIVE_ENTRY_SIZE;
+
+		if ( (e->name > names_size) ||
+		     (e->name_length >= names_size - e->name) ||
+		     (archive->names[e->name + e->name_length] != '\0') ||
+		     (e->offset > file_size) ||
+		     (e->size > file_size - e->offset) ) {
+			goto bad_archive;
+		}
+
+		/* A stored hash that doesn't match would hide the member from
+		   lookups, and could put a duplicate name ahead of the first */
+		if ( e->hash != archive_hash(&archive->names[e->name]) ) {
+			goto bad_archive;
+		}
+
+		/* The first of several members with the same name wins */
+		for ( slot = e->hash & archive->mask; archive->table[slot];
+		      slot = (slot + 1) & archive->mask ) {
+			archive_entry *other = &archive->entries[archive->table[slot]-1];
+			if ( (other->hash == e->hash) &&
+			     (SDL_strcmp(&archive->names[other->name],
+			                 &archive->names[e->name]) == 0) ) {
+				break;
+			}
+		}
+		if ( !archive->table[slot] ) {
+			archive->table[slot] = i + 1;
+		}
+	}
+	return(archive);
+
+bad_archive:
+	SDL_SetError("%s is not a valid archive", file);
+	SDL_CloseArchive(archive);
+	return(NULL);
+}
+
+int SDL_GetArchiveMembers(SDL_Archive *archive)
+{
+	return(archive->count);
+}
+
+const char *SDL_GetArchiveMemberName(SDL_Archive *archive, int index)
+{
+	if ( (index < 0) || ((Uint32)index >= archive->count) ) {
+		SDL_SetError("Archive member index out of range");
+		return(NULL);
+	}
+	return(&archive->names[archive->entries[index].name]);
+}
+
+SDL_RWops *SDL_RWFromArchive(SDL_Archive *archive, const char *name)
+{
+	member_rwops *member;
+	archive_entry *e = NULL;
+	Uint32 hash, slot;
+
+	hash = archive_hash(name);
+	for ( slot = hash & archive->mask; archive->table[slot];
+	      slot = (slot + 1) & archive->mask ) {
+		e = &archive->entries[archive->table[slot]-1];
+		if ( (e->hash == hash) &&
+		     (SDL_strcmp(&archive->names[e->name], name) == 0) ) {
+			break;
+		}
+		e = NULL;
+	}
+	if ( e == NULL ) {
+		SDL_SetError("Couldn't find %s in archive", name);
+		return(NULL);
+	}
+
+	member = (member_rwops *)SDL_malloc(sizeof(*member));
+	if ( member == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	member->archive = archive;
+	member->offset = e->offset;
+	member->size = e->size;
+	member->here = 0;
+	member->ops.seek = member_seek;
+	member->ops.read = member_read;
+	member->ops.write = member_write;
+	member->ops.close = member_close;
+	member->ops.type = SDL_RWOPS_ARCHIVE;
+	return(&member->ops);
+}
+
+void SDL_CloseArchive(SDL_Archive *archive)
+{
+	if ( archive == NULL ) {
+		return;
+	}
+#ifdef HAVE_PREAD
+	if ( archive->fd >= 0 ) {
+		close(archive->fd);
+	}
+#else
+	if ( archive->file ) {
+		SDL_RWclose(archive->file);
+	}
+	if ( archive->lock ) {
+		SDL_DestroyMutex(archive->lock);
+	}
+#endif
+	if ( archive->table ) {
+		SDL_free(archive->table);
+	}
+	if ( archive->directory ) {
+		SDL_free(archive->directory);
+	}
+	SDL_free(archive);
+}
+
+/* Writing pack files */
+
+static int archive_write32(SDL_RWops *dst, Uint32 value)
+{
+	return(SDL_WriteLE32(dst, value) == 1 ? 0 : -1);
+}
+
+int SDL_SaveArchive(const char *file, int count, const char **names, const char **paths)
+{
+	SDL_RWops *dst, *src;
+	Uint32 *sizes;
+	Uint32 names_size, name, offset;
+	Uint8 buffer[4096];
+	int i, amount, size, retval = -1;
+
+	if ( !paths ) {
+		paths = names;
+	}
+	sizes = (Uint32 *)SDL_malloc((count ? count : 1) * sizeof(Uint32));
+	if ( sizes == NULL ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+
+	/* The directory comes first, so find out how big everything is */
+	names_size = 0;
+	for ( i = 0; i < count; ++i ) {
+		src = SDL_RWFromFile(paths[i], "rb");
+		if ( src == NULL ) {
+			goto done;
+		}
+		size = SDL_RWseek(src, 0, RW_SEEK_END);
+		SDL_RWclose(src);
+		if ( size < 0 ) {
+			SDL_SetError("Couldn't get the size of %s", paths[i]);
+			goto done;
+		}
+		sizes[i] = size;
+		names_size += SDL_strlen(names[i]) + 1;
+	}
+
+	dst = SDL_RWFromFile(file, "wb");
+	if ( dst == NULL ) {
+		goto done;
+	}
+	if ( archive_write32(dst, ARCHIVE_MAGIC) < 0 ||
+	     archive_write32(dst, ARCHIVE_VERSION) < 0 ||
+	     archive_write32(dst, count) < 0 ||
+	     archive_write32(dst, names_size) < 0 ) {
+		goto write_error;
+	}
+	name = 0;
+	offset = ARCHIVE_HEADER_SIZE + count * ARCHIVE_ENTRY_SIZE + names_size;
+	for ( i = 0; i < count; ++i ) {
+		Uint32 length = SDL_strlen(names[i]);
+		if ( archive_write32(dst, name) < 0 ||
+		     archive_write32(dst, length) < 0 ||
+		     archive_write32(dst, offset) < 0 ||
+		     archive_write32(dst, sizes[i]) < 0 ||
+		     archive_write32(dst, archive_hash(names[i])) < 0 ) {
+			goto write_error;
+		}
+		name += length + 1;
+		offset += sizes[i];
+	}
+	for ( i = 0; i < count; ++i ) {
+		if ( SDL_RWwrite(dst, names[i], SDL_strlen(names[i]) + 1, 1) != 1 ) {
+			goto write_error;
+		}
+	}
+
+	/* Now copy in the data */
+	for ( i = 0; i < count; ++i ) {
+		src = SDL_RWFromFile(paths[i], "rb");
+		if ( src == NULL ) {
+			SDL_RWclose(dst);
+			goto done;
+		}
+		for ( size = 0; (Uint32)size < sizes[i]; size += amount ) {
+			amount = sizeof(buffer);
+			if ( (Uint32)amount > sizes[i] - size ) {
+				amount = sizes[i] - size;
+			}
+			if ( SDL_RWread(src, buffer, amount, 1) != 1 ) {
+				SDL_SetError("%s changed while being archived", paths[i]);
+				SDL_RWclose(src);
+				SDL_RWclose(dst);
+				goto done;
+			}
+			if ( SDL_RWwrite(dst, buffer, amount, 1) != 1 ) {
+				SDL_RWclose(src);
+				goto write_error;
+			}
+		}
+		SDL_RWclose(src);
+	}
+	retval = 0;
+	SDL_RWclose(dst);
+	goto done;
+
+write_error:
+	SDL_Error(SDL_EFWRITE);
+	SDL_RWclose(dst);
+done:
+	SDL_free(sizes);
+	return(retval);
+}
@@ -0,0 +1,476 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* A stream read ahead of the caller by a loader thread
+
+   The blocks form a ring.  The loader fills the block at 'head' while
+   fewer than all of them are in use, and the reader takes the filled
+   blocks in order from 'tail'.  The block the reader is in is windowed
+   through hidden.mem, like a memory stream, so most reads and the inline
+   readers in SDL_rwops.h never take the lock.  Only the loader touches
+   the source, without the lock held while it reads; seeks are handed to
+   it as requests that the reader waits for.
+*/
+
+#include "SDL_rwops.h"
+#include "SDL_timer.h"
+#include "SDL_thread.h"
+#include "SDL_rwops_c.h"
+
+#define ASYNC_BLOCK_SIZE	65536
+#define ASYNC_BLOCKS		3
+
+/* Timing uses the high resolution counter where there is one */
+#ifdef SDL_HAS_64BIT_TYPE
+typedef Uint64 SDL_AsyncTime;
+#define SDL_GetAsyncTime()	SDL_GetPerformanceCounter()
+#define SDL_AsyncTimeFrequency()	((double)SDL_GetPerformanceFrequency())
+#else
+typedef Uint32 SDL_AsyncTime;
+#define SDL_GetAsyncTime()	SDL_GetTicks()
+#define SDL_AsyncTimeFrequency()	1000.0
+#endif
+
+#if !SDL_THREADS_DISABLED
+
+typedef struct {
+	SDL_RWops ops;
+	SDL_RWops *src;
+	int freesrc;
+	SDL_Thread *thread;
+	SDL_mutex *lock;
+	SDL_cond *cond;		/* Signalled when the ring or a request changes */
+
+	Uint8 *data;		/* The blocks, one after another */
+	int *filled;		/* Bytes loaded in each block */
+	int *start;		/* Source position of each block */
+	int blocksize;
+	int blocks;
+	int head;		/* Next block to load */
+	int tail;		/* Block the reader is in, or takes next */
+	int ready;		/* Loaded blocks the reader hasn't taken */
+	int holding;		/* Whether the reader is in block 'tail' */
+	int done;		/* The source ran out or failed */
+	int failed;		/* The source failed */
+	int quit;
+
+	/* A seek for the loader to do */
+	int request;
+	int seek_offset;
+	int seek_whence;
+	int seek_resume;	/* Where to go back to if it fails */
+	int seek_result;
+
+	int load_offset;	/* Source position of the next block loaded */
+	int offset;		/* Source position of hidden.mem.base */
+
+	/* Statistics */
+	Uint32 handed;
+	Uint32 underruns;
+	SDL_AsyncTime wait_time;
+	SDL_AsyncTime max_wait_time;
+	SDL_AsyncTime load_time;
+	SDL_AsyncTime max_load_time;
+} async_rwops;
+
+static int SDLCALL async_loader(void *data)
+{
+	async_rwops *async = (async_rwops *)data;
+	SDL_AsyncTime then, took;
+	int block, got;
+
+	SDL_mutexP(async->lock);
+	while ( !async->quit ) {
+		if ( async->request ) {
+			/* The reader has dropped everything, so start over here */
+			got = SDL_RWseek(async->src, async->seek_offset, async->seek_whence);
+			if ( got < 0 ) {
+				SDL_RWseek(async->src, async->seek_resume, RW_SEEK_SET);
+			}
+			async->seek_result = got;
+			async->head = async->tail = 0;
+			async->ready = 0;
+			async->done = 0;
+			async->failed = 0;
+			async->load_offset = (got < 0) ? async->seek_resume : got;
+			async->request = 0;
+			SDL_CondBroadcast(async->cond);
+			continue;
+		}
+		if ( async->done || (async->ready + async->holding) == async->blocks ) {
+			SDL_CondWait(async->cond, async->lock);
+			continue;
+		}
+
+		block = async->head;
+		async->start[block] = async->load_offset;
+		SDL_mutexV(async->lock);
+		then = SDL_GetAsyncTime();
+		got = SDL_RWread(async->src, async->data + block*async->blocksize,
+		                 1, async->blocksize);
+		took = SDL_GetAsyncTime() - then;
+		SDL_mutexP(async->lock);
+
+		/* A seek made while reading throws the block away */
+		if ( async->request ) {
+			continue;
+		}
+		async->load_time += took;
+		if ( took > async->max_load_time ) {
+			async->max_load_time = took;
+		}
+		if ( got <= 0 ) {
+			async->done = 1;
+			async->failed = (got < 0);
+		} else {
+			async->filled[block] = got;
+			async->head = (block + 1) % async->blocks;
+			async->load_offset += got;
+			++async->ready;
+		}
+		SDL_CondBroadcast(async->cond);
+	}
+	SDL_mutexV(async->lock);
+	return(0);
+}
+
+/* Give back the block the reader is in, and move to the next one.
+   Returns 0 if there are no more, or -1 if the source failed.
+ */
+static int async_next_block(SDL_RWops *context)
+{
+	async_rwops *async = (async_rwops *)context;
+	SDL_AsyncTime then, took;
+	Uint8 *base;
+
+	SDL_mutexP(async->lock);
+	if ( async->holding ) {
+		async->holding = 0;
+		async->tail = (async->tail + 1) % async->blocks;
+		SDL_CondBroadcast(async->cond);
+	}
+	if ( !async->ready && !async->done ) {
+		++async->underruns;
+		then = SDL_GetAsyncTime();
+		do {
+			SDL_CondWait(async->cond, async->lock);
+		} while ( !async->ready && !async->done );
+		took = SDL_GetAsyncTime() - then;
+		async->wait_time += took;
+		if ( took > async->max_wait_time ) {
+			async->max_wait_time = took;
+		}
+	}
+	if ( !async->ready ) {
+		SDL_mutexV(async->lock);
+		if ( async->failed ) {
+			/* The loader's error was set in its own thread */
+			SDL_Error(SDL_EFREAD);
+			return(-1);
+		}
+		return(0);
+	}
+	--async->ready;
+	async->holding = 1;
+	++async->handed;
+	base = async->data + async->tail*async->blocksize;
+	async->offset = async->start[async->tail];
+	context->hidden.mem.base = base;
+	context->hidden.mem.here = base;
+	context->hidden.mem.stop = base + async->filled[async->tail];
+	SDL_mutexV(async->lock);
+	return(1);
+}
+
+static int async_tell(SDL_RWops *context)
+{
+	return(((async_rwops *)context)->offset +
+	       (context->hidden.mem.here - context->hidden.mem.base));
+}
+
+static int SDLCALL async_seek(SDL_RWops *context, int offset, int whence)
+{
+	async_rwops *async = (async_rwops *)context;
+	int newpos;
+
+	switch (whence) {
+		case RW_SEEK_SET:
+			newpos = offset;
+			break;
+		case RW_SEEK_CUR:
+			newpos = async_tell(context)+offset;
+			break;
+		case RW_SEEK_END:
+			newpos = -1;
+			break;
+		default:
+			SDL_SetError("Unknown value for 'whence'");
+			return(-1);
+	}
+
+	/* Stay in the current block if we can */
+	if ( (newpos >= async->offset) &&
+	     (newpos <= async->offset + (context->hidden.mem.stop -
+	                                 context->hidden.mem.base)) ) {
+		context->hidden.mem.here = context->hidden.mem.base +
+		                           (newpos - async->offset);
+		return(newpos);
+	}
+
+	/* Drop everything and have the loader seek */
+	SDL_mutexP(async->lock);
+	async->holding = 0;
+	async->seek_resume = async_tell(context);
+	if ( whence == RW_SEEK_END ) {
+		async->seek_offset = offset;
+		async->seek_whence = RW_SEEK_END;
+	} else {
+		async->seek_offset = newpos;
+		async->seek_whence = RW_SEEK_SET;
+	}
+	async->request = 1;
+	SDL_CondBroadcast(async->cond);
+	do {
+		SDL_CondWait(async->cond, async->lock);
+	} while ( async->request );
+	/* The loader may have moved on already, so don't use load_offset */
+	newpos = async->seek_result;
+	async->offset = (newpos < 0) ? async->seek_resume : newpos;
+	context->hidden.mem.here = context->hidden.mem.base;
+	context->hidden.mem.stop = context->hidden.mem.base;
+	SDL_mutexV(async->lock);
+	return(newpos);
+}
+
+int SDLCALL SDL_RWAsyncRead(SDL_RWops *context, void *ptr, int size, int maxnum)
+{
+	Uint8 *dst = (Uint8 *)ptr;
+	size_t total_bytes, left, amount;
+	int got = 0;
+
+	total_bytes = (maxnum * size);
+	if ( (maxnum <= 0) || (size <= 0) || ((total_bytes / maxnum) != (size_t) size) ) {
+		return 0;
+	}
+
+	left = total_bytes;
+	while ( left > 0 ) {
+		amount = (context->hidden.mem.stop - context->hidden.mem.here);
+		if ( amount == 0 ) {
+			got = async_next_block(context);
+			if ( got <= 0 ) {
+				break;
+			}
+			continue;
+		}
+		if ( amount > left ) {
+			amount = left;
+		}
+		SDL_memcpy(dst, context->hidden.mem.here, amount);
+		context->hidden.mem.here += amount;
+		dst += amount;
+		left -= amount;
+	}
+	if ( (left == total_bytes) && (got < 0) ) {
+		return(-1);
+	}
+	return((total_bytes - left) / size);
+}
+
+static int SDLCALL async_write(SDL_RWops *context, const void *ptr, int size, int num)
+{
+	SDL_SetError("Can't write to a read-ahead stream");
+	return(-1);
+}
+
+static int SDLCALL async_close(SDL_RWops *context)
+{
+	async_rwops *async = (async_rwops *)context;
+	int status = 0;
+
+	if ( context ) {
+		if ( async->thread ) {
+			SDL_mutexP(async->lock);
+			async->quit = 1;
+			SDL_CondBroadcast(async->cond);
+			SDL_mutexV(async->lock);
+			SDL_WaitThread(async->thread, NULL);
+		}
+		if ( async->freesrc ) {
+			status = SDL_RWclose(async->src);
+		} else if ( async->thread ) {
+			SDL_RWseek(async->src, async_tell(context), RW_SEEK_SET);
+		}
+		if ( async->cond ) {
+			SDL_DestroyCond(async->cond);
+		}
+		if ( async->lock ) {
+			SDL_DestroyMutex(async->lock);
+		}
+		if ( async->data ) {
+			SDL_free(async->data);
+		}
+		if ( async->filled ) {
+			SDL_free(async->filled);
+		}
+		if ( async->start ) {
+			SDL_free(async->start);
+		}
+		SDL_FreeRW(context);
+	}
+	return(status);
+}
+
+SDL_RWops *SDL_RWFromRWAsync(SDL_RWops *src, int freesrc, int blocksize, int blocks)
+{
+	async_rwops *async;
+	SDL_RWops *rwops;
+	int offset;
+
+	if ( !src ) {
+		SDL_SetError("SDL_RWFromRWAsync(): No source stream specified");
+		return NULL;
+	}
+	if ( blocksize <= 0 ) {
+		blocksize = ASYNC_BLOCK_SIZE;
+	}
+	if ( blocks <= 0 ) {
+		blocks = ASYNC_BLOCKS;
+	}
+	if ( (blocksize > 0x7FFFFFFF / blocks) ||
+	     (blocks > 0x7FFFFFFF / (int)sizeof(int)) ) {
+		SDL_SetError("SDL_RWFromRWAsync(): Too much to read ahead");
+		return NULL;
+	}
+
+	async = (async_rwops *)SDL_malloc(sizeof(*async));
+	if ( async == NULL ) {
+		SDL_OutOfMemory();
+		return NULL;
+	}
+	SDL_memset(async, 0, sizeof(*async));
+	async->src = src;
+	async->blocksize = blocksize;
+	async->blocks = blocks;
+
+	rwops = &async->ops;
+	rwops->seek = async_seek;
+	rwops->read = SDL_RWReadWindow;
+	rwops->write = async_write;
+	rwops->close = async_close;
+	rwops->type = SDL_RWOPS_ASYNC;
+
+	async->data = (Uint8 *)SDL_malloc(blocks * blocksize);
+	async->filled = (int *)SDL_malloc(blocks * sizeof(int));
+	async->start = (int *)SDL_malloc(blocks * sizeof(int));
+	if ( !async->data || !async->filled || !async->start ) {
+		SDL_OutOfMemory();
+		SDL_RWclose(rwops);
+		return NULL;
+	}
+	async->lock = SDL_CreateMutex();
+	async->cond = SDL_CreateCond();
+	if ( !async->lock || !async->cond ) {
+		SDL_RWclose(rwops);
+		return NULL;
+	}
+
+	/* Streams that can't tell where they are count from here */
+	offset = SDL_RWtell(src);
+	if ( offset < 0 ) {
+		offset = 0;
+	}
+	async->offset = offset;
+	async->load_offset = offset;
+	rwops->hidden.mem.base = async->data;
+	rwops->hidden.mem.here = async->data;
+	rwops->hidden.mem.stop = async->data;
+
+#if (defined(__WIN32__) && !defined(_WIN32_WCE)) && !defined(HAVE_LIBC) && !defined(__SYMBIAN32__)
+#undef SDL_CreateThread
+	async->thread = SDL_CreateThread(async_loader, async, NULL, NULL);
+#else
+	async->thread = SDL_CreateThread(async_loader, async);
+#endif
+	if ( async->thread == NULL ) {
+		SDL_RWclose(rwops);
+		return SDL_RWFromRW(src, freesrc, blocksize);
+	}
+	async->freesrc = freesrc;
+	return(rwops);
+}
+
+int SDL_GetRWAsyncStats(SDL_RWops *context, SDL_RWAsyncStats *stats)
+{
+	async_rwops *async = (async_rwops *)context;
+	double frequency = SDL_AsyncTimeFrequency();
+
+	if ( !SDL_RWIsWindowed(context) || context->type != SDL_RWOPS_ASYNC ) {
+		SDL_SetError("Stream isn't read ahead");
+		return(-1);
+	}
+	SDL_mutexP(async->lock);
+	stats->blocks = async->handed;
+	stats->underruns = async->underruns;
+	stats->wait_time = async->wait_time / frequency;
+	stats->max_wait_time = async->max_wait_time / frequency;
+	stats->load_time = async->load_time / frequency;
+	stats->max_load_time = async->max_load_time / frequency;
+	SDL_mutexV(async->lock);
+	return(0);
+}
+
+void SDL_ResetRWAsyncStats(SDL_RWops *context)
+{
+	async_rwops *async = (async_rwops *)context;
+
+	if ( SDL_RWIsWindowed(context) && context->type == SDL_RWOPS_ASYNC ) {
+		SDL_mutexP(async->lock);
+		async->handed = 0;
+		async->underruns = 0;
+		async->wait_time = 0;
+		async->max_wait_time = 0;
+		async->load_time = 0;
+		async->max_load_time = 0;
+		SDL_mutexV(async->lock);
+	}
+}
+
+#else
+
+SDL_RWops *SDL_RWFromRWAsync(SDL_RWops *src, int freesrc, int blocksize, int blocks)
+{
+	return SDL_RWFromRW(src, freesrc, blocksize);
+}
+
+int SDL_GetRWAsyncStats(SDL_RWops *context, SDL_RWAsyncStats *stats)
+{
+	SDL_SetError("Stream isn't read ahead");
+	return(-1);
+}
+
+void SDL_ResetRWAsyncStats(SDL_RWops *context)
+{
+}
+
+#endif /* !SDL_THREADS_DISABLED */
@@ -27,6 +27,15 @@
 
 #include "SDL_endian.h"
 #include "SDL_rwops.h"
+#include "SDL_rwops_c.h"
+
+#ifdef HAVE_MMAP
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 
 #if defined(__WIN32__) && !defined(__SYMBIAN32__)
@@ -433,6 +442,208 @@ static int SDLCALL mem_close(SDL_RWops *context)
 	return(0);
 }
 
+#ifdef HAVE_MMAP
+
+/* Functions to read memory-mapped files
+
+   The mapping is read-only and otherwise handled as constant memory, so
+   readers that look for SDL_RWOPS_MEMORY_RO get at the file directly.
+*/
+
+static int SDLCALL mmap_close(SDL_RWops *context)
+{
+	if ( context ) {
+		munmap(context->hidden.mem.base,
+		       context->hidden.mem.stop - context->hidden.mem.base);
+		SDL_FreeRW(context);
+	}
+	return(0);
+}
+
+static SDL_RWops *mmap_open(const char *file)
+{
+	SDL_RWops *rwops;
+	struct stat st;
+	void *base;
+	int fd;
+
+	fd = open(file, O_RDONLY);
+	if ( fd < 0 ) {
+		return(NULL);
+	}
+	/* Empty files can't be mapped, and the offsets are ints */
+	if ( (fstat(fd, &st) < 0) || !S_ISREG(st.st_mode) ||
+	     (st.st_size <= 0) || (st.st_size > 0x7FFFFFFF) ) {
+		close(fd);
+		return(NULL);
+	}
+	base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if ( base == MAP_FAILED ) {
+		return(NULL);
+	}
+
+	rwops = SDL_RWFromConstMem(base, (int)st.st_size);
+	if ( rwops == NULL ) {
+		munmap(base, st.st_size);
+		return(NULL);
+	}
+	rwops->close = mmap_close;
+	return(rwops);
+}
+#endif /* HAVE_MMAP */
+
+/* Functions to read/write through a buffer over another stream
+
+   The buffer is allocated along with the SDL_RWops, so SDL_FreeRW() frees
+   both.  The unread part of it is kept in hidden.mem like a memory stream,
+   which lets the inline readers in SDL_rwops.h work on either kind.
+   The source is always positioned at the end of the buffered data.
+*/
+
+#define BUFFERED_BLOCK_SIZE	4096
+
+typedef struct {
+	SDL_RWops ops;
+	SDL_RWops *src;
+	int freesrc;
+	int size;		/* Size of the buffer */
+	int offset;		/* Position of hidden.mem.base in the source */
+} buffered_rwops;
+
+static void buffered_reset(SDL_RWops *context, int offset)
+{
+	((buffered_rwops *)context)->offset = offset;
+	context->hidden.mem.here = context->hidden.mem.base;
+	context->hidden.mem.stop = context->hidden.mem.base;
+}
+static int buffered_tell(SDL_RWops *context)
+{
+	return(((buffered_rwops *)context)->offset +
+	       (context->hidden.mem.here - context->hidden.mem.base));
+}
+static int SDLCALL buffered_seek(SDL_RWops *context, int offset, int whence)
+{
+	buffered_rwops *buffered = (buffered_rwops *)context;
+	int newpos;
+
+	switch (whence) {
+		case RW_SEEK_SET:
+			newpos = offset;
+			break;
+		case RW_SEEK_CUR:
+			newpos = buffered_tell(context)+offset;
+			break;
+		case RW_SEEK_END:
+			newpos = SDL_RWseek(buffered->src, offset, RW_SEEK_END);
+			if ( newpos >= 0 ) {
+				buffered_reset(context, newpos);
+			}
+			return(newpos);
+		default:
+			SDL_SetError("Unknown value for 'whence'");
+			return(-1);
+	}
+
+	/* Stay in the buffer if we can */
+	if ( (newpos >= buffered->offset) &&
+	     (newpos <= buffered->offset + (context->hidden.mem.stop -
+	                                    context->hidden.mem.base)) ) {
+		context->hidden.mem.here = context->hidden.mem.base +
+		                           (newpos - buffered->offset);
+		return(newpos);
+	}
+	newpos = SDL_RWseek(buffered->src, newpos, RW_SEEK_SET);
+	if ( newpos >= 0 ) {
+		buffered_reset(context, newpos);
+	}
+	return(newpos);
+}
+static int SDLCALL buffered_read(SDL_RWops *context, void *ptr, int size, int maxnum)
+{
+	buffered_rwops *buffered = (buffered_rwops *)context;
+	Uint8 *dst = (Uint8 *)ptr;
+	size_t total_bytes, left, amount;
+	int got = 0;
+
+	total_bytes = (maxnum * size);
+	if ( (maxnum <= 0) || (size <= 0) || ((total_bytes / maxnum) != (size_t) size) ) {
+		return 0;
+	}
+
+	left = total_bytes;
+	while ( left > 0 ) {
+		amount = (context->hidden.mem.stop - context->hidden.mem.here);
+		if ( amount > 0 ) {
+			if ( amount > left ) {
+				amount = left;
+			}
+			SDL_memcpy(dst, context->hidden.mem.here, amount);
+			context->hidden.mem.here += amount;
+			dst += amount;
+			left -= amount;
+			continue;
+		}
+
+		/* The buffer is used up, so refill it, unless the rest of
+		   the read would fill it anyway.
+		 */
+		buffered_reset(context, buffered_tell(context));
+		if ( left >= (size_t)buffered->size ) {
+			got = SDL_RWread(buffered->src, dst, 1, (int)left);
+			if ( got > 0 ) {
+				buffered->offset += got;
+				left -= got;
+			}
+			break;
+		}
+		got = SDL_RWread(buffered->src, context->hidden.mem.base, 1, buffered->size);
+		if ( got <= 0 ) {
+			break;
+		}
+		context->hidden.mem.stop += got;
+	}
+	if ( (left == total_bytes) && (got < 0) ) {
+		return(-1);
+	}
+	return((total_bytes - left) / size);
+}
+static int SDLCALL buffered_write(SDL_RWops *context, const void *ptr, int size, int num)
+{
+	buffered_rwops *buffered = (buffered_rwops *)context;
+	int pos;
+
+	/* Drop whatever was read ahead, putting the source back under us */
+	pos = buffered_tell(context);
+	if ( context->hidden.mem.here != context->hidden.mem.stop ) {
+		if ( SDL_RWseek(buffered->src, pos, RW_SEEK_SET) < 0 ) {
+			return(-1);
+		}
+	}
+	buffered_reset(context, pos);
+
+	num = SDL_RWwrite(buffered->src, ptr, size, num);
+	if ( num > 0 ) {
+		buffered->offset += num*size;
+	}
+	return(num);
+}
+static int SDLCALL buffered_close(SDL_RWops *context)
+{
+	buffered_rwops *buffered = (buffered_rwops *)context;
+	int status = 0;
+
+	if ( context ) {
+		if ( buffered->freesrc ) {
+			status = SDL_RWclose(buffered->src);
+		} else if ( context->hidden.mem.here != context->hidden.mem.stop ) {
+			SDL_RWseek(buffered->src, buffered_tell(context), RW_SEEK_SET);
+		}
+		SDL_FreeRW(context);
+	}
+	return(status);
+}
+
 
 /* Functions to create SDL_RWops structures from various data sources */
 
@@ -483,6 +694,7 @@ static char *unix_to_mac(const char *file)
 SDL_RWops *SDL_RWFromFile(const char *file, const char *mode)
 {
 	SDL_RWops *rwops = NULL;
+	char plain_mode[16];
 #ifdef HAVE_STDIO_H
 	FILE *fp = NULL;
 #endif
@@ -491,6 +703,31 @@ SDL_RWops *SDL_RWFromFile(const char *file, const char *mode)
 		return NULL;
 	}
 
+	/* 'm' asks for a read-only file to be mapped into memory.  If that
+	   can't be done, the file is opened as usual, without the 'm'.
+	 */
+	if ( SDL_strchr(mode, 'm') != NULL ) {
+#ifdef HAVE_MMAP
+		if ( !SDL_strchr(mode, 'w') && !SDL_strchr(mode, 'a') &&
+		     !SDL_strchr(mode, '+') ) {
+			rwops = mmap_open(file);
+			if ( rwops ) {
+				return(rwops);
+			}
+		}
+#endif
+		if ( SDL_strlen(mode) < sizeof(plain_mode) ) {
+			char *c;
+			for ( c = plain_mode; *mode; ++mode ) {
+				if ( *mode != 'm' ) {
+					*c++ = *mode;
+				}
+			}
+			*c = '\0';
+			mode = plain_mode;
+		}
+	}
+
 #if defined(__WIN32__) && !defined(__SYMBIAN32__)
 	rwops = SDL_AllocRW();
 	if (!rwops)
@@ -503,6 +740,7 @@ SDL_RWops *SDL_RWFromFile(const char *file, const char *mode)
 	rwops->read  = win32_file_read;
 	rwops->write = win32_file_write;
 	rwops->close = win32_file_close;
+	rwops->type = SDL_RWOPS_WINFILE;
 
 #elif HAVE_STDIO_H
 
@@ -538,6 +776,7 @@ SDL_RWops *SDL_RWFromFP(FILE *fp, int autoclose)
 		rwops->read = stdio_read;
 		rwops->write = stdio_write;
 		rwops->close = stdio_close;
+		rwops->type = SDL_RWOPS_STDFILE;
 		rwops->hidden.stdio.fp = fp;
 		rwops->hidden.stdio.autoclose = autoclose;
 	}
@@ -552,9 +791,10 @@ SDL_RWops *SDL_RWFromMem(void *mem, int size)
 	rwops = SDL_AllocRW();
 	if ( rwops != NULL ) {
 		rwops->seek = mem_seek;
-		rwops->read = mem_read;
+		rwops->read = SDL_RWReadWindow;
 		rwops->write = mem_write;
 		rwops->close = mem_close;
+		rwops->type = SDL_RWOPS_MEMORY;
 		rwops->hidden.mem.base = (Uint8 *)mem;
 		rwops->hidden.mem.here = rwops->hidden.mem.base;
 		rwops->hidden.mem.stop = rwops->hidden.mem.base+size;
@@ -569,9 +809,10 @@ SDL_RWops *SDL_RWFromConstMem(const void *mem, int size)
 	rwops = SDL_AllocRW();
 	if ( rwops != NULL ) {
 		rwops->seek = mem_seek;
-		rwops->read = mem_read;
+		rwops->read = SDL_RWReadWindow;
 		rwops->write = mem_writeconst;
 		rwops->close = mem_close;
+		rwops->type = SDL_RWOPS_MEMORY_RO;
 		rwops->hidden.mem.base = (Uint8 *)mem;
 		rwops->hidden.mem.here = rwops->hidden.mem.base;
 		rwops->hidden.mem.stop = rwops->hidden.mem.base+size;
@@ -579,6 +820,139 @@ SDL_RWops *SDL_RWFromConstMem(const void *mem, int size)
 	return(rwops);
 }
 
+SDL_RWops *SDL_RWFromRW(SDL_RWops *src, int freesrc, int blocksize)
+{
+	buffered_rwops *buffered;
+	SDL_RWops *rwops;
+	int offset;
+
+	if ( !src ) {
+		SDL_SetError("SDL_RWFromRW(): No source stream specified");
+		return NULL;
+	}
+	if ( blocksize <= 0 ) {
+		blocksize = BUFFERED_BLOCK_SIZE;
+	}
+
+	buffered = (buffered_rwops *)SDL_malloc(sizeof(*buffered) + blocksize);
+	if ( buffered == NULL ) {
+		SDL_OutOfMemory();
+		return NULL;
+	}
+	buffered->src = src;
+	buffered->freesrc = freesrc;
+	buffered->size = blocksize;
+
+	/* Streams that can't tell where they are count from here */
+	offset = SDL_RWtell(src);
+	if ( offset < 0 ) {
+		offset = 0;
+	}
+
+	rwops = &buffered->ops;
+	rwops->seek = buffered_seek;
+	rwops->read = SDL_RWReadWindow;
+	rwops->write = buffered_write;
+	rwops->close = buffered_close;
+	rwops->type = SDL_RWOPS_BUFFERED;
+	rwops->hidden.mem.base = (Uint8 *)(buffered + 1);
+	buffered_reset(rwops, offset);
+	return(rwops);
+}
+
+int SDLCALL SDL_RWReadWindow(SDL_RWops *context, void *ptr, int size, int maxnum)
+{
+	switch (context->type) {
+		case SDL_RWOPS_MEMORY:
+		case SDL_RWOPS_MEMORY_RO:
+			return mem_read(context, ptr, size, maxnum);
+		case SDL_RWOPS_BUFFERED:
+			return buffered_read(context, ptr, size, maxnum);
+#if !SDL_THREADS_DISABLED
+		case SDL_RWOPS_ASYNC:
+			return SDL_RWAsyncRead(context, ptr, size, maxnum);
+#endif
+		default:
+			SDL_SetError("SDL_RWReadWindow(): Unknown stream type");
+			return(-1);
+	}
+}
+
+const Uint8 *SDL_RWPeek(SDL_RWops *context, int want, int *len)
+{
+	buffered_rwops *buffered;
+	int got;
+
+	if ( !SDL_RWIsWindowed(context) ) {
+		SDL_SetError("SDL_RWPeek(): Stream is not buffered");
+		return NULL;
+	}
+	switch (context->type) {
+		case SDL_RWOPS_MEMORY:
+		case SDL_RWOPS_MEMORY_RO:
+			break;
+		case SDL_RWOPS_BUFFERED:
+			buffered = (buffered_rwops *)context;
+			if ( want > buffered->size ) {
+				want = buffered->size;
+			}
+			if ( (context->hidden.mem.stop - context->hidden.mem.here) >= want ) {
+				break;
+			}
+
+			/* Move the unread bytes to the front and fill up after them */
+			got = (context->hidden.mem.stop - context->hidden.mem.here);
+			SDL_memmove(context->hidden.mem.base, context->hidden.mem.here, got);
+			buffered->offset = buffered_tell(context);
+			context->hidden.mem.here = context->hidden.mem.base;
+			context->hidden.mem.stop = context->hidden.mem.base + got;
+			while ( (context->hidden.mem.stop - context->hidden.mem.here) < want ) {
+				got = SDL_RWread(buffered->src, context->hidden.mem.stop, 1,
+				          buffered->size - (context->hidden.mem.stop -
+				                            context->hidden.mem.base));
+				if ( got <= 0 ) {
+					break;
+				}
+				context->hidden.mem.stop += got;
+			}
+			break;
+		default:
+			SDL_SetError("SDL_RWPeek(): Stream is not buffered");
+			return NULL;
+	}
+	if ( len ) {
+		*len = (context->hidden.mem.stop - context->hidden.mem.here);
+	}
+	return(context->hidden.mem.here);
+}
+
+const Uint8 *SDL_RWBorrow(SDL_RWops *context, int offset, int size)
+{
+	int start, length;
+
+	if ( !SDL_RWIsWindowed(context) ) {
+		return(NULL);
+	}
+	switch (context->type) {
+		case SDL_RWOPS_MEMORY:
+		case SDL_RWOPS_MEMORY_RO:
+			start = 0;
+			break;
+		case SDL_RWOPS_BUFFERED:
+			start = ((buffered_rwops *)context)->offset;
+			break;
+		default:
+			return(NULL);
+	}
+	length = (context->hidden.mem.stop - context->hidden.mem.base);
+	offset -= start;
+	if ( (offset < 0) || (size < 0) || (offset > length) ||
+	     (size > length - offset) ) {
+		return(NULL);
+	}
+	return(context->hidden.mem.base + offset);
+}
+
 SDL_RWops *SDL_AllocRW(void)
 {
 	SDL_RWops *area;
@@ -586,6 +960,8 @@ SDL_RWops *SDL_AllocRW(void)
 	area = (SDL_RWops *)SDL_malloc(sizeof *area);
 	if ( area == NULL ) {
 		SDL_OutOfMemory();
+	} else {
+		area->type = SDL_RWOPS_UNKNOWN;
 	}
 	return(area);
 }
@@ -597,6 +973,14 @@ void SDL_FreeRW(SDL_RWops *area)
 
 /* Functions for dynamically reading and writing endian-specific values */
 
+/* These are the out of line versions of the readers in SDL_rwops.h */
+#undef SDL_ReadLE16
+#undef SDL_ReadBE16
+#undef SDL_ReadLE32
+#undef SDL_ReadBE32
+#undef SDL_ReadLE64
+#undef SDL_ReadBE64
+
 Uint16 SDL_ReadLE16 (SDL_RWops *src)
 {
 	Uint16 value;
@@ -0,0 +1,32 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Functions shared between the stream implementations */
+
+/* Whether a stream is one of SDL's, windowed through hidden.mem */
+#define SDL_RWIsWindowed(ctx)	((ctx)->read == SDL_RWReadWindow)
+
+#if !SDL_THREADS_DISABLED
+/* Read from a stream made by SDL_RWFromRWAsync(), in SDL_rwasync.c */
+extern int SDLCALL SDL_RWAsyncRead(SDL_RWops *context, void *ptr, int size, int maxnum);
+#endif
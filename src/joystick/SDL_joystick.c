@@ -437,7 +437,7 @@ int SDL_PrivateJoystickAxis(SDL_Joystick *joystick, Uint8 axis, Sint16 value)
 		event.jaxis.value = value;
 		if ( (SDL_EventOK == NULL) || (*SDL_EventOK)(&event) ) {
 			posted = 1;
-			SDL_PushEvent(&event);
+			SDL_PushMotionEvent(&event);
 		}
 	}
 #endif /* !SDL_EVENTS_DISABLED */
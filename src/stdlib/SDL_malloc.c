@@ -34,6 +34,24 @@
 #define LACKS_STDLIB_H
 #define ABORT
 
+/* With SDL_MALLOC_THREAD_CACHE, SDL_malloc() can be called from any thread.
+   Using pthreads, each thread gets a heap of its own (see "SDL per-thread
+   heaps" near the end), elsewhere there is one heap behind a lock.
+*/
+#ifdef SDL_MALLOC_THREAD_CACHE
+#if SDL_THREAD_PTHREAD && !SDL_THREADS_DISABLED
+#define THREAD_CACHE 1
+#define ONLY_MSPACES 1
+#define FOOTERS 1
+#define USE_LOCKS 1
+#elif defined(WIN32)
+#define USE_LOCKS 1
+#endif
+#endif /* SDL_MALLOC_THREAD_CACHE */
+#ifndef THREAD_CACHE
+#define THREAD_CACHE 0
+#endif
+
 /*
   This is a version (aka dlmalloc) of malloc/free/realloc written by
   Doug Lea and released to the public domain, as explained at
@@ -2038,6 +2056,9 @@ struct malloc_state {
   MLOCK_T    mutex;     /* locate lock among fields that rarely change */
 #endif /* USE_LOCKS */
   msegment   seg;
+#if THREAD_CACHE
+  void*      cache;     /* the thread_cache owning this space, if any */
+#endif /* THREAD_CACHE */
 };
 
 typedef struct malloc_state*    mstate;
@@ -4835,6 +4856,203 @@ int mspace_mallopt(int param_number, int value) {
 
 #endif /* MSPACES */
 
+#if THREAD_CACHE
+/* ------------------------ SDL per-thread heaps ------------------------- */
+
+/*
+  Each thread allocates from an mspace of its own, made without a lock
+  the first time the thread allocates.  The footer of every chunk names
+  the mspace it came from, so a chunk freed by the thread that owns its
+  space goes straight back.  A chunk freed by any other thread is pushed
+  onto its space's list of remote frees, under a lock that guards only
+  that list, and the owner takes the list back on its next malloc.
+
+  When a thread exits, its space is kept, along with whatever is still
+  allocated from it, and handed to the next thread that allocates.  A
+  thread that can't get a space of its own uses a shared, locked one.
+*/
+
+typedef struct thread_cache {
+  mstate space;
+  MLOCK_T lock;                   /* guards remote */
+  void* volatile remote;          /* chunks freed by other threads */
+  struct thread_cache* next_free; /* spaces whose thread has exited */
+} thread_cache;
+
+static pthread_once_t cache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t cache_key;
+static int cache_key_ok;
+static MLOCK_T cache_list_lock = PTHREAD_MUTEX_INITIALIZER; /* guards below */
+static thread_cache* free_caches;
+static mstate shared_space;
+
+static void release_cache(void* data) {
+  thread_cache* cache = (thread_cache*)data;
+  ACQUIRE_LOCK(&cache_list_lock);
+  cache->next_free = free_caches;
+  free_caches = cache;
+  RELEASE_LOCK(&cache_list_lock);
+}
+
+static void init_cache_key(void) {
+  cache_key_ok = (pthread_key_create(&cache_key, release_cache) == 0);
+}
+
+static thread_cache* current_cache(void) {
+  return cache_key_ok ? (thread_cache*)pthread_getspecific(cache_key) : 0;
+}
+
+/* Find the calling thread's space, taking one over or making one if need be */
+static thread_cache* get_cache(void) {
+  thread_cache* cache;
+  pthread_once(&cache_once, init_cache_key);
+  if (!cache_key_ok)
+    return 0;
+  cache = (thread_cache*)pthread_getspecific(cache_key);
+  if (cache != 0)
+    return cache;
+
+  ACQUIRE_LOCK(&cache_list_lock);
+  cache = free_caches;
+  if (cache != 0)
+    free_caches = cache->next_free;
+  RELEASE_LOCK(&cache_list_lock);
+  if (cache == 0) {
+    mstate m = (mstate)create_mspace(0, 0);
+    if (m == 0)
+      return 0;
+    cache = (thread_cache*)mspace_malloc(m, sizeof(thread_cache));
+    if (cache == 0) {
+      destroy_mspace(m);
+      return 0;
+    }
+    cache->space = m;
+    INITIAL_LOCK(&cache->lock);
+    cache->remote = 0;
+    m->cache = cache;
+  }
+  if (pthread_setspecific(cache_key, cache) != 0) {
+    release_cache(cache);
+    return 0;
+  }
+  return cache;
+}
+
+static mstate get_shared_space(void) {
+  mstate m;
+  ACQUIRE_LOCK(&cache_list_lock);
+  if (shared_space == 0)
+    shared_space = (mstate)create_mspace(0, 1);
+  m = shared_space;
+  RELEASE_LOCK(&cache_list_lock);
+  return m;
+}
+
+/* Free the chunks other threads have handed back */
+static void take_remote_frees(thread_cache* cache) {
+  void* mem;
+  ACQUIRE_LOCK(&cache->lock);
+  mem = cache->remote;
+  cache->remote = 0;
+  RELEASE_LOCK(&cache->lock);
+  while (mem != 0) {
+    void* next = *(void**)mem;
+    mspace_free(cache->space, mem);
+    mem = next;
+  }
+}
+
+/*
+  Only the owning thread changes a chunk header, and then only its in-use
+  bits, so any thread can read the size and find the footer.
+*/
+static mstate space_for(void* mem) {
+  mstate fm = get_mstate_for(mem2chunk(mem));
+  if (!ok_magic(fm)) {
+    USAGE_ERROR_ACTION(fm, mem2chunk(mem));
+    return 0;
+  }
+  return fm;
+}
+
+void* SDL_malloc(size_t bytes) {
+  thread_cache* cache = get_cache();
+  if (cache == 0) {
+    mstate m = get_shared_space();
+    return (m != 0) ? mspace_malloc(m, bytes) : 0;
+  }
+  if (cache->remote != 0)
+    take_remote_frees(cache);
+  return mspace_malloc(cache->space, bytes);
+}
+
+void SDL_free(void* mem) {
+  if (mem != 0) {
+    mstate fm = space_for(mem);
+    thread_cache* owner;
+    if (fm == 0)
+      return;
+    owner = (thread_cache*)fm->cache;
+    if (owner == 0 || owner == current_cache()) {
+      mspace_free(fm, mem);
+    }
+    else {
+      ACQUIRE_LOCK(&owner->lock);
+      *(void**)mem = owner->remote;
+      owner->remote = mem;
+      RELEASE_LOCK(&owner->lock);
+    }
+  }
+}
+
+void* SDL_calloc(size_t n_elements, size_t elem_size) {
+  void* mem;
+  size_t req = 0;
+  if (n_elements != 0) {
+    req = n_elements * elem_size;
+    if (((n_elements | elem_size) & ~(size_t)0xffff) &&
+        (req / n_elements != elem_size))
+      req = MAX_SIZE_T; /* force downstream failure on overflow */
+  }
+  mem = SDL_malloc(req);
+  if (mem != 0 && calloc_must_clear(mem2chunk(mem)))
+    memset(mem, 0, req);
+  return mem;
+}
+
+void* SDL_realloc(void* oldmem, size_t bytes) {
+  mstate fm;
+  thread_cache* owner;
+  if (oldmem == 0)
+    return SDL_malloc(bytes);
+#ifdef REALLOC_ZERO_BYTES_FREES
+  if (bytes == 0) {
+    SDL_free(oldmem);
+    return 0;
+  }
+#endif /* REALLOC_ZERO_BYTES_FREES */
+  fm = space_for(oldmem);
+  if (fm == 0)
+    return 0;
+  owner = (thread_cache*)fm->cache;
+  if (owner == 0 || owner == current_cache()) {
+    return mspace_realloc(fm, oldmem, bytes);
+  }
+  else {
+    /* Someone else's chunk can't grow in place, so move it here */
+    void* newmem = SDL_malloc(bytes);
+    if (newmem != 0) {
+      mchunkptr oldp = mem2chunk(oldmem);
+      size_t oc = chunksize(oldp) - overhead_for(oldp);
+      memcpy(newmem, oldmem, (oc < bytes)? oc : bytes);
+      SDL_free(oldmem);
+    }
+    return newmem;
+  }
+}
+
+#endif /* THREAD_CACHE */
+
 /* -------------------- Alternative MORECORE functions ------------------- */
 
 /*
@@ -0,0 +1,56 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+#ifndef _SDL_barrier_h
+#define _SDL_barrier_h
+
+/* A full memory barrier, for the few lock-free structures inside SDL.
+   SDL_MemoryBarrier is left undefined where there is no way to get one,
+   and code using it should fall back to a mutex.
+
+   SDL_CompareAndSwapPointer(p, old, new) sets *p to 'new' only if it
+   still holds 'old', and returns non-zero if it did.  It is left
+   undefined in the same way.
+*/
+#if defined(__GNUC__) && \
+    ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 1)))
+#define SDL_MemoryBarrier()	__sync_synchronize()
+#define SDL_CompareAndSwapPointer(p, old, new) \
+	__sync_bool_compare_and_swap(p, old, new)
+#elif defined(_MSC_VER) && (_MSC_VER >= 1400) && \
+      (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+/* x86 keeps stores in order, so only the compiler needs holding back */
+#define SDL_MemoryBarrier()	_ReadWriteBarrier()
+#ifdef _M_X64
+#define SDL_CompareAndSwapPointer(p, old, new) \
+	(_InterlockedCompareExchangePointer((void * volatile *)(p), \
+	        (void *)(new), (void *)(old)) == (void *)(old))
+#else
+#define SDL_CompareAndSwapPointer(p, old, new) \
+	(_InterlockedCompareExchange((long volatile *)(p), \
+	        (long)(new), (long)(old)) == (long)(old))
+#endif
+#endif
+
+#endif /* _SDL_barrier_h */
@@ -49,4 +49,14 @@ extern void SDL_SYS_WaitThread(SDL_Thread *thread);
 /* This function kills the thread and returns */
 extern void SDL_SYS_KillThread(SDL_Thread *thread);
 
+#if SDL_THREAD_TLS
+/* These functions get and set a pointer private to the calling thread,
+   used to give every thread its own error buffer.  SDL_SYS_GetTLSData()
+   returns NULL until SDL_SYS_SetTLSData() succeeds in that thread, and the
+   data is released with SDL_free() when the thread exits.
+ */
+extern void *SDL_SYS_GetTLSData(void);
+extern int SDL_SYS_SetTLSData(void *data);
+#endif
+
 #endif /* _SDL_systhread_h */
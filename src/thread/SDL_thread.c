@@ -149,6 +149,23 @@ SDL_error *SDL_GetErrBuf(void)
 {
 	SDL_error *errbuf;
 
+#if SDL_THREAD_TLS
+	/* Every thread, SDL's or not, gets a buffer the first time it asks.
+	   Don't use SDL_OutOfMemory() here, it would come right back to us.
+	 */
+	errbuf = (SDL_error *)SDL_SYS_GetTLSData();
+	if ( errbuf == NULL ) {
+		errbuf = (SDL_error *)SDL_calloc(1, sizeof(*errbuf));
+		if ( errbuf && (SDL_SYS_SetTLSData(errbuf) < 0) ) {
+			SDL_free(errbuf);
+			errbuf = NULL;
+		}
+	}
+	if ( errbuf ) {
+		return(errbuf);
+	}
+#endif /* SDL_THREAD_TLS */
+
 	errbuf = &SDL_global_error;
 	if ( SDL_Threads ) {
 		int i;
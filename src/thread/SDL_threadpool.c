@@ -0,0 +1,666 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* A work-stealing pool of worker threads.
+
+   Each worker owns a queue of jobs, a ring buffer behind its own mutex.
+   The worker takes its newest job first, which keeps the data of jobs
+   it queued itself warm in its cache, and when its queue is empty it
+   steals the oldest job from the other queues in turn.  The pool lock
+   is only taken to wake sleeping workers: submitting bumps 'epoch', and
+   a worker only sleeps if 'epoch' hasn't moved since it last found every
+   queue empty, so no wakeup is ever lost.
+
+   Everything is built on SDL_mutex and SDL_cond, so it runs on the
+   native condition variables of the pthread backend and on the ones the
+   generic backend builds from semaphores.
+*/
+
+#include "SDL_timer.h"
+#include "SDL_thread.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_threadpool.h"
+
+/* Job timing uses the high resolution counter where there is one */
+#ifdef SDL_HAS_64BIT_TYPE
+typedef Uint64 SDL_JobTime;
+#define SDL_GetJobTime()	SDL_GetPerformanceCounter()
+#define SDL_JobTimeFrequency()	((double)SDL_GetPerformanceFrequency())
+#else
+typedef Uint32 SDL_JobTime;
+#define SDL_GetJobTime()	SDL_GetTicks()
+#define SDL_JobTimeFrequency()	1000.0
+#endif
+
+typedef struct SDL_Job {
+	SDL_JobFunction fn;
+	void *data;
+	SDL_JobGroup *group;
+	SDL_JobTime queued;
+} SDL_Job;
+
+typedef struct SDL_JobStats {
+	Uint32 jobs;
+	Uint32 stolen;
+	Uint32 helped;
+	SDL_JobTime run_time;
+	SDL_JobTime max_run_time;
+	SDL_JobTime wait_time;
+	SDL_JobTime max_wait_time;
+} SDL_JobStats;
+
+typedef struct SDL_Worker {
+	SDL_ThreadPool *pool;
+	SDL_Thread *thread;
+	Uint32 threadid;
+	SDL_mutex *lock;	/* Protects the queue */
+	SDL_Job *queue;		/* A ring of 'size' jobs, a power of two */
+	int size;
+	int head;		/* The oldest job */
+	int count;
+	SDL_JobStats stats;	/* Only touched by the worker thread */
+} SDL_Worker;
+
+struct SDL_ThreadPool {
+	int threads;
+	SDL_Worker *workers;
+	SDL_mutex *lock;	/* Protects everything below */
+	SDL_cond *wake;
+	Uint32 epoch;		/* Bumped whenever jobs are queued */
+	int sleeping;
+	int quit;
+	SDL_JobStats stats;	/* Jobs run by threads outside the pool */
+};
+
+struct SDL_JobGroup {
+	SDL_ThreadPool *pool;
+	SDL_mutex *lock;	/* Protects everything below */
+	SDL_cond *done;
+	int pending;
+	Uint32 submitted;
+};
+
+/* The pool shared by SDL and the application */
+static SDL_ThreadPool *SDL_pool = NULL;
+
+#define SDL_MIN_QUEUE	64
+
+/* Return the worker running on this thread, or NULL if there isn't one */
+static SDL_Worker *SDL_FindWorker(SDL_ThreadPool *pool)
+{
+	Uint32 threadid;
+	int i;
+
+	threadid = SDL_ThreadID();
+	for ( i = 0; i < pool->threads; ++i ) {
+		if ( pool->workers[i].threadid == threadid ) {
+			return(&pool->workers[i]);
+		}
+	}
+	return(NULL);
+}
+
+static int SDL_PushJob(SDL_Worker *worker, const SDL_Job *job)
+{
+	SDL_mutexP(worker->lock);
+	if ( worker->count == worker->size ) {
+		SDL_Job *queue;
+		int size, tail;
+
+		size = worker->size * 2;
+		queue = (SDL_Job *)SDL_realloc(worker->queue,
+						size*sizeof(*queue));
+		if ( queue == NULL ) {
+			SDL_mutexV(worker->lock);
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		/* Unwrap the jobs that wrapped around the old end */
+		tail = worker->head + worker->count - worker->size;
+		if ( tail > 0 ) {
+			SDL_memcpy(queue + worker->size, queue,
+						tail*sizeof(*queue));
+		}
+		worker->queue = queue;
+		worker->size = size;
+	}
+	worker->queue[(worker->head+worker->count) & (worker->size-1)] = *job;
+	++worker->count;
+	SDL_mutexV(worker->lock);
+	return(0);
+}
+
+/* Take the newest job from our own queue, or the oldest from another */
+static int SDL_TakeJob(SDL_ThreadPool *pool, SDL_Worker *self, SDL_Job *job)
+{
+	SDL_Worker *worker;
+	int first, i;
+
+	if ( self ) {
+		SDL_mutexP(self->lock);
+		if ( self->count > 0 ) {
+			--self->count;
+			*job = self->queue[(self->head+self->count) &
+							(self->size-1)];
+			SDL_mutexV(self->lock);
+			return(1);
+		}
+		SDL_mutexV(self->lock);
+		first = (int)(self - pool->workers) + 1;
+	} else {
+		first = 0;
+	}
+	for ( i = 0; i < pool->threads; ++i ) {
+		worker = &pool->workers[(first + i) % pool->threads];
+		if ( worker == self ) {
+			continue;
+		}
+		SDL_mutexP(worker->lock);
+		if ( worker->count > 0 ) {
+			*job = worker->queue[worker->head];
+			worker->head = (worker->head+1) & (worker->size-1);
+			--worker->count;
+			SDL_mutexV(worker->lock);
+			if ( self ) {
+				++self->stats.stolen;
+			}
+			return(1);
+		}
+		SDL_mutexV(worker->lock);
+	}
+	return(0);
+}
+
+static void SDL_RunJob(SDL_ThreadPool *pool, SDL_Worker *self,
+						SDL_Job *job, int helping)
+{
+	SDL_JobGroup *group;
+	SDL_JobStats *stats;
+	SDL_JobTime start, run, wait;
+
+	start = SDL_GetJobTime();
+	job->fn(job->data);
+	run = SDL_GetJobTime() - start;
+	wait = start - job->queued;
+
+	/* Workers keep their own statistics, anybody else shares the pool's */
+	if ( self ) {
+		stats = &self->stats;
+	} else {
+		SDL_mutexP(pool->lock);
+		stats = &pool->stats;
+	}
+	++stats->jobs;
+	if ( helping ) {
+		++stats->helped;
+	}
+	stats->run_time += run;
+	if ( run > stats->max_run_time ) {
+		stats->max_run_time = run;
+	}
+	stats->wait_time += wait;
+	if ( wait > stats->max_wait_time ) {
+		stats->max_wait_time = wait;
+	}
+	if ( ! self ) {
+		SDL_mutexV(pool->lock);
+	}
+
+	/* The group may be freed as soon as this is done */
+	group = job->group;
+	SDL_mutexP(group->lock);
+	if ( --group->pending == 0 ) {
+		SDL_CondBroadcast(group->done);
+	}
+	SDL_mutexV(group->lock);
+}
+
+static void SDL_WakeWorkers(SDL_ThreadPool *pool, int jobs)
+{
+	SDL_mutexP(pool->lock);
+	++pool->epoch;
+	if ( pool->sleeping > 0 ) {
+		if ( jobs == 1 ) {
+			SDL_CondSignal(pool->wake);
+		} else {
+			SDL_CondBroadcast(pool->wake);
+		}
+	}
+	SDL_mutexV(pool->lock);
+}
+
+static int SDLCALL SDL_RunWorker(void *data)
+{
+	SDL_Worker *worker = (SDL_Worker *)data;
+	SDL_ThreadPool *pool = worker->pool;
+	SDL_Job job;
+	Uint32 epoch;
+	int quit;
+
+	SDL_mutexP(pool->lock);
+	epoch = pool->epoch;
+	SDL_mutexV(pool->lock);
+
+	for ( ; ; ) {
+		if ( SDL_TakeJob(pool, worker, &job) ) {
+			SDL_RunJob(pool, worker, &job, 0);
+			continue;
+		}
+
+		/* Every queue was empty after 'epoch' was read */
+		SDL_mutexP(pool->lock);
+		while ( (pool->epoch == epoch) && !pool->quit ) {
+			++pool->sleeping;
+			SDL_CondWait(pool->wake, pool->lock);
+			--pool->sleeping;
+		}
+		quit = (pool->epoch == epoch);
+		epoch = pool->epoch;
+		SDL_mutexV(pool->lock);
+		if ( quit ) {
+			break;
+		}
+	}
+	return(0);
+}
+
+SDL_ThreadPool *SDL_CreateThreadPool(int threads)
+{
+	SDL_ThreadPool *pool;
+	SDL_Worker *worker;
+	int i;
+
+	if ( threads <= 0 ) {
+		threads = SDL_GetCPUCount() - 1;
+	}
+#if SDL_THREADS_DISABLED
+	threads = 0;
+#endif
+
+	pool = (SDL_ThreadPool *)SDL_malloc(sizeof(*pool));
+	if ( pool == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_memset(pool, 0, sizeof(*pool));
+	pool->lock = SDL_CreateMutex();
+	pool->wake = SDL_CreateCond();
+	if ( threads > 0 ) {
+		pool->workers = (SDL_Worker *)SDL_malloc(
+					threads*sizeof(*pool->workers));
+		if ( pool->workers == NULL ) {
+			SDL_OutOfMemory();
+		} else {
+			SDL_memset(pool->workers, 0,
+					threads*sizeof(*pool->workers));
+		}
+	}
+	if ( !pool->lock || !pool->wake || (threads && !pool->workers) ) {
+		SDL_DestroyThreadPool(pool);
+		return(NULL);
+	}
+
+	/* Start the workers, making do with fewer if some can't start.
+	   They wait on the pool lock until they have all been set up.
+	 */
+	SDL_mutexP(pool->lock);
+	for ( i = 0; i < threads; ++i ) {
+		worker = &pool->workers[pool->threads];
+		worker->pool = pool;
+		worker->size = SDL_MIN_QUEUE;
+		worker->queue = (SDL_Job *)SDL_malloc(
+					worker->size*sizeof(*worker->queue));
+		worker->lock = SDL_CreateMutex();
+		if ( worker->queue && worker->lock ) {
+#if (defined(__WIN32__) && !defined(_WIN32_WCE)) && !defined(HAVE_LIBC) && !defined(__SYMBIAN32__)
+#undef SDL_CreateThread
+			worker->thread = SDL_CreateThread(SDL_RunWorker, worker, NULL, NULL);
+#else
+			worker->thread = SDL_CreateThread(SDL_RunWorker, worker);
+#endif
+		}
+		if ( worker->thread == NULL ) {
+			if ( worker->lock ) {
+				SDL_DestroyMutex(worker->lock);
+			}
+			if ( worker->queue ) {
+				SDL_free(worker->queue);
+			}
+			SDL_memset(worker, 0, sizeof(*worker));
+			break;
+		}
+		worker->threadid = SDL_GetThreadID(worker->thread);
+		++pool->threads;
+	}
+	SDL_mutexV(pool->lock);
+	return(pool);
+}
+
+SDL_ThreadPool *SDL_GetThreadPool(void)
+{
+	const char *env;
+
+	/* Like the thread list, this expects the first call to come before
+	   there are other threads that might race it.
+	 */
+	if ( SDL_pool == NULL ) {
+		env = SDL_getenv("SDL_THREAD_POOL_SIZE");
+		SDL_pool = SDL_CreateThreadPool(env ? SDL_atoi(env) : 0);
+	}
+	return(SDL_pool);
+}
+
+void SDL_QuitThreadPool(void)
+{
+	if ( SDL_pool ) {
+		SDL_DestroyThreadPool(SDL_pool);
+		SDL_pool = NULL;
+	}
+}
+
+int SDL_GetThreadPoolSize(SDL_ThreadPool *pool)
+{
+	if ( pool == NULL ) {
+		pool = SDL_GetThreadPool();
+	}
+	return(pool ? pool->threads : 0);
+}
+
+void SDL_DestroyThreadPool(SDL_ThreadPool *pool)
+{
+	SDL_Worker *worker;
+	int i;
+
+	if ( pool == NULL ) {
+		return;
+	}
+	if ( pool->threads > 0 ) {
+		/* The workers drain their queues before they see this */
+		SDL_mutexP(pool->lock);
+		pool->quit = 1;
+		SDL_CondBroadcast(pool->wake);
+		SDL_mutexV(pool->lock);
+		for ( i = 0; i < pool->threads; ++i ) {
+			SDL_WaitThread(pool->workers[i].thread, NULL);
+		}
+		/* Workers look in each other's queues until they exit */
+		for ( i = 0; i < pool->threads; ++i ) {
+			worker = &pool->workers[i];
+			SDL_DestroyMutex(worker->lock);
+			SDL_free(worker->queue);
+		}
+	}
+	if ( pool->workers ) {
+		SDL_free(pool->workers);
+	}
+	if ( pool->wake ) {
+		SDL_DestroyCond(pool->wake);
+	}
+	if ( pool->lock ) {
+		SDL_DestroyMutex(pool->lock);
+	}
+	SDL_free(pool);
+}
+
+SDL_JobGroup *SDL_CreateJobGroup(SDL_ThreadPool *pool)
+{
+	SDL_JobGroup *group;
+
+	if ( pool == NULL ) {
+		pool = SDL_GetThreadPool();
+		if ( pool == NULL ) {
+			return(NULL);
+		}
+	}
+	group = (SDL_JobGroup *)SDL_malloc(sizeof(*group));
+	if ( group == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	SDL_memset(group, 0, sizeof(*group));
+	group->pool = pool;
+	group->lock = SDL_CreateMutex();
+	group->done = SDL_CreateCond();
+	if ( !group->lock || !group->done ) {
+		SDL_FreeJobGroup(group);
+		return(NULL);
+	}
+	return(group);
+}
+
+/* Queue a job without waking anybody, or run it now without workers */
+static int SDL_AddJob(SDL_JobGroup *group, SDL_JobFunction fn, void *data)
+{
+	SDL_ThreadPool *pool = group->pool;
+	SDL_Worker *worker;
+	SDL_Job job;
+	Uint32 which;
+
+	job.fn = fn;
+	job.data = data;
+	job.group = group;
+	job.queued = SDL_GetJobTime();
+
+	SDL_mutexP(group->lock);
+	++group->pending;
+	which = group->submitted++;
+	SDL_mutexV(group->lock);
+
+	if ( pool->threads == 0 ) {
+		SDL_RunJob(pool, NULL, &job, 0);
+		return(0);
+	}
+
+	/* Keep jobs on this worker, or spread them over all the workers */
+	worker = SDL_FindWorker(pool);
+	if ( worker == NULL ) {
+		worker = &pool->workers[which % pool->threads];
+	}
+	if ( SDL_PushJob(worker, &job) < 0 ) {
+		SDL_mutexP(group->lock);
+		--group->pending;
+		SDL_mutexV(group->lock);
+		return(-1);
+	}
+	return(0);
+}
+
+int SDL_SubmitJob(SDL_JobGroup *group, SDL_JobFunction fn, void *data)
+{
+	if ( SDL_AddJob(group, fn, data) < 0 ) {
+		return(-1);
+	}
+	if ( group->pool->threads > 0 ) {
+		SDL_WakeWorkers(group->pool, 1);
+	}
+	return(0);
+}
+
+void SDL_WaitJobGroup(SDL_JobGroup *group)
+{
+	SDL_ThreadPool *pool = group->pool;
+	SDL_Worker *self;
+	SDL_Job job;
+	int pending;
+
+	self = SDL_FindWorker(pool);
+	for ( ; ; ) {
+		SDL_mutexP(group->lock);
+		pending = group->pending;
+		SDL_mutexV(group->lock);
+		if ( pending == 0 ) {
+			break;
+		}
+
+		/* Help with any queued job, ours or not, rather than sleep */
+		if ( SDL_TakeJob(pool, self, &job) ) {
+			SDL_RunJob(pool, self, &job, 1);
+			continue;
+		}
+		SDL_mutexP(group->lock);
+		if ( group->pending > 0 ) {
+			SDL_CondWait(group->done, group->lock);
+		}
+		SDL_mutexV(group->lock);
+	}
+}
+
+void SDL_FreeJobGroup(SDL_JobGroup *group)
+{
+	if ( group == NULL ) {
+		return;
+	}
+	if ( group->lock && group->done ) {
+		SDL_WaitJobGroup(group);
+	}
+	if ( group->done ) {
+		SDL_DestroyCond(group->done);
+	}
+	if ( group->lock ) {
+		SDL_DestroyMutex(group->lock);
+	}
+	SDL_free(group);
+}
+
+typedef struct SDL_Range {
+	SDL_RangeFunction fn;
+	void *data;
+	int first;
+	int last;
+} SDL_Range;
+
+static void SDLCALL SDL_RunRange(void *data)
+{
+	SDL_Range *range = (SDL_Range *)data;
+
+	range->fn(range->data, range->first, range->last);
+}
+
+int SDL_ParallelFor(SDL_ThreadPool *pool, int count, int grain,
+					SDL_RangeFunction fn, void *data)
+{
+	SDL_JobGroup *group;
+	SDL_Range *ranges;
+	int i, n;
+
+	if ( pool == NULL ) {
+		pool = SDL_GetThreadPool();
+	}
+	if ( count <= 0 ) {
+		return(0);
+	}
+	if ( grain <= 0 ) {
+		grain = pool ? count / ((pool->threads+1)*4) : count;
+		if ( grain <= 0 ) {
+			grain = 1;
+		}
+	}
+	n = (count + grain - 1) / grain;
+	if ( !pool || (pool->threads == 0) || (n == 1) ) {
+		fn(data, 0, count);
+		return(0);
+	}
+
+	group = SDL_CreateJobGroup(pool);
+	ranges = (SDL_Range *)SDL_malloc(n*sizeof(*ranges));
+	if ( !group || !ranges ) {
+		if ( ranges ) {
+			SDL_free(ranges);
+		} else {
+			SDL_OutOfMemory();
+		}
+		SDL_FreeJobGroup(group);
+		return(-1);
+	}
+
+	/* Queue every range before waking the workers all at once */
+	for ( i = 0; i < n; ++i ) {
+		ranges[i].fn = fn;
+		ranges[i].data = data;
+		ranges[i].first = i * grain;
+		ranges[i].last = (i == n-1) ? count : (i+1) * grain;
+		if ( SDL_AddJob(group, SDL_RunRange, &ranges[i]) < 0 ) {
+			SDL_RunRange(&ranges[i]);
+		}
+	}
+	SDL_WakeWorkers(pool, n);
+	SDL_FreeJobGroup(group);
+	SDL_free(ranges);
+	return(0);
+}
+
+static void SDL_AddJobStats(SDL_ThreadPoolStats *stats,
+				const SDL_JobStats *add, double frequency)
+{
+	stats->jobs += add->jobs;
+	stats->stolen += add->stolen;
+	stats->helped += add->helped;
+	stats->run_time += add->run_time / frequency;
+	if ( add->max_run_time / frequency > stats->max_run_time ) {
+		stats->max_run_time = add->max_run_time / frequency;
+	}
+	stats->wait_time += add->wait_time / frequency;
+	if ( add->max_wait_time / frequency > stats->max_wait_time ) {
+		stats->max_wait_time = add->max_wait_time / frequency;
+	}
+}
+
+void SDL_GetThreadPoolStats(SDL_ThreadPool *pool, SDL_ThreadPoolStats *stats)
+{
+	double frequency;
+	int i;
+
+	SDL_memset(stats, 0, sizeof(*stats));
+	if ( pool == NULL ) {
+		pool = SDL_GetThreadPool();
+		if ( pool == NULL ) {
+			return;
+		}
+	}
+	frequency = SDL_JobTimeFrequency();
+	stats->threads = pool->threads;
+	for ( i = 0; i < pool->threads; ++i ) {
+		SDL_AddJobStats(stats, &pool->workers[i].stats, frequency);
+	}
+	SDL_mutexP(pool->lock);
+	SDL_AddJobStats(stats, &pool->stats, frequency);
+	SDL_mutexV(pool->lock);
+}
+
+void SDL_ResetThreadPoolStats(SDL_ThreadPool *pool)
+{
+	int i;
+
+	if ( pool == NULL ) {
+		pool = SDL_GetThreadPool();
+		if ( pool == NULL ) {
+			return;
+		}
+	}
+	for ( i = 0; i < pool->threads; ++i ) {
+		SDL_memset(&pool->workers[i].stats, 0, sizeof(SDL_JobStats));
+	}
+	SDL_mutexP(pool->lock);
+	SDL_memset(&pool->stats, 0, sizeof(pool->stats));
+	SDL_mutexV(pool->lock);
+}
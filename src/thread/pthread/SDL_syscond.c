@@ -100,6 +100,9 @@ int SDL_CondWaitTimeout(SDL_cond *cond, SDL_mutex *mutex, Uint32 ms)
 	int retval;
 	struct timeval delta;
 	struct timespec abstime;
+#if FAKE_RECURSIVE_MUTEX
+	int recursive;
+#endif
 
 	if ( ! cond ) {
 		SDL_SetError("Passed a NULL condition variable");
@@ -115,6 +118,14 @@ int SDL_CondWaitTimeout(SDL_cond *cond, SDL_mutex *mutex, Uint32 ms)
           abstime.tv_nsec -= 1000000000;
         }
 
+#if FAKE_RECURSIVE_MUTEX
+	/* The wait releases the lock behind SDL_mutexV()'s back,
+	   so hand the ownership over while we're asleep.
+	 */
+	recursive = mutex->recursive;
+	mutex->owner = 0;
+	mutex->recursive = 0;
+#endif
   tryagain:
 	retval = pthread_cond_timedwait(&cond->cond, &mutex->id, &abstime);
 	switch (retval) {
@@ -131,6 +142,10 @@ int SDL_CondWaitTimeout(SDL_cond *cond, SDL_mutex *mutex, Uint32 ms)
 		retval = -1;
 		break;
 	}
+#if FAKE_RECURSIVE_MUTEX
+	mutex->owner = pthread_self();
+	mutex->recursive = recursive;
+#endif
 	return retval;
 }
 
@@ -140,16 +155,31 @@ int SDL_CondWaitTimeout(SDL_cond *cond, SDL_mutex *mutex, Uint32 ms)
 int SDL_CondWait(SDL_cond *cond, SDL_mutex *mutex)
 {
 	int retval;
+#if FAKE_RECURSIVE_MUTEX
+	int recursive;
+#endif
 
 	if ( ! cond ) {
 		SDL_SetError("Passed a NULL condition variable");
 		return -1;
 	}
 
+#if FAKE_RECURSIVE_MUTEX
+	/* The wait releases the lock behind SDL_mutexV()'s back,
+	   so hand the ownership over while we're asleep.
+	 */
+	recursive = mutex->recursive;
+	mutex->owner = 0;
+	mutex->recursive = 0;
+#endif
 	retval = 0;
 	if ( pthread_cond_wait(&cond->cond, &mutex->id) != 0 ) {
 		SDL_SetError("pthread_cond_wait() failed");
 		retval = -1;
 	}
+#if FAKE_RECURSIVE_MUTEX
+	mutex->owner = pthread_self();
+	mutex->recursive = recursive;
+#endif
 	return retval;
 }
@@ -24,19 +24,7 @@
 #include <pthread.h>
 
 #include "SDL_thread.h"
-
-#if !SDL_THREAD_PTHREAD_RECURSIVE_MUTEX && \
-    !SDL_THREAD_PTHREAD_RECURSIVE_MUTEX_NP
-#define FAKE_RECURSIVE_MUTEX 1
-#endif
-
-struct SDL_mutex {
-	pthread_mutex_t id;
-#if FAKE_RECURSIVE_MUTEX
-	int recursive;
-	pthread_t owner;
-#endif
-};
+#include "SDL_sysmutex_c.h"
 
 SDL_mutex *SDL_CreateMutex (void)
 {
@@ -24,8 +24,17 @@
 #ifndef _SDL_mutex_c_h
 #define _SDL_mutex_c_h
 
+#if !SDL_THREAD_PTHREAD_RECURSIVE_MUTEX && \
+    !SDL_THREAD_PTHREAD_RECURSIVE_MUTEX_NP
+#define FAKE_RECURSIVE_MUTEX 1
+#endif
+
 struct SDL_mutex {
 	pthread_mutex_t id;
+#if FAKE_RECURSIVE_MUTEX
+	int recursive;
+	pthread_t owner;
+#endif
 };
 
 #endif /* _SDL_mutex_c_h */
@@ -118,3 +118,38 @@ void SDL_SYS_KillThread(SDL_Thread *thread)
 	pthread_kill(thread->handle, SIGKILL);
 #endif
 }
+
+/* Thread-local storage for SDL_GetErrBuf() */
+static pthread_key_t tls_key;
+static int tls_key_valid = 0;
+static pthread_once_t tls_once = PTHREAD_ONCE_INIT;
+
+static void FreeTLSData(void *data)
+{
+	SDL_free(data);
+}
+
+static void CreateTLSKey(void)
+{
+	if ( pthread_key_create(&tls_key, FreeTLSData) == 0 ) {
+		tls_key_valid = 1;
+	}
+}
+
+void *SDL_SYS_GetTLSData(void)
+{
+	pthread_once(&tls_once, CreateTLSKey);
+	if ( ! tls_key_valid ) {
+		return(NULL);
+	}
+	return(pthread_getspecific(tls_key));
+}
+
+int SDL_SYS_SetTLSData(void *data)
+{
+	pthread_once(&tls_once, CreateTLSKey);
+	if ( ! tls_key_valid || (pthread_setspecific(tls_key, data) != 0) ) {
+		return(-1);
+	}
+	return(0);
+}
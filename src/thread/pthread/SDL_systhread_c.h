@@ -24,3 +24,6 @@
 #include <pthread.h>
 
 typedef pthread_t SYS_ThreadHandle;
+
+/* This platform supports thread-local storage for the error buffer */
+#define SDL_THREAD_TLS	1
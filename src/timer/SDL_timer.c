@@ -43,12 +43,25 @@ struct _SDL_TimerID {
 	SDL_NewTimerCallback cb;
 	void *param;
 	Uint32 last_alarm;
-	struct _SDL_TimerID *next;
+	Uint32 next_alarm;	/* When the timer is due, ordering the heap */
+	int heap_index;		/* Position in SDL_timers, or -1 while running */
 };
 
-static SDL_TimerID SDL_timers = NULL;
+/* The timers are kept in a binary min-heap ordered by next_alarm, so the
+   timer thread only ever looks at the timer that is due first.
+ */
+static SDL_TimerID *SDL_timers = NULL;
+static int SDL_numtimers = 0;
+static int SDL_maxtimers = 0;
 static SDL_mutex *SDL_timer_mutex;
-static volatile SDL_bool list_changed = SDL_FALSE;
+
+/* The timer whose callback is running, and whether it was removed */
+static SDL_TimerID SDL_current_timer = NULL;
+static SDL_bool SDL_current_removed = SDL_FALSE;
+
+/* Used by the timer thread to sleep until the next timer is due */
+static SDL_cond *SDL_timer_cond;
+static SDL_bool SDL_timer_wakeup = SDL_FALSE;
 
 /* Set whether or not the timer should use a thread.
    This should not be called while the timer subsystem is running.
@@ -80,6 +93,7 @@ int SDL_TimerInit(void)
 	}
 	if ( SDL_timer_threaded ) {
 		SDL_timer_mutex = SDL_CreateMutex();
+		SDL_timer_cond = SDL_CreateCond();
 	}
 	if ( retval == 0 ) {
 		SDL_timer_started = 1;
@@ -94,69 +108,182 @@ void SDL_TimerQuit(void)
 		SDL_SYS_TimerQuit();
 	}
 	if ( SDL_timer_threaded ) {
+		SDL_DestroyCond(SDL_timer_cond);
+		SDL_timer_cond = NULL;
 		SDL_DestroyMutex(SDL_timer_mutex);
 		SDL_timer_mutex = NULL;
 	}
+	if ( SDL_timers ) {
+		SDL_free(SDL_timers);
+		SDL_timers = NULL;
+		SDL_maxtimers = 0;
+	}
 	SDL_timer_started = 0;
 	SDL_timer_threaded = 0;
 }
 
+/* Heap maintenance -- called with the timer mutex held */
+#define TIMER_BEFORE(A, B)	((Sint32)((A)->next_alarm - (B)->next_alarm) < 0)
+
+static void SDL_SetHeapTimer(int spot, SDL_TimerID t)
+{
+	SDL_timers[spot] = t;
+	t->heap_index = spot;
+}
+
+static void SDL_SiftTimer(int spot)
+{
+	SDL_TimerID t = SDL_timers[spot];
+	int parent, child;
+
+	/* Move up while it's due before its parent */
+	while ( spot > 0 ) {
+		parent = (spot-1)/2;
+		if ( ! TIMER_BEFORE(t, SDL_timers[parent]) ) {
+			break;
+		}
+		SDL_SetHeapTimer(spot, SDL_timers[parent]);
+		spot = parent;
+	}
+	/* Move down while one of its children is due before it */
+	while ( (child = 2*spot+1) < SDL_numtimers ) {
+		if ( (child+1 < SDL_numtimers) &&
+		     TIMER_BEFORE(SDL_timers[child+1], SDL_timers[child]) ) {
+			++child;
+		}
+		if ( ! TIMER_BEFORE(SDL_timers[child], t) ) {
+			break;
+		}
+		SDL_SetHeapTimer(spot, SDL_timers[child]);
+		spot = child;
+	}
+	SDL_SetHeapTimer(spot, t);
+}
+
+static int SDL_InsertTimer(SDL_TimerID t)
+{
+	/* A timer is due once more than its interval less a timeslice has
+	   elapsed, so it's never late on platforms that poll the timers.
+	 */
+	t->next_alarm = t->last_alarm + (t->interval - SDL_TIMESLICE) + 1;
+
+	if ( SDL_numtimers == SDL_maxtimers ) {
+		int maxtimers = SDL_maxtimers ? 2*SDL_maxtimers : 16;
+		SDL_TimerID *timers;
+
+		timers = (SDL_TimerID *)SDL_realloc(SDL_timers,
+					maxtimers*sizeof(*timers));
+		if ( timers == NULL ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		SDL_timers = timers;
+		SDL_maxtimers = maxtimers;
+	}
+	SDL_SetHeapTimer(SDL_numtimers++, t);
+	SDL_SiftTimer(t->heap_index);
+	return(0);
+}
+
+static void SDL_DeleteTimer(SDL_TimerID t)
+{
+	int spot = t->heap_index;
+
+	t->heap_index = -1;
+	if ( --SDL_numtimers > spot ) {
+		SDL_SetHeapTimer(spot, SDL_timers[SDL_numtimers]);
+		SDL_SiftTimer(spot);
+	}
+}
+
+/* Wake up the timer thread so it looks at the timers again */
+void SDL_ThreadedTimerWakeup(void)
+{
+	if ( SDL_timer_cond ) {
+		SDL_mutexP(SDL_timer_mutex);
+		SDL_timer_wakeup = SDL_TRUE;
+		SDL_CondSignal(SDL_timer_cond);
+		SDL_mutexV(SDL_timer_mutex);
+	}
+}
+
+/* Sleep until the next timer is due, or the set of timers changes */
+void SDL_ThreadedTimerWait(void)
+{
+	Sint32 ms;
+
+	if ( ! SDL_timer_cond ) {
+		/* Not set up yet, or no condition variables on this platform */
+		SDL_Delay(1);
+		return;
+	}
+
+	SDL_mutexP(SDL_timer_mutex);
+	if ( ! SDL_timer_wakeup ) {
+		if ( SDL_numtimers ) {
+			ms = (Sint32)(SDL_timers[0]->next_alarm - SDL_GetTicks());
+			if ( ms > 0 ) {
+				SDL_CondWaitTimeout(SDL_timer_cond, SDL_timer_mutex, ms);
+			}
+		} else {
+			SDL_CondWait(SDL_timer_cond, SDL_timer_mutex);
+		}
+	}
+	SDL_timer_wakeup = SDL_FALSE;
+	SDL_mutexV(SDL_timer_mutex);
+}
+
 void SDL_ThreadedTimerCheck(void)
 {
 	Uint32 now, ms;
-	SDL_TimerID t, prev, next;
-	SDL_bool removed;
+	SDL_TimerID t;
 
 	SDL_mutexP(SDL_timer_mutex);
-	list_changed = SDL_FALSE;
 	now = SDL_GetTicks();
-	for ( prev = NULL, t = SDL_timers; t; t = next ) {
-		removed = SDL_FALSE;
-		ms = t->interval - SDL_TIMESLICE;
-		next = t->next;
-		if ( (int)(now - t->last_alarm) > (int)ms ) {
-			struct _SDL_TimerID timer;
-
-			if ( (now - t->last_alarm) < t->interval ) {
-				t->last_alarm += t->interval;
-			} else {
-				t->last_alarm = now;
-			}
+	while ( SDL_numtimers ) {
+		t = SDL_timers[0];
+		if ( (Sint32)(now - t->next_alarm) < 0 ) {
+			/* Nothing else is due yet */
+			break;
+		}
+		if ( (now - t->last_alarm) < t->interval ) {
+			t->last_alarm += t->interval;
+		} else {
+			t->last_alarm = now;
+		}
 #ifdef DEBUG_TIMERS
-			printf("Executing timer %p (thread = %d)\n",
-				t, SDL_ThreadID());
+		printf("Executing timer %p (thread = %d)\n",
+			t, SDL_ThreadID());
 #endif
-			timer = *t;
-			SDL_mutexV(SDL_timer_mutex);
-			ms = timer.cb(timer.interval, timer.param);
-			SDL_mutexP(SDL_timer_mutex);
-			if ( list_changed ) {
-				/* Abort, list of timers modified */
-				/* FIXME: what if ms was changed? */
-				break;
-			}
-			if ( ms != t->interval ) {
-				if ( ms ) {
-					t->interval = ROUND_RESOLUTION(ms);
-				} else {
-					/* Remove timer from the list */
+		/* Take the timer out of the heap while its callback runs, so
+		   it can be removed without invalidating it under our feet.
+		 */
+		SDL_DeleteTimer(t);
+		SDL_current_timer = t;
+		SDL_current_removed = SDL_FALSE;
+		SDL_mutexV(SDL_timer_mutex);
+		ms = t->cb(t->interval, t->param);
+		SDL_mutexP(SDL_timer_mutex);
+		SDL_current_timer = NULL;
+
+		if ( SDL_current_removed ) {
+			/* SDL_RemoveTimer() was called from the callback */
+			SDL_free(t);
+		} else if ( ms == 0 ) {
+			/* Remove timer */
 #ifdef DEBUG_TIMERS
-					printf("SDL: Removing timer %p\n", t);
+			printf("SDL: Removing timer %p\n", t);
 #endif
-					if ( prev ) {
-						prev->next = next;
-					} else {
-						SDL_timers = next;
-					}
-					SDL_free(t);
-					--SDL_timer_running;
-					removed = SDL_TRUE;
-				}
+			SDL_free(t);
+			--SDL_timer_running;
+		} else {
+			if ( ms != t->interval ) {
+				t->interval = ROUND_RESOLUTION(ms);
+			}
+			if ( SDL_InsertTimer(t) < 0 ) {
+				SDL_free(t);
+				--SDL_timer_running;
 			}
-		}
-		/* Don't update prev if the timer has disappeared */
-		if ( ! removed ) {
-			prev = t;
 		}
 	}
 	SDL_mutexV(SDL_timer_mutex);
@@ -171,10 +298,15 @@ static SDL_TimerID SDL_AddTimerInternal(Uint32 interval, SDL_NewTimerCallback ca
 		t->cb = callback;
 		t->param = param;
 		t->last_alarm = SDL_GetTicks();
-		t->next = SDL_timers;
-		SDL_timers = t;
+		if ( SDL_InsertTimer(t) < 0 ) {
+			SDL_free(t);
+			return NULL;
+		}
 		++SDL_timer_running;
-		list_changed = SDL_TRUE;
+		SDL_timer_wakeup = SDL_TRUE;
+		if ( SDL_timer_cond ) {
+			SDL_CondSignal(SDL_timer_cond);
+		}
 	}
 #ifdef DEBUG_TIMERS
 	printf("SDL_AddTimer(%d) = %08x num_timers = %d\n", interval, (Uint32)t, SDL_timer_running);
@@ -203,26 +335,42 @@ SDL_TimerID SDL_AddTimer(Uint32 interval, SDL_NewTimerCallback callback, void *p
 	return t;
 }
 
+/* Remove a timer from the heap, or flag it if its callback is running
+   -- called with the timer mutex held */
+static void SDL_RemoveTimerInternal(SDL_TimerID t)
+{
+	if ( t == SDL_current_timer ) {
+		SDL_current_removed = SDL_TRUE;
+	} else {
+		SDL_DeleteTimer(t);
+		SDL_free(t);
+	}
+	--SDL_timer_running;
+}
+
 SDL_bool SDL_RemoveTimer(SDL_TimerID id)
 {
-	SDL_TimerID t, prev = NULL;
+	int i;
 	SDL_bool removed;
 
 	removed = SDL_FALSE;
 	SDL_mutexP(SDL_timer_mutex);
-	/* Look for id in the linked list of timers */
-	for (t = SDL_timers; t; prev=t, t = t->next ) {
-		if ( t == id ) {
-			if(prev) {
-				prev->next = t->next;
-			} else {
-				SDL_timers = t->next;
+	/* Make sure id is a live timer before touching it */
+	if ( id && id == SDL_current_timer && ! SDL_current_removed ) {
+		removed = SDL_TRUE;
+	} else {
+		for ( i = 0; i < SDL_numtimers; ++i ) {
+			if ( SDL_timers[i] == id ) {
+				removed = SDL_TRUE;
+				break;
 			}
-			SDL_free(t);
-			--SDL_timer_running;
-			removed = SDL_TRUE;
-			list_changed = SDL_TRUE;
-			break;
+		}
+	}
+	if ( removed ) {
+		SDL_RemoveTimerInternal(id);
+		SDL_timer_wakeup = SDL_TRUE;
+		if ( SDL_timer_cond ) {
+			SDL_CondSignal(SDL_timer_cond);
 		}
 	}
 #ifdef DEBUG_TIMERS
@@ -232,6 +380,43 @@ SDL_bool SDL_RemoveTimer(SDL_TimerID id)
 	return removed;
 }
 
+#ifdef SDL_HAS_64BIT_TYPE
+#if !SDL_TIMER_UNIX
+/* Platforms without a high resolution clock count milliseconds */
+Uint64 SDL_GetPerformanceCounter(void)
+{
+	return(SDL_GetTicks());
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+	return(1000);
+}
+#endif /* !SDL_TIMER_UNIX */
+
+/* SDL_DelayPrecise() stops sleeping this many nanoseconds early and spins */
+#define DELAY_SPIN_NS	500000
+
+void SDL_DelayPrecise(Uint64 ns)
+{
+	Uint64 freq, now, target, left;
+
+	freq = SDL_GetPerformanceFrequency();
+	now = SDL_GetPerformanceCounter();
+	target = now + (ns/1000000000)*freq + ((ns%1000000000)*freq)/1000000000;
+	while ( now < target ) {
+		/* Sleep while there's more than a millisecond left to spare */
+		left = ((target-now)/freq)*1000000000 +
+		       (((target-now)%freq)*1000000000)/freq;
+		if ( left > DELAY_SPIN_NS + 1000000 ) {
+			left = (left - DELAY_SPIN_NS)/1000000;
+			SDL_Delay((left > 0x7FFFFFFF) ? 0x7FFFFFFF : (Uint32)left);
+		}
+		now = SDL_GetPerformanceCounter();
+	}
+}
+#endif /* SDL_HAS_64BIT_TYPE */
+
 /* Old style callback functions are wrapped through this */
 static Uint32 SDLCALL callback_wrapper(Uint32 ms, void *param)
 {
@@ -253,13 +438,13 @@ int SDL_SetTimer(Uint32 ms, SDL_TimerCallback callback)
 	}
 	if ( SDL_timer_running ) {	/* Stop any currently running timer */
 		if ( SDL_timer_threaded ) {
-			while ( SDL_timers ) {
-				SDL_TimerID freeme = SDL_timers;
-				SDL_timers = SDL_timers->next;
-				SDL_free(freeme);
+			while ( SDL_numtimers ) {
+				SDL_RemoveTimerInternal(SDL_timers[0]);
+			}
+			if ( SDL_current_timer && ! SDL_current_removed ) {
+				SDL_RemoveTimerInternal(SDL_current_timer);
 			}
 			SDL_timer_running = 0;
-			list_changed = SDL_TRUE;
 		} else {
 			SDL_SYS_StopTimer();
 			SDL_timer_running = 0;
@@ -44,3 +44,9 @@ extern void SDL_TimerQuit(void);
 
 /* This function is called from the SDL event thread if it is available */
 extern void SDL_ThreadedTimerCheck(void);
+
+/* These are used by a dedicated timer thread to sleep until the next timer
+   is due, and to wake it up when it's time to quit.
+ */
+extern void SDL_ThreadedTimerWait(void);
+extern void SDL_ThreadedTimerWakeup(void);
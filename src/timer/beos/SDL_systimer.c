@@ -57,7 +57,7 @@ static int RunTimer(void *unused)
 		if ( SDL_timer_running ) {
 			SDL_ThreadedTimerCheck();
 		}
-		SDL_Delay(10);
+		SDL_ThreadedTimerWait();
 	}
 	return(0);
 }
@@ -75,6 +75,7 @@ int SDL_SYS_TimerInit(void)
 void SDL_SYS_TimerQuit(void)
 {
 	timer_alive = 0;
+	SDL_ThreadedTimerWakeup();
 	if ( timer ) {
 		SDL_WaitThread(timer, NULL);
 		timer = NULL;
@@ -26,6 +26,18 @@
 
 #include "SDL_endian.h"
 
+/* The SSE2 and NEON blitters are written with compiler intrinsics, so they
+   are built whenever the compiler is generating code for that unit.
+ */
+#if defined(__SSE2__) || (defined(_MSC_VER) && defined(_M_X64))
+#define SDL_SSE2_BLITTERS	1
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON)) && \
+      (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#define SDL_NEON_BLITTERS	1
+#include <arm_neon.h>
+#endif
+
 /* The structure passed to the low level blit functions */
 typedef struct {
 	Uint8 *s_pixels;
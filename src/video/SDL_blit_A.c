@@ -2583,6 +2583,402 @@ static void BlitARGBto555PixelAlpha(SDL_BlitInfo *info)
 	}
 }
 
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+/*
+ * SSE2 and NEON versions of the alpha blitters above.
+ *
+ * The C blitters compute every channel as d + ((s - d) * alpha >> bits),
+ * which is the same value as (s * alpha + d * (scale - alpha)) >> bits with
+ * scale = 1 << bits.  That form never goes negative and stays below 65536,
+ * so the vector units can do it in unsigned 16-bit lanes and still match
+ * the C blitters bit for bit, including their special cases.
+ */
+#if SDL_SSE2_BLITTERS
+#define HasSIMD()	SDL_HasSSE2()
+#else
+#define HasSIMD()	SDL_HasNEON()
+#endif
+
+/* Finish the last few pixels of a row with the C blitter */
+static __inline__ void BlitRowTail(SDL_loblit blit, SDL_BlitInfo *info,
+                                   void *srcp, void *dstp, int width)
+{
+	if(width > 0) {
+		SDL_BlitInfo tail = *info;
+		tail.s_pixels = (Uint8 *)srcp;
+		tail.d_pixels = (Uint8 *)dstp;
+		tail.d_width = width;
+		tail.d_height = 1;
+		blit(&tail);
+	}
+}
+
+#if SDL_SSE2_BLITTERS
+
+#define BLEND16_SSE2(s, d, a, ia, bits)					\
+	_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(s, a),		\
+	                             _mm_mullo_epi16(d, ia)), bits)
+
+/* select s where mask is set, d elsewhere */
+#define SELECT_SSE2(mask, s, d)						\
+	_mm_or_si128(_mm_and_si128(mask, s), _mm_andnot_si128(mask, d))
+
+/* split RGB565 pixels into 16-bit channel lanes */
+#define UNPACK565_SSE2(p, r, g, b)					\
+do {									\
+	r = _mm_srli_epi16(p, 11);					\
+	g = _mm_and_si128(_mm_srli_epi16(p, 5), _mm_set1_epi16(0x3f));	\
+	b = _mm_and_si128(p, _mm_set1_epi16(0x1f));			\
+} while(0)
+
+#define PACK565_SSE2(r, g, b)						\
+	_mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 11),		\
+	                          _mm_slli_epi16(g, 5)), b)
+
+/* SSE2 version of BlitRGBtoRGBPixelAlpha, 4 pixels at a time */
+static void BlitRGBtoRGBPixelAlphaSIMD(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c256 = _mm_set1_epi16(256);
+	const __m128i amask = _mm_set1_epi32(0xff000000);
+
+	while(height--) {
+		int n;
+		for(n = width; n >= 4; n -= 4) {
+			__m128i s = _mm_loadu_si128((__m128i *)srcp);
+			__m128i sa = _mm_and_si128(s, amask);
+			/* leave the destination alone if all 4 are transparent */
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(sa, zero)) != 0xffff) {
+				__m128i d = _mm_loadu_si128((__m128i *)dstp);
+				__m128i sl = _mm_unpacklo_epi8(s, zero);
+				__m128i sh = _mm_unpackhi_epi8(s, zero);
+				__m128i dl = _mm_unpacklo_epi8(d, zero);
+				__m128i dh = _mm_unpackhi_epi8(d, zero);
+				__m128i al = _mm_shufflehi_epi16(
+					_mm_shufflelo_epi16(sl, 0xff), 0xff);
+				__m128i ah = _mm_shufflehi_epi16(
+					_mm_shufflelo_epi16(sh, 0xff), 0xff);
+				__m128i r = _mm_packus_epi16(
+				    BLEND16_SSE2(sl, dl, al, _mm_sub_epi16(c256, al), 8),
+				    BLEND16_SSE2(sh, dh, ah, _mm_sub_epi16(c256, ah), 8));
+				/* opaque pixels are copied, as in the C version */
+				r = SELECT_SSE2(_mm_cmpeq_epi32(sa, amask), s, r);
+				/* and the destination alpha is always kept */
+				r = SELECT_SSE2(amask, d, r);
+				_mm_storeu_si128((__m128i *)dstp, r);
+			}
+			srcp += 4;
+			dstp += 4;
+		}
+		BlitRowTail(BlitRGBtoRGBPixelAlpha, info, srcp, dstp, n);
+		srcp += n + srcskip;
+		dstp += n + dstskip;
+	}
+}
+
+/* SSE2 version of BlitRGBtoRGBSurfaceAlpha, 4 pixels at a time */
+static void BlitRGBtoRGBSurfaceAlphaSIMD(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i a = _mm_set1_epi16(info->src->alpha);
+	const __m128i ia = _mm_set1_epi16(256 - info->src->alpha);
+	const __m128i amask = _mm_set1_epi32(0xff000000);
+
+	while(height--) {
+		int n;
+		for(n = width; n >= 4; n -= 4) {
+			__m128i s = _mm_loadu_si128((__m128i *)srcp);
+			__m128i d = _mm_loadu_si128((__m128i *)dstp);
+			__m128i r = _mm_packus_epi16(
+			    BLEND16_SSE2(_mm_unpacklo_epi8(s, zero),
+			                 _mm_unpacklo_epi8(d, zero), a, ia, 8),
+			    BLEND16_SSE2(_mm_unpackhi_epi8(s, zero),
+			                 _mm_unpackhi_epi8(d, zero), a, ia, 8));
+			_mm_storeu_si128((__m128i *)dstp, _mm_or_si128(r, amask));
+			srcp += 4;
+			dstp += 4;
+		}
+		BlitRowTail(BlitRGBtoRGBSurfaceAlpha, info, srcp, dstp, n);
+		srcp += n + srcskip;
+		dstp += n + dstskip;
+	}
+}
+
+/* SSE2 version of BlitARGBto565PixelAlpha, 8 pixels at a time */
+static void BlitARGBto565PixelAlphaSIMD(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c32 = _mm_set1_epi16(32);
+	const __m128i c31 = _mm_set1_epi16(31);
+	const __m128i mask5 = _mm_set1_epi32(0x1f);
+	const __m128i mask6 = _mm_set1_epi32(0x3f);
+
+	while(height--) {
+		int n;
+		for(n = width; n >= 8; n -= 8) {
+			__m128i s0 = _mm_loadu_si128((__m128i *)srcp);
+			__m128i s1 = _mm_loadu_si128((__m128i *)(srcp + 4));
+			/* downscale alpha to 5 bits */
+			__m128i a = _mm_packs_epi32(_mm_srli_epi32(s0, 27),
+			                            _mm_srli_epi32(s1, 27));
+			if(_mm_movemask_epi8(_mm_cmpeq_epi16(a, zero)) != 0xffff) {
+				__m128i d = _mm_loadu_si128((__m128i *)dstp);
+				__m128i sr, sg, sb, dr, dg, db, ia, opaque;
+				sr = _mm_packs_epi32(
+				    _mm_and_si128(_mm_srli_epi32(s0, 19), mask5),
+				    _mm_and_si128(_mm_srli_epi32(s1, 19), mask5));
+				sg = _mm_packs_epi32(
+				    _mm_and_si128(_mm_srli_epi32(s0, 10), mask6),
+				    _mm_and_si128(_mm_srli_epi32(s1, 10), mask6));
+				sb = _mm_packs_epi32(
+				    _mm_and_si128(_mm_srli_epi32(s0, 3), mask5),
+				    _mm_and_si128(_mm_srli_epi32(s1, 3), mask5));
+				UNPACK565_SSE2(d, dr, dg, db);
+				ia = _mm_sub_epi16(c32, a);
+				/* opaque pixels are copied, as in the C version */
+				opaque = _mm_cmpeq_epi16(a, c31);
+				dr = SELECT_SSE2(opaque, sr,
+				                 BLEND16_SSE2(sr, dr, a, ia, 5));
+				dg = SELECT_SSE2(opaque, sg,
+				                 BLEND16_SSE2(sg, dg, a, ia, 5));
+				db = SELECT_SSE2(opaque, sb,
+				                 BLEND16_SSE2(sb, db, a, ia, 5));
+				_mm_storeu_si128((__m128i *)dstp,
+				                 PACK565_SSE2(dr, dg, db));
+			}
+			srcp += 8;
+			dstp += 8;
+		}
+		BlitRowTail(BlitARGBto565PixelAlpha, info, srcp, dstp, n);
+		srcp += n + srcskip;
+		dstp += n + dstskip;
+	}
+}
+
+/* SSE2 version of Blit565to565SurfaceAlpha, 8 pixels at a time */
+static void Blit565to565SurfaceAlphaSIMD(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *srcp = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip >> 1;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
+	/* downscale alpha to 5 bits, alpha=128 averages just like the C code */
+	const __m128i a = _mm_set1_epi16(info->src->alpha >> 3);
+	const __m128i ia = _mm_set1_epi16(32 - (info->src->alpha >> 3));
+
+	while(height--) {
+		int n;
+		for(n = width; n >= 8; n -= 8) {
+			__m128i s = _mm_loadu_si128((__m128i *)srcp);
+			__m128i d = _mm_loadu_si128((__m128i *)dstp);
+			__m128i sr, sg, sb, dr, dg, db;
+			UNPACK565_SSE2(s, sr, sg, sb);
+			UNPACK565_SSE2(d, dr, dg, db);
+			_mm_storeu_si128((__m128i *)dstp, PACK565_SSE2(
+			    BLEND16_SSE2(sr, dr, a, ia, 5),
+			    BLEND16_SSE2(sg, dg, a, ia, 5),
+			    BLEND16_SSE2(sb, db, a, ia, 5)));
+			srcp += 8;
+			dstp += 8;
+		}
+		BlitRowTail(Blit565to565SurfaceAlpha, info, srcp, dstp, n);
+		srcp += n + srcskip;
+		dstp += n + dstskip;
+	}
+}
+
+#elif SDL_NEON_BLITTERS
+
+/* (s * a + d * (256 - a)) >> 8, without 256 - a overflowing a byte */
+#define BLEND8_NEON(s, d, a)						\
+	vshrn_n_u16(vsubq_u16(vaddq_u16(vmull_u8(s, a), vshll_n_u8(d, 8)),	\
+	                      vmull_u8(d, a)), 8)
+
+/* (s * a + d * ia) >> 5 for 5 and 6 bit channels */
+#define BLEND5_NEON(s, d, a, ia)					\
+	vshrn_n_u16(vmlal_u8(vmull_u8(s, a), d, ia), 5)
+
+/* split 8 RGB565 pixels into 8-bit channel lanes */
+#define UNPACK565_NEON(p, r, g, b)					\
+do {									\
+	r = vmovn_u16(vshrq_n_u16(p, 11));				\
+	g = vmovn_u16(vandq_u16(vshrq_n_u16(p, 5), vdupq_n_u16(0x3f)));	\
+	b = vmovn_u16(vandq_u16(p, vdupq_n_u16(0x1f)));			\
+} while(0)
+
+#define PACK565_NEON(r, g, b)						\
+	vorrq_u16(vorrq_u16(vshlq_n_u16(vmovl_u8(r), 11),		\
+	                    vshlq_n_u16(vmovl_u8(g), 5)), vmovl_u8(b))
+
+#define ALL_ZERO_NEON(v)	(vget_lane_u64(vreinterpret_u64_u8(v), 0) == 0)
+
+/* NEON version of BlitRGBtoRGBPixelAlpha, 8 pixels at a time */
+static void BlitRGBtoRGBPixelAlphaSIMD(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	const uint8x8_t opaque = vdup_n_u8(SDL_ALPHA_OPAQUE);
+
+	while(height--) {
+		int n;
+		for(n = width; n >= 8; n -= 8) {
+			uint8x8x4_t s = vld4_u8((const uint8_t *)srcp);
+			uint8x8_t a = s.val[3];
+			/* leave the destination alone if all 8 are transparent */
+			if(!ALL_ZERO_NEON(a)) {
+				uint8x8x4_t d = vld4_u8((const uint8_t *)dstp);
+				uint8x8_t is_opaque = vceq_u8(a, opaque);
+				int i;
+				/* opaque pixels are copied, as in the C version,
+				   and the destination alpha (val[3]) is kept */
+				for(i = 0; i < 3; ++i) {
+					d.val[i] = vbsl_u8(is_opaque, s.val[i],
+					    BLEND8_NEON(s.val[i], d.val[i], a));
+				}
+				vst4_u8((uint8_t *)dstp, d);
+			}
+			srcp += 8;
+			dstp += 8;
+		}
+		BlitRowTail(BlitRGBtoRGBPixelAlpha, info, srcp, dstp, n);
+		srcp += n + srcskip;
+		dstp += n + dstskip;
+	}
+}
+
+/* NEON version of BlitRGBtoRGBSurfaceAlpha, 8 pixels at a time */
+static void BlitRGBtoRGBSurfaceAlphaSIMD(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	const uint8x8_t a = vdup_n_u8(info->src->alpha);
+
+	while(height--) {
+		int n;
+		for(n = width; n >= 8; n -= 8) {
+			uint8x8x4_t s = vld4_u8((const uint8_t *)srcp);
+			uint8x8x4_t d = vld4_u8((const uint8_t *)dstp);
+			int i;
+			for(i = 0; i < 3; ++i) {
+				d.val[i] = BLEND8_NEON(s.val[i], d.val[i], a);
+			}
+			d.val[3] = vdup_n_u8(0xff);
+			vst4_u8((uint8_t *)dstp, d);
+			srcp += 8;
+			dstp += 8;
+		}
+		BlitRowTail(BlitRGBtoRGBSurfaceAlpha, info, srcp, dstp, n);
+		srcp += n + srcskip;
+		dstp += n + dstskip;
+	}
+}
+
+/* NEON version of BlitARGBto565PixelAlpha, 8 pixels at a time */
+static void BlitARGBto565PixelAlphaSIMD(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
+	const uint8x8_t c31 = vdup_n_u8(31);
+	const uint8x8_t c32 = vdup_n_u8(32);
+
+	while(height--) {
+		int n;
+		for(n = width; n >= 8; n -= 8) {
+			uint8x8x4_t s = vld4_u8((const uint8_t *)srcp);
+			/* downscale alpha to 5 bits */
+			uint8x8_t a = vshr_n_u8(s.val[3], 3);
+			if(!ALL_ZERO_NEON(a)) {
+				uint16x8_t d = vld1q_u16(dstp);
+				uint8x8_t sr = vshr_n_u8(s.val[2], 3);
+				uint8x8_t sg = vshr_n_u8(s.val[1], 2);
+				uint8x8_t sb = vshr_n_u8(s.val[0], 3);
+				uint8x8_t ia = vsub_u8(c32, a);
+				/* opaque pixels are copied, as in the C version */
+				uint8x8_t is_opaque = vceq_u8(a, c31);
+				uint8x8_t dr, dg, db;
+				UNPACK565_NEON(d, dr, dg, db);
+				dr = vbsl_u8(is_opaque, sr, BLEND5_NEON(sr, dr, a, ia));
+				dg = vbsl_u8(is_opaque, sg, BLEND5_NEON(sg, dg, a, ia));
+				db = vbsl_u8(is_opaque, sb, BLEND5_NEON(sb, db, a, ia));
+				vst1q_u16(dstp, PACK565_NEON(dr, dg, db));
+			}
+			srcp += 8;
+			dstp += 8;
+		}
+		BlitRowTail(BlitARGBto565PixelAlpha, info, srcp, dstp, n);
+		srcp += n + srcskip;
+		dstp += n + dstskip;
+	}
+}
+
+/* NEON version of Blit565to565SurfaceAlpha, 8 pixels at a time */
+static void Blit565to565SurfaceAlphaSIMD(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *srcp = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip >> 1;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
+	/* downscale alpha to 5 bits, alpha=128 averages just like the C code */
+	const uint8x8_t a = vdup_n_u8(info->src->alpha >> 3);
+	const uint8x8_t ia = vdup_n_u8(32 - (info->src->alpha >> 3));
+
+	while(height--) {
+		int n;
+		for(n = width; n >= 8; n -= 8) {
+			uint16x8_t s = vld1q_u16(srcp);
+			uint16x8_t d = vld1q_u16(dstp);
+			uint8x8_t sr, sg, sb, dr, dg, db;
+			UNPACK565_NEON(s, sr, sg, sb);
+			UNPACK565_NEON(d, dr, dg, db);
+			vst1q_u16(dstp, PACK565_NEON(BLEND5_NEON(sr, dr, a, ia),
+			                             BLEND5_NEON(sg, dg, a, ia),
+			                             BLEND5_NEON(sb, db, a, ia)));
+			srcp += 8;
+			dstp += 8;
+		}
+		BlitRowTail(Blit565to565SurfaceAlpha, info, srcp, dstp, n);
+		srcp += n + srcskip;
+		dstp += n + dstskip;
+	}
+}
+
+#endif /* SDL_SSE2_BLITTERS */
+#endif /* SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS */
+
 /* General (slow) N->N blending with per-surface alpha */
 static void BlitNtoNSurfaceAlpha(SDL_BlitInfo *info)
 {
@@ -2746,6 +3142,11 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		if(surface->map->identity) {
 		    if(df->Gmask == 0x7e0)
 		    {
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+		if(HasSIMD())
+			return Blit565to565SurfaceAlphaSIMD;
+		else
+#endif
 #if MMX_ASMBLIT
 		if(SDL_HasMMX())
 			return Blit565to565SurfaceAlphaMMX;
@@ -2771,6 +3172,11 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		   && sf->Bmask == df->Bmask
 		   && sf->BytesPerPixel == 4)
 		{
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+			if((sf->Rmask | sf->Gmask | sf->Bmask) == 0xffffff
+			   && HasSIMD())
+			    return BlitRGBtoRGBSurfaceAlphaSIMD;
+#endif
 #if MMX_ASMBLIT
 			if(sf->Rshift % 8 == 0
 			   && sf->Gshift % 8 == 0
@@ -2819,8 +3225,13 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 	       && sf->Gmask == 0xff00
 	       && ((sf->Rmask == 0xff && df->Rmask == 0x1f)
 		   || (sf->Bmask == 0xff && df->Bmask == 0x1f))) {
-		if(df->Gmask == 0x7e0)
+		if(df->Gmask == 0x7e0) {
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+		    if(HasSIMD())
+			return BlitARGBto565PixelAlphaSIMD;
+#endif
 		    return BlitARGBto565PixelAlpha;
+		}
 		else if(df->Gmask == 0x3e0)
 		    return BlitARGBto555PixelAlpha;
 	    }
@@ -2832,6 +3243,10 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 	       && sf->Bmask == df->Bmask
 	       && sf->BytesPerPixel == 4)
 	    {
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+		if(sf->Amask == 0xff000000 && HasSIMD())
+			return BlitRGBtoRGBPixelAlphaSIMD;
+#endif
 #if MMX_ASMBLIT
 		if(sf->Rshift % 8 == 0
 		   && sf->Gshift % 8 == 0
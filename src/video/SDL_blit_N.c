@@ -837,8 +837,10 @@ static Uint32 GetBlitFeatures( void )
 #pragma altivec_model off
 #endif
 #else
-/* Feature 1 is has-MMX */
-#define GetBlitFeatures() ((Uint32)(SDL_HasMMX() ? 1 : 0))
+/* Feature 1 is has-MMX, feature 8 is has-SSE2, feature 16 is has-NEON */
+#define GetBlitFeatures() ((Uint32)((SDL_HasMMX() ? 1 : 0) | \
+                                    (SDL_HasSSE2() ? 8 : 0) | \
+                                    (SDL_HasNEON() ? 16 : 0)))
 #endif
 
 /* This is now endian dependent */
@@ -2269,6 +2271,426 @@ static void BlitNtoNKeyCopyAlpha(SDL_BlitInfo *info)
 	}
 }
 
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+/*
+ * SIMD N to N blitters for 16 and 32 bit surfaces.
+ *
+ * Every destination channel is computed as ((pixel >> rshift) & mask) << lshift,
+ * which is exactly what the RGBA_FROM_PIXEL / PIXEL_FROM_RGBA pair used by
+ * BlitNtoN and BlitNtoNCopyAlpha produces, so the results are bit-identical
+ * to the C blitters.  Eight pixels are converted per iteration, the rest of
+ * each row goes through the same shift/mask program one pixel at a time.
+ *
+ * BlitNtoNSIMD reads the shifts from the pixel formats and handles any pair
+ * of 16 and 32 bit formats.  The common RGB565 and 8888 layouts get their
+ * own blitters with the shifts known at compile time, see SIMD_FIXED_BLITTER.
+ */
+typedef struct {
+	Uint32 rshift[4];
+	Uint32 mask[4];
+	Uint32 lshift[4];
+	Uint32 alpha;		/* constant bits or'ed into every pixel */
+} SIMD_ChannelMap;
+
+static void SIMD_MapChannel(SIMD_ChannelMap *map, int i,
+                            Uint32 smask, Uint8 sshift, Uint8 sloss,
+                            Uint8 dshift, Uint8 dloss)
+{
+	/* ((((p & smask) >> sshift) << sloss) >> dloss) << dshift */
+	if ( sloss >= dloss ) {
+		map->rshift[i] = sshift;
+		map->mask[i] = smask >> sshift;
+		map->lshift[i] = dshift + (sloss - dloss);
+	} else {
+		map->rshift[i] = sshift + (dloss - sloss);
+		map->mask[i] = (smask >> sshift) >> (dloss - sloss);
+		map->lshift[i] = dshift;
+	}
+}
+
+static void SIMD_SetupChannelMap(SIMD_ChannelMap *map,
+                                 SDL_PixelFormat *srcfmt,
+                                 SDL_PixelFormat *dstfmt)
+{
+	SIMD_MapChannel(map, 0, srcfmt->Rmask, srcfmt->Rshift, srcfmt->Rloss,
+	                dstfmt->Rshift, dstfmt->Rloss);
+	SIMD_MapChannel(map, 1, srcfmt->Gmask, srcfmt->Gshift, srcfmt->Gloss,
+	                dstfmt->Gshift, dstfmt->Gloss);
+	SIMD_MapChannel(map, 2, srcfmt->Bmask, srcfmt->Bshift, srcfmt->Bloss,
+	                dstfmt->Bshift, dstfmt->Bloss);
+	if ( srcfmt->Amask && dstfmt->Amask ) {
+		/* COPY_ALPHA */
+		SIMD_MapChannel(map, 3, srcfmt->Amask, srcfmt->Ashift,
+		                srcfmt->Aloss, dstfmt->Ashift, dstfmt->Aloss);
+		map->alpha = 0;
+	} else {
+		/* SET_ALPHA or NO_ALPHA */
+		map->rshift[3] = map->mask[3] = map->lshift[3] = 0;
+		map->alpha = dstfmt->Amask ?
+		    ((Uint32)(srcfmt->alpha >> dstfmt->Aloss) << dstfmt->Ashift) : 0;
+	}
+}
+
+#define SIMD_MAP_PIXEL(map, p) \
+	((map)->alpha | \
+	 ((((p) >> (map)->rshift[0]) & (map)->mask[0]) << (map)->lshift[0]) | \
+	 ((((p) >> (map)->rshift[1]) & (map)->mask[1]) << (map)->lshift[1]) | \
+	 ((((p) >> (map)->rshift[2]) & (map)->mask[2]) << (map)->lshift[2]) | \
+	 ((((p) >> (map)->rshift[3]) & (map)->mask[3]) << (map)->lshift[3]))
+
+/* Convert the last pixels of a row with the scalar shift/mask program */
+static __inline__ void SIMD_BlitTail(const SIMD_ChannelMap *map,
+                                     const Uint8 *src, int srcbpp,
+                                     Uint8 *dst, int dstbpp, int width)
+{
+	while ( width-- ) {
+		Uint32 Pixel;
+		if ( srcbpp == 2 ) {
+			Pixel = *((const Uint16 *)src);
+		} else {
+			Pixel = *((const Uint32 *)src);
+		}
+		Pixel = SIMD_MAP_PIXEL(map, Pixel);
+		if ( dstbpp == 2 ) {
+			*((Uint16 *)dst) = (Uint16)Pixel;
+		} else {
+			*((Uint32 *)dst) = Pixel;
+		}
+		src += srcbpp;
+		dst += dstbpp;
+	}
+}
+
+#if SDL_SSE2_BLITTERS
+
+typedef __m128i SIMD_Vector;
+
+#define SIMD_SET1(x)	_mm_set1_epi32((int)(x))
+#define SIMD_AND(a, b)	_mm_and_si128(a, b)
+#define SIMD_OR(a, b)	_mm_or_si128(a, b)
+/* Shift left by a constant n, or right by -n */
+#define SIMD_SHIFT(p, n) \
+	(((n) > 0) ? _mm_slli_epi32(p, ((n) > 0) ? (n) : 0) : \
+	             _mm_srli_epi32(p, ((n) < 0) ? -(n) : 0))
+
+typedef struct {
+	__m128i rshift[4];
+	__m128i mask[4];
+	__m128i lshift[4];
+	__m128i alpha;
+} SIMD_ChannelRegs;
+
+static __inline__ void SIMD_LoadChannelRegs(SIMD_ChannelRegs *regs,
+                                            const SIMD_ChannelMap *map)
+{
+	int i;
+	for ( i = 0; i < 4; ++i ) {
+		regs->rshift[i] = _mm_cvtsi32_si128(map->rshift[i]);
+		regs->mask[i] = _mm_set1_epi32(map->mask[i]);
+		regs->lshift[i] = _mm_cvtsi32_si128(map->lshift[i]);
+	}
+	regs->alpha = _mm_set1_epi32(map->alpha);
+}
+
+#define SIMD_CHANNEL(regs, p, i) \
+	_mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, (regs)->rshift[i]), \
+	                            (regs)->mask[i]), (regs)->lshift[i])
+
+/* Load eight pixels, widened to 32 bits */
+static __inline__ void SIMD_Load8(const Uint8 *src, int srcbpp,
+                                  __m128i *lo, __m128i *hi)
+{
+	if ( srcbpp == 2 ) {
+		__m128i zero = _mm_setzero_si128();
+		__m128i v = _mm_loadu_si128((const __m128i *)src);
+		*lo = _mm_unpacklo_epi16(v, zero);
+		*hi = _mm_unpackhi_epi16(v, zero);
+	} else {
+		*lo = _mm_loadu_si128((const __m128i *)src);
+		*hi = _mm_loadu_si128((const __m128i *)(src + 16));
+	}
+}
+
+/* Store eight 32-bit lanes, narrowed to the destination pixel size */
+static __inline__ void SIMD_Store8(Uint8 *dst, int dstbpp,
+                                   __m128i lo, __m128i hi)
+{
+	if ( dstbpp == 2 ) {
+		/* SSE2 only has a signed pack, so sign extend the low words */
+		lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+		hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+		_mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(lo, hi));
+	} else {
+		_mm_storeu_si128((__m128i *)dst, lo);
+		_mm_storeu_si128((__m128i *)(dst + 16), hi);
+	}
+}
+
+#elif SDL_NEON_BLITTERS
+
+typedef uint32x4_t SIMD_Vector;
+
+#define SIMD_SET1(x)	vdupq_n_u32(x)
+#define SIMD_AND(a, b)	vandq_u32(a, b)
+#define SIMD_OR(a, b)	vorrq_u32(a, b)
+/* Shift left by a constant n, or right by -n */
+#define SIMD_SHIFT(p, n)	vshlq_u32(p, vdupq_n_s32(n))
+
+typedef struct {
+	int32x4_t rshift[4];	/* negative, vshlq shifts right */
+	uint32x4_t mask[4];
+	int32x4_t lshift[4];
+	uint32x4_t alpha;
+} SIMD_ChannelRegs;
+
+static __inline__ void SIMD_LoadChannelRegs(SIMD_ChannelRegs *regs,
+                                            const SIMD_ChannelMap *map)
+{
+	int i;
+	for ( i = 0; i < 4; ++i ) {
+		regs->rshift[i] = vdupq_n_s32(-(int)map->rshift[i]);
+		regs->mask[i] = vdupq_n_u32(map->mask[i]);
+		regs->lshift[i] = vdupq_n_s32((int)map->lshift[i]);
+	}
+	regs->alpha = vdupq_n_u32(map->alpha);
+}
+
+#define SIMD_CHANNEL(regs, p, i) \
+	vshlq_u32(vandq_u32(vshlq_u32(p, (regs)->rshift[i]), (regs)->mask[i]), \
+	          (regs)->lshift[i])
+
+/* Load eight pixels, widened to 32 bits */
+static __inline__ void SIMD_Load8(const Uint8 *src, int srcbpp,
+                                  uint32x4_t *lo, uint32x4_t *hi)
+{
+	if ( srcbpp == 2 ) {
+		uint16x8_t v = vld1q_u16((const uint16_t *)src);
+		*lo = vmovl_u16(vget_low_u16(v));
+		*hi = vmovl_u16(vget_high_u16(v));
+	} else {
+		*lo = vld1q_u32((const uint32_t *)src);
+		*hi = vld1q_u32((const uint32_t *)(src + 16));
+	}
+}
+
+/* Store eight 32-bit lanes, narrowed to the destination pixel size */
+static __inline__ void SIMD_Store8(Uint8 *dst, int dstbpp,
+                                   uint32x4_t lo, uint32x4_t hi)
+{
+	if ( dstbpp == 2 ) {
+		vst1q_u16((uint16_t *)dst,
+		          vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)));
+	} else {
+		vst1q_u32((uint32_t *)dst, lo);
+		vst1q_u32((uint32_t *)(dst + 16), hi);
+	}
+}
+
+#endif /* SDL_SSE2_BLITTERS */
+
+static __inline__ SIMD_Vector SIMD_MapPixels(const SIMD_ChannelRegs *regs,
+                                             SIMD_Vector p)
+{
+	SIMD_Vector rg = SIMD_OR(SIMD_CHANNEL(regs, p, 0),
+	                         SIMD_CHANNEL(regs, p, 1));
+	SIMD_Vector ba = SIMD_OR(SIMD_CHANNEL(regs, p, 2),
+	                         SIMD_CHANNEL(regs, p, 3));
+	return SIMD_OR(SIMD_OR(rg, ba), regs->alpha);
+}
+
+static __inline__ void SIMD_BlitRow(const SIMD_ChannelRegs *regs,
+                                    const SIMD_ChannelMap *map,
+                                    const Uint8 *src, int srcbpp,
+                                    Uint8 *dst, int dstbpp, int width)
+{
+	/* Local copy, so the stores to dst can't force the registers to reload */
+	SIMD_ChannelRegs r = *regs;
+	SIMD_Vector lo, hi;
+
+	for ( ; width >= 8; width -= 8 ) {
+		SIMD_Load8(src, srcbpp, &lo, &hi);
+		SIMD_Store8(dst, dstbpp,
+		            SIMD_MapPixels(&r, lo), SIMD_MapPixels(&r, hi));
+		src += 8 * srcbpp;
+		dst += 8 * dstbpp;
+	}
+	SIMD_BlitTail(map, src, srcbpp, dst, dstbpp, width);
+}
+
+/* Same as BlitNtoN / BlitNtoNCopyAlpha for 16 and 32 bit surfaces */
+static void BlitNtoNSIMD(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip;
+	int srcbpp = info->src->BytesPerPixel;
+	int dstbpp = info->dst->BytesPerPixel;
+	int srcpitch = width * srcbpp + srcskip;
+	int dstpitch = width * dstbpp + dstskip;
+	SIMD_ChannelMap map;
+	SIMD_ChannelRegs regs;
+
+	SIMD_SetupChannelMap(&map, info->src, info->dst);
+	SIMD_LoadChannelRegs(&regs, &map);
+
+	/* Expand the row loop per pixel size so the loads and stores inline */
+	while ( height-- ) {
+		if ( srcbpp == 2 ) {
+			if ( dstbpp == 2 ) {
+				SIMD_BlitRow(&regs, &map, src, 2, dst, 2, width);
+			} else {
+				SIMD_BlitRow(&regs, &map, src, 2, dst, 4, width);
+			}
+		} else {
+			if ( dstbpp == 2 ) {
+				SIMD_BlitRow(&regs, &map, src, 4, dst, 2, width);
+			} else {
+				SIMD_BlitRow(&regs, &map, src, 4, dst, 4, width);
+			}
+		}
+		src += srcpitch;
+		dst += dstpitch;
+	}
+}
+
+/*
+ * Channel layouts for the fixed blitters, as shift,bits pairs for R,G,B,A.
+ * The layouts only describe the masks, so ARGB8888 also covers RGB888.
+ */
+#define SIMD_LAYOUT_RGB565	11,5, 5,6, 0,5, 0,0
+#define SIMD_LAYOUT_ARGB8888	16,8, 8,8, 0,8, 24,8
+#define SIMD_LAYOUT_ABGR8888	0,8, 8,8, 16,8, 24,8
+#define SIMD_LAYOUT_RGBA8888	24,8, 16,8, 8,8, 0,8
+#define SIMD_LAYOUT_BGRA8888	8,8, 16,8, 24,8, 0,8
+
+/* The destination bits a channel lands in, and how far it has to move */
+#define SIMD_FIXED_BITS(sb, db)		((sb) < (db) ? (sb) : (db))
+#define SIMD_FIXED_MASK(sb, ds, db) \
+	((Uint32)((1 << SIMD_FIXED_BITS(sb, db)) - 1) << \
+	 (((ds) + (db) - SIMD_FIXED_BITS(sb, db)) & 31))	/* 32 if no bits */
+#define SIMD_FIXED_SHIFT(ss, sb, ds, db)	((ds) + (db) - (ss) - (sb))
+#define SIMD_FIXED_CHANNEL(p, ss, sb, ds, db, mask) \
+	SIMD_AND(SIMD_SHIFT(p, SIMD_FIXED_SHIFT(ss, sb, ds, db)), mask)
+
+/*
+ * Blitter between two fixed layouts.  Copying alpha only uses the fixed
+ * shifts when both alpha masks are the ones in the layouts, other alpha
+ * masks are rare enough to be left to BlitNtoNSIMD.
+ */
+#define SIMD_FIXED_BLITTER(name, sbpp, dbpp, srclayout, dstlayout) \
+	SIMD_FIXED_BLITTER_(name, sbpp, dbpp, srclayout, dstlayout)
+#define SIMD_FIXED_BLITTER_(name, sbpp, dbpp, \
+                            srs, srb, sgs, sgb, sbs, sbb, sas, sab, \
+                            drs, drb, dgs, dgb, dbs, dbb, das, dab) \
+static void name(SDL_BlitInfo *info) \
+{ \
+	int width = info->d_width; \
+	int height = info->d_height; \
+	Uint8 *src = info->s_pixels; \
+	Uint8 *dst = info->d_pixels; \
+	int srcpitch = width * sbpp + info->s_skip; \
+	int dstpitch = width * dbpp + info->d_skip; \
+	SIMD_ChannelMap map; \
+	SIMD_Vector rmask, gmask, bmask, amask, alpha; \
+	SIMD_SetupChannelMap(&map, info->src, info->dst); \
+	if ( map.mask[3] ) { \
+		if ( info->src->Amask != SIMD_FIXED_MASK(sab, sas, sab) || \
+		     info->dst->Amask != SIMD_FIXED_MASK(dab, das, dab) ) { \
+			BlitNtoNSIMD(info); \
+			return; \
+		} \
+		amask = SIMD_SET1(SIMD_FIXED_MASK(sab, das, dab)); \
+	} else { \
+		amask = SIMD_SET1(0); \
+	} \
+	rmask = SIMD_SET1(SIMD_FIXED_MASK(srb, drs, drb)); \
+	gmask = SIMD_SET1(SIMD_FIXED_MASK(sgb, dgs, dgb)); \
+	bmask = SIMD_SET1(SIMD_FIXED_MASK(sbb, dbs, dbb)); \
+	alpha = SIMD_SET1(map.alpha); \
+	while ( height-- ) { \
+		const Uint8 *s = src; \
+		Uint8 *d = dst; \
+		int n; \
+		for ( n = width; n >= 8; n -= 8 ) { \
+			SIMD_Vector p[2]; \
+			int i; \
+			SIMD_Load8(s, sbpp, &p[0], &p[1]); \
+			for ( i = 0; i < 2; ++i ) { \
+				p[i] = SIMD_OR(SIMD_OR( \
+				    SIMD_FIXED_CHANNEL(p[i], srs, srb, drs, drb, rmask), \
+				    SIMD_FIXED_CHANNEL(p[i], sgs, sgb, dgs, dgb, gmask)), \
+				    SIMD_OR(SIMD_OR( \
+				    SIMD_FIXED_CHANNEL(p[i], sbs, sbb, dbs, dbb, bmask), \
+				    SIMD_FIXED_CHANNEL(p[i], sas, sab, das, dab, amask)), \
+				    alpha)); \
+			} \
+			SIMD_Store8(d, dbpp, p[0], p[1]); \
+			s += 8 * sbpp; \
+			d += 8 * dbpp; \
+		} \
+		SIMD_BlitTail(&map, s, sbpp, d, dbpp, n); \
+		src += srcpitch; \
+		dst += dstpitch; \
+	} \
+}
+
+SIMD_FIXED_BLITTER(Blit_ARGB8888_RGB565SIMD, 4, 2,
+                   SIMD_LAYOUT_ARGB8888, SIMD_LAYOUT_RGB565)
+SIMD_FIXED_BLITTER(Blit_ABGR8888_RGB565SIMD, 4, 2,
+                   SIMD_LAYOUT_ABGR8888, SIMD_LAYOUT_RGB565)
+SIMD_FIXED_BLITTER(Blit_RGBA8888_RGB565SIMD, 4, 2,
+                   SIMD_LAYOUT_RGBA8888, SIMD_LAYOUT_RGB565)
+SIMD_FIXED_BLITTER(Blit_BGRA8888_RGB565SIMD, 4, 2,
+                   SIMD_LAYOUT_BGRA8888, SIMD_LAYOUT_RGB565)
+SIMD_FIXED_BLITTER(Blit_RGB565_ARGB8888SIMD, 2, 4,
+                   SIMD_LAYOUT_RGB565, SIMD_LAYOUT_ARGB8888)
+SIMD_FIXED_BLITTER(Blit_RGB565_ABGR8888SIMD, 2, 4,
+                   SIMD_LAYOUT_RGB565, SIMD_LAYOUT_ABGR8888)
+SIMD_FIXED_BLITTER(Blit_RGB565_RGBA8888SIMD, 2, 4,
+                   SIMD_LAYOUT_RGB565, SIMD_LAYOUT_RGBA8888)
+SIMD_FIXED_BLITTER(Blit_RGB565_BGRA8888SIMD, 2, 4,
+                   SIMD_LAYOUT_RGB565, SIMD_LAYOUT_BGRA8888)
+SIMD_FIXED_BLITTER(Blit_ARGB8888_ARGB8888SIMD, 4, 4,
+                   SIMD_LAYOUT_ARGB8888, SIMD_LAYOUT_ARGB8888)
+SIMD_FIXED_BLITTER(Blit_ABGR8888_ABGR8888SIMD, 4, 4,
+                   SIMD_LAYOUT_ABGR8888, SIMD_LAYOUT_ABGR8888)
+SIMD_FIXED_BLITTER(Blit_RGBA8888_RGBA8888SIMD, 4, 4,
+                   SIMD_LAYOUT_RGBA8888, SIMD_LAYOUT_RGBA8888)
+SIMD_FIXED_BLITTER(Blit_BGRA8888_BGRA8888SIMD, 4, 4,
+                   SIMD_LAYOUT_BGRA8888, SIMD_LAYOUT_BGRA8888)
+SIMD_FIXED_BLITTER(Blit_ARGB8888_ABGR8888SIMD, 4, 4,
+                   SIMD_LAYOUT_ARGB8888, SIMD_LAYOUT_ABGR8888)
+SIMD_FIXED_BLITTER(Blit_ARGB8888_RGBA8888SIMD, 4, 4,
+                   SIMD_LAYOUT_ARGB8888, SIMD_LAYOUT_RGBA8888)
+SIMD_FIXED_BLITTER(Blit_ARGB8888_BGRA8888SIMD, 4, 4,
+                   SIMD_LAYOUT_ARGB8888, SIMD_LAYOUT_BGRA8888)
+SIMD_FIXED_BLITTER(Blit_ABGR8888_ARGB8888SIMD, 4, 4,
+                   SIMD_LAYOUT_ABGR8888, SIMD_LAYOUT_ARGB8888)
+SIMD_FIXED_BLITTER(Blit_ABGR8888_RGBA8888SIMD, 4, 4,
+                   SIMD_LAYOUT_ABGR8888, SIMD_LAYOUT_RGBA8888)
+SIMD_FIXED_BLITTER(Blit_ABGR8888_BGRA8888SIMD, 4, 4,
+                   SIMD_LAYOUT_ABGR8888, SIMD_LAYOUT_BGRA8888)
+SIMD_FIXED_BLITTER(Blit_RGBA8888_ARGB8888SIMD, 4, 4,
+                   SIMD_LAYOUT_RGBA8888, SIMD_LAYOUT_ARGB8888)
+SIMD_FIXED_BLITTER(Blit_RGBA8888_ABGR8888SIMD, 4, 4,
+                   SIMD_LAYOUT_RGBA8888, SIMD_LAYOUT_ABGR8888)
+SIMD_FIXED_BLITTER(Blit_BGRA8888_ARGB8888SIMD, 4, 4,
+                   SIMD_LAYOUT_BGRA8888, SIMD_LAYOUT_ARGB8888)
+SIMD_FIXED_BLITTER(Blit_BGRA8888_ABGR8888SIMD, 4, 4,
+                   SIMD_LAYOUT_BGRA8888, SIMD_LAYOUT_ABGR8888)
+
+/* All the SIMD blitters share one feature bit */
+#if SDL_SSE2_BLITTERS
+#define SIMD_BLIT_FEATURE	8	/* has-sse2 */
+#else
+#define SIMD_BLIT_FEATURE	16	/* has-neon */
+#endif
+
+#endif /* SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS */
+
 /* Normal N to N optimized blitters */
 struct blit_table {
 	Uint32 srcR, srcG, srcB;
@@ -2284,6 +2706,27 @@ static const struct blit_table normal_blit_1[] = {
 	{ 0,0,0, 0, 0,0,0, 0, NULL, NULL },
 };
 static const struct blit_table normal_blit_2[] = {
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+    /* has-sse2 or has-neon */
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      SIMD_BLIT_FEATURE, NULL, Blit_RGB565_ARGB8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      SIMD_BLIT_FEATURE, NULL, Blit_RGB565_ABGR8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0xFF000000,0x00FF0000,0x0000FF00,
+      SIMD_BLIT_FEATURE, NULL, Blit_RGB565_RGBA8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x0000F800,0x000007E0,0x0000001F, 4, 0x0000FF00,0x00FF0000,0xFF000000,
+      SIMD_BLIT_FEATURE, NULL, Blit_RGB565_BGRA8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x00000000,0x00000000,0x00000000, 2, 0x00000000,0x00000000,0x00000000,
+      SIMD_BLIT_FEATURE, NULL, BlitNtoNSIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x00000000,0x00000000,0x00000000, 4, 0x00000000,0x00000000,0x00000000,
+      SIMD_BLIT_FEATURE, NULL, BlitNtoNSIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+#endif
 #if SDL_HERMES_BLITTERS
     { 0x0000F800,0x000007E0,0x0000001F, 2, 0x0000001F,0x000007E0,0x0000F800,
       0, ConvertX86p16_16BGR565, ConvertX86, NO_ALPHA },
@@ -2315,6 +2758,69 @@ static const struct blit_table normal_blit_3[] = {
     { 0,0,0, 0, 0,0,0, 0, NULL, BlitNtoN, 0 }
 };
 static const struct blit_table normal_blit_4[] = {
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+    /* has-sse2 or has-neon */
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
+      SIMD_BLIT_FEATURE, NULL, Blit_ARGB8888_RGB565SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 2, 0x0000F800,0x000007E0,0x0000001F,
+      SIMD_BLIT_FEATURE, NULL, Blit_ABGR8888_RGB565SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0xFF000000,0x00FF0000,0x0000FF00, 2, 0x0000F800,0x000007E0,0x0000001F,
+      SIMD_BLIT_FEATURE, NULL, Blit_RGBA8888_RGB565SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x0000FF00,0x00FF0000,0xFF000000, 2, 0x0000F800,0x000007E0,0x0000001F,
+      SIMD_BLIT_FEATURE, NULL, Blit_BGRA8888_RGB565SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      SIMD_BLIT_FEATURE, NULL, Blit_ARGB8888_ARGB8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      SIMD_BLIT_FEATURE, NULL, Blit_ABGR8888_ABGR8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0xFF000000,0x00FF0000,0x0000FF00, 4, 0xFF000000,0x00FF0000,0x0000FF00,
+      SIMD_BLIT_FEATURE, NULL, Blit_RGBA8888_RGBA8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x0000FF00,0x00FF0000,0xFF000000, 4, 0x0000FF00,0x00FF0000,0xFF000000,
+      SIMD_BLIT_FEATURE, NULL, Blit_BGRA8888_BGRA8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      SIMD_BLIT_FEATURE, NULL, Blit_ARGB8888_ABGR8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0xFF000000,0x00FF0000,0x0000FF00,
+      SIMD_BLIT_FEATURE, NULL, Blit_ARGB8888_RGBA8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x0000FF00,0x00FF0000,0xFF000000,
+      SIMD_BLIT_FEATURE, NULL, Blit_ARGB8888_BGRA8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      SIMD_BLIT_FEATURE, NULL, Blit_ABGR8888_ARGB8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0xFF000000,0x00FF0000,0x0000FF00,
+      SIMD_BLIT_FEATURE, NULL, Blit_ABGR8888_RGBA8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x0000FF00,0x00FF0000,0xFF000000,
+      SIMD_BLIT_FEATURE, NULL, Blit_ABGR8888_BGRA8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0xFF000000,0x00FF0000,0x0000FF00, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      SIMD_BLIT_FEATURE, NULL, Blit_RGBA8888_ARGB8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0xFF000000,0x00FF0000,0x0000FF00, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      SIMD_BLIT_FEATURE, NULL, Blit_RGBA8888_ABGR8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x0000FF00,0x00FF0000,0xFF000000, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      SIMD_BLIT_FEATURE, NULL, Blit_BGRA8888_ARGB8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x0000FF00,0x00FF0000,0xFF000000, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      SIMD_BLIT_FEATURE, NULL, Blit_BGRA8888_ABGR8888SIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x00000000,0x00000000,0x00000000, 2, 0x00000000,0x00000000,0x00000000,
+      SIMD_BLIT_FEATURE, NULL, BlitNtoNSIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+    { 0x00000000,0x00000000,0x00000000, 4, 0x00000000,0x00000000,0x00000000,
+      SIMD_BLIT_FEATURE, NULL, BlitNtoNSIMD,
+      NO_ALPHA | COPY_ALPHA | SET_ALPHA },
+#endif
 #if SDL_HERMES_BLITTERS
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
       1, ConvertMMXpII32_16RGB565, ConvertMMX, NO_ALPHA },
@@ -50,6 +50,7 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 	SDL_bool was_error;
 	long fp_offset;
 	int bmpPitch;
+	const Uint8 *packed;
 	int i, pad;
 	SDL_Surface *surface;
 	Uint32 Rmask;
@@ -263,6 +264,15 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 					(4-(surface->pitch%4)) : 0);
 			break;
 	}
+	/* Expand 1 and 4 bit pixels from the source in place if it's in memory */
+	packed = NULL;
+	if ( ExpandBMP ) {
+		packed = SDL_RWBorrow(src, fp_offset+bfOffBits,
+		                      surface->h*(bmpPitch+pad));
+		if ( packed ) {
+			SDL_RWseek(src, surface->h*(bmpPitch+pad), RW_SEEK_CUR);
+		}
+	}
 	if ( topDown ) {
 		bits = top;
 	} else {
@@ -276,7 +286,9 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 			int   shift = (8-ExpandBMP);
 			for ( i=0; i<surface->w; ++i ) {
 				if ( i%(8/ExpandBMP) == 0 ) {
-					if ( !SDL_RWread(src, &pixel, 1, 1) ) {
+					if ( packed ) {
+						pixel = *packed++;
+					} else if ( !SDL_RWread(src, &pixel, 1, 1) ) {
 						SDL_SetError(
 					"Error reading from BMP");
 						was_error = SDL_TRUE;
@@ -318,7 +330,9 @@ SDL_Surface * SDL_LoadBMP_RW (SDL_RWops *src, int freesrc)
 			break;
 		}
 		/* Skip padding bytes, ugh */
-		if ( pad ) {
+		if ( packed ) {
+			packed += pad;
+		} else if ( pad ) {
 			Uint8 padbyte;
 			for ( i=0; i<pad; ++i ) {
 				SDL_RWread(src, &padbyte, 1, 1);
@@ -24,6 +24,7 @@
 /* General (mostly internal) pixel/color manipulation routines for SDL */
 
 #include "SDL_endian.h"
+#include "SDL_mutex.h"
 #include "SDL_video.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
@@ -310,7 +311,7 @@ Uint16 SDL_CalculatePitch(SDL_Surface *surface)
 /*
  * Match an RGB value to a particular palette index
  */
-Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
+static Uint8 SDL_FindColorSlow(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
 {
 	/* Do colorspace distance matching */
 	unsigned int smallest;
@@ -336,6 +337,227 @@ Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
 	return(pixel);
 }
 
+/*
+ * Inverse colormaps for the most recently matched palettes.
+ * RGB space is split into 16x16x16 cells, and the first time a color in a
+ * cell is looked up, the cell gets the list of palette entries that could
+ * possibly be closest to any color inside it: those whose distance to the
+ * cell is no greater than the smallest distance within which some entry
+ * covers the whole cell.  That's usually only a handful of entries, which
+ * are then searched in palette order exactly like SDL_FindColorSlow().
+ * A map is found by comparing the palette contents with the copy it was
+ * built from, so it never returns stale results, even for palettes
+ * changed behind SDL_SetPalette()'s back.  A few maps are kept, so that
+ * converting between palettes in turn doesn't rebuild them every time.
+ */
+#define INVMAP_MINCOLORS	32	/* Smaller palettes are searched directly */
+#define INVMAP_CELLBITS		4
+#define INVMAP_CELLS		(1<<(3*INVMAP_CELLBITS))
+#define INVMAP_CELLSIZE		(256>>INVMAP_CELLBITS)
+#define INVMAP_POOLSIZE		(INVMAP_CELLS*8)
+#define INVMAP_UNKNOWN		0	/* Cell list not built yet */
+#define INVMAP_SEARCH		0xFF	/* Too many candidates, search them all */
+#define INVMAP_CACHED		4	/* Maps kept at once */
+
+typedef struct {
+	int ncolors;
+	SDL_Color colors[256];
+	Uint8 count[INVMAP_CELLS];	/* Candidates, or one of the above */
+	Uint16 first[INVMAP_CELLS];	/* First candidate in the pool */
+	int poolused;
+	Uint8 pool[INVMAP_POOLSIZE];
+} SDL_InverseMap;
+
+/* Most recently used first, and only used with the lock held */
+static SDL_InverseMap *SDL_invmaps[INVMAP_CACHED];
+static SDL_mutex *SDL_invmap_lock = NULL;
+
+int SDL_InitColorMatching(void)
+{
+	if ( SDL_invmap_lock == NULL ) {
+		SDL_invmap_lock = SDL_CreateMutex();
+		if ( SDL_invmap_lock == NULL ) {
+			return(-1);
+		}
+	}
+	return(0);
+}
+
+void SDL_QuitColorMatching(void)
+{
+	int i;
+
+	for ( i=0; i<INVMAP_CACHED; ++i ) {
+		if ( SDL_invmaps[i] ) {
+			SDL_free(SDL_invmaps[i]);
+			SDL_invmaps[i] = NULL;
+		}
+	}
+	if ( SDL_invmap_lock ) {
+		SDL_DestroyMutex(SDL_invmap_lock);
+		SDL_invmap_lock = NULL;
+	}
+}
+
+/* Squared distance from c to the nearest and farthest points of a cell */
+static void SDL_CellDistance(int c, int lo, unsigned int *mind,
+                             unsigned int *maxd)
+{
+	int hi = lo+INVMAP_CELLSIZE-1;
+	int d;
+
+	if ( c < lo ) {
+		d = lo-c;
+		*mind += d*d;
+		d = hi-c;
+	} else if ( c > hi ) {
+		d = c-hi;
+		*mind += d*d;
+		d = c-lo;
+	} else {
+		d = ((c-lo) > (hi-c)) ? (c-lo) : (hi-c);
+	}
+	*maxd += d*d;
+}
+
+static void SDL_BuildInverseCell(SDL_InverseMap *map, int cell)
+{
+	int r0, g0, b0, i, n;
+	unsigned int mind[256], maxd, limit;
+	SDL_Color *c;
+
+	r0 = (cell>>(2*INVMAP_CELLBITS)) << (8-INVMAP_CELLBITS);
+	g0 = ((cell>>INVMAP_CELLBITS)&((1<<INVMAP_CELLBITS)-1)) << (8-INVMAP_CELLBITS);
+	b0 = (cell&((1<<INVMAP_CELLBITS)-1)) << (8-INVMAP_CELLBITS);
+
+	limit = ~0;
+	for ( i=0; i<map->ncolors; ++i ) {
+		c = &map->colors[i];
+		mind[i] = 0;
+		maxd = 0;
+		SDL_CellDistance(c->r, r0, &mind[i], &maxd);
+		SDL_CellDistance(c->g, g0, &mind[i], &maxd);
+		SDL_CellDistance(c->b, b0, &mind[i], &maxd);
+		if ( maxd < limit ) {
+			limit = maxd;
+		}
+	}
+
+	n = 0;
+	for ( i=0; i<map->ncolors; ++i ) {
+		if ( mind[i] <= limit ) {
+			++n;
+		}
+	}
+	if ( (n >= INVMAP_SEARCH) ||
+	     (map->poolused+n > INVMAP_POOLSIZE) ) {
+		map->count[cell] = INVMAP_SEARCH;
+		return;
+	}
+	map->first[cell] = map->poolused;
+	map->count[cell] = n;
+	for ( i=0; i<map->ncolors; ++i ) {
+		if ( mind[i] <= limit ) {
+			map->pool[map->poolused++] = i;
+		}
+	}
+}
+
+/* Find the map for a palette, building it over the oldest one if need be */
+static SDL_InverseMap *SDL_GetInverseMap(SDL_Palette *pal)
+{
+	SDL_InverseMap *map = NULL;
+	int i;
+
+	for ( i=0; i<INVMAP_CACHED; ++i ) {
+		map = SDL_invmaps[i];
+		if ( (map == NULL) ||
+		     ((map->ncolors == pal->ncolors) &&
+		      (SDL_memcmp(pal->colors, map->colors,
+		                  pal->ncolors*sizeof(SDL_Color)) == 0)) ) {
+			break;
+		}
+	}
+	if ( (i == INVMAP_CACHED) || (map == NULL) ) {
+		if ( i == INVMAP_CACHED ) {
+			i = INVMAP_CACHED-1;
+			map = SDL_invmaps[i];
+		} else {
+			map = (SDL_InverseMap *)SDL_malloc(sizeof(*map));
+			if ( map == NULL ) {
+				return(NULL);
+			}
+		}
+		map->ncolors = pal->ncolors;
+		SDL_memcpy(map->colors, pal->colors,
+		           pal->ncolors*sizeof(SDL_Color));
+		SDL_memset(map->count, INVMAP_UNKNOWN, sizeof(map->count));
+		map->poolused = 0;
+	}
+
+	/* Move it to the front */
+	SDL_memmove(&SDL_invmaps[1], &SDL_invmaps[0], i*sizeof(SDL_invmaps[0]));
+	SDL_invmaps[0] = map;
+	return(map);
+}
+
+Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
+{
+	unsigned int smallest;
+	unsigned int distance;
+	int rd, gd, bd;
+	int cell, i, n;
+	Uint8 *candidate;
+	Uint8 pixel=0;
+	SDL_InverseMap *map;
+
+	if ( (pal->ncolors < INVMAP_MINCOLORS) || (pal->ncolors > 256) ) {
+		return SDL_FindColorSlow(pal, r, g, b);
+	}
+
+	/* The maps are only kept while the video subsystem is up */
+	if ( (SDL_invmap_lock == NULL) || (SDL_mutexP(SDL_invmap_lock) < 0) ) {
+		return SDL_FindColorSlow(pal, r, g, b);
+	}
+	map = SDL_GetInverseMap(pal);
+	if ( map == NULL ) {
+		SDL_mutexV(SDL_invmap_lock);
+		return SDL_FindColorSlow(pal, r, g, b);
+	}
+
+	cell = ((r>>(8-INVMAP_CELLBITS))<<(2*INVMAP_CELLBITS)) |
+	       ((g>>(8-INVMAP_CELLBITS))<<INVMAP_CELLBITS) |
+	        (b>>(8-INVMAP_CELLBITS));
+	if ( map->count[cell] == INVMAP_UNKNOWN ) {
+		SDL_BuildInverseCell(map, cell);
+	}
+	if ( map->count[cell] == INVMAP_SEARCH ) {
+		SDL_mutexV(SDL_invmap_lock);
+		return SDL_FindColorSlow(pal, r, g, b);
+	}
+
+	/* The candidates are in palette order, so ties go to the lowest index */
+	candidate = &map->pool[map->first[cell]];
+	n = map->count[cell];
+	smallest = ~0;
+	for ( i=0; i<n; ++i ) {
+		rd = map->colors[candidate[i]].r - r;
+		gd = map->colors[candidate[i]].g - g;
+		bd = map->colors[candidate[i]].b - b;
+		distance = (rd*rd)+(gd*gd)+(bd*bd);
+		if ( distance < smallest ) {
+			pixel = candidate[i];
+			if ( distance == 0 ) { /* Perfect match! */
+				break;
+			}
+			smallest = distance;
+		}
+	}
+
+	SDL_mutexV(SDL_invmap_lock);
+	return(pixel);
+}
+
 /* Find the opaque pixel value corresponding to an RGB triple */
 Uint32 SDL_MapRGB
 (const SDL_PixelFormat * const format,
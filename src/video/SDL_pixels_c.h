@@ -43,4 +43,8 @@ extern void SDL_FreeBlitMap(SDL_BlitMap *map);
 extern Uint16 SDL_CalculatePitch(SDL_Surface *surface);
 extern void SDL_DitherColors(SDL_Color *colors, int bpp);
 extern Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b);
+
+/* Set up and free the inverse colormaps used by SDL_FindColor() */
+extern int SDL_InitColorMatching(void);
+extern void SDL_QuitColorMatching(void);
 extern void SDL_ApplyGamma(Uint16 *gamma, SDL_Color *colors, SDL_Color *output, int ncolors);
@@ -29,6 +29,8 @@
 
 #include "SDL_video.h"
 #include "SDL_blit.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_stretch_c.h"
 
 /* This isn't ready for general consumption yet - it should be folded
    into the general blitting mechanism.
@@ -194,112 +196,601 @@ void copy_row3(Uint8 *src, int src_w, Uint8 *dst, int dst_w)
 	}
 }
 
-/* Perform a stretch blit between two surfaces of the same format.
-   NOTE:  This function is not safe to call from multiple threads!
+/*
+ * Bilinear stretching of 16 and 32 bpp surfaces.
+ *
+ * Source positions are stepped in 16.16 fixed point, sampling at pixel
+ * centres and clamping to the edges of the source rectangle.  Each source
+ * row that is needed is first scaled horizontally into a row buffer, and
+ * the destination rows are then blended from two of those buffers, so an
+ * upscale only scales every source row once.  Both passes compute every
+ * channel as (a * (256 - w) + b * w) >> 8 with an 8-bit weight w; the
+ * vector versions evaluate the same expression and match the C code bit
+ * for bit.
+ *
+ * Nothing here keeps any state between calls, so unlike the generated
+ * copy_row code it is safe to use from several threads at once.
+ */
+typedef struct {
+	int width;		/* destination width in pixels */
+	int *x0;		/* left source column of each destination pixel */
+	int *x1;		/* right source column of each destination pixel */
+	Uint16 *xw;		/* weight of the right column, 0-255 */
+	int nmasks;		/* 16 bpp channels */
+	Uint32 masks[4];
+	int shifts[4];
+	SDL_bool simd16;	/* 16 bpp channels fit the vector code */
+} SDL_StretchInfo;
+
+typedef void (*SDL_StretchRow)(const Uint8 *src, Uint8 *dst,
+                               const SDL_StretchInfo *info, int i);
+typedef void (*SDL_StretchBlend)(const Uint8 *row0, const Uint8 *row1,
+                                 Uint8 *dst, int w,
+                                 const SDL_StretchInfo *info, int i);
+
+/* Find the two source pixels around a position and the weight of the second.
+   The position is offset by half a pixel, so it can't go negative.
 */
-int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
-                    SDL_Surface *dst, SDL_Rect *dstrect)
+static __inline__ int StretchCoord(Uint32 pos, int len, int *c0, int *c1)
 {
-	int src_locked;
-	int dst_locked;
-	int pos, inc;
-	int dst_width;
-	int dst_maxrow;
-	int src_row, dst_row;
-	Uint8 *srcp = NULL;
-	Uint8 *dstp;
-	SDL_Rect full_src;
-	SDL_Rect full_dst;
-#ifdef USE_ASM_STRETCH
-	SDL_bool use_asm = SDL_TRUE;
-#ifdef __GNUC__
-	int u1, u2;
+	if ( pos < 0x8000 ) {
+		*c0 = *c1 = 0;
+		return(0);
+	}
+	pos -= 0x8000;
+	if ( (int)(pos >> 16) >= (len - 1) ) {
+		*c0 = *c1 = len - 1;
+		return(0);
+	}
+	*c0 = (int)(pos >> 16);
+	*c1 = *c0 + 1;
+	return((pos >> 8) & 0xFF);
+}
+
+/* Blend all four bytes of two 32-bit pixels, two channels per multiply */
+static __inline__ Uint32 Lerp32(Uint32 a, Uint32 b, int w)
+{
+	Uint32 rb, ag;
+
+	rb = (a & 0x00FF00FF) * (256 - w) + (b & 0x00FF00FF) * w;
+	ag = ((a >> 8) & 0x00FF00FF) * (256 - w) + ((b >> 8) & 0x00FF00FF) * w;
+	return(((rb >> 8) & 0x00FF00FF) | (ag & 0xFF00FF00));
+}
+
+/* Blend each channel of two 16-bit pixels in place */
+static __inline__ Uint32 Lerp16(Uint32 a, Uint32 b, int w,
+                                const SDL_StretchInfo *info)
+{
+	Uint32 pixel = 0;
+	int i;
+
+	for ( i = 0; i < info->nmasks; ++i ) {
+		const Uint32 m = info->masks[i];
+		pixel |= (((a & m) * (256 - w) + (b & m) * w) >> 8) & m;
+	}
+	return(pixel);
+}
+
+static void ScaleRowLinear32(const Uint8 *srcp, Uint8 *dstp,
+                             const SDL_StretchInfo *info, int i)
+{
+	const Uint32 *src = (const Uint32 *)srcp;
+	Uint32 *dst = (Uint32 *)dstp;
+
+	for ( ; i < info->width; ++i ) {
+		dst[i] = Lerp32(src[info->x0[i]], src[info->x1[i]], info->xw[i]);
+	}
+}
+
+static void BlendRowsLinear32(const Uint8 *row0, const Uint8 *row1, Uint8 *dstp,
+                              int w, const SDL_StretchInfo *info, int i)
+{
+	const Uint32 *a = (const Uint32 *)row0;
+	const Uint32 *b = (const Uint32 *)row1;
+	Uint32 *dst = (Uint32 *)dstp;
+
+	for ( ; i < info->width; ++i ) {
+		dst[i] = Lerp32(a[i], b[i], w);
+	}
+}
+
+static void ScaleRowLinear16(const Uint8 *srcp, Uint8 *dstp,
+                             const SDL_StretchInfo *info, int i)
+{
+	const Uint16 *src = (const Uint16 *)srcp;
+	Uint16 *dst = (Uint16 *)dstp;
+
+	for ( ; i < info->width; ++i ) {
+		dst[i] = (Uint16)Lerp16(src[info->x0[i]], src[info->x1[i]],
+		                        info->xw[i], info);
+	}
+}
+
+static void BlendRowsLinear16(const Uint8 *row0, const Uint8 *row1, Uint8 *dstp,
+                              int w, const SDL_StretchInfo *info, int i)
+{
+	const Uint16 *a = (const Uint16 *)row0;
+	const Uint16 *b = (const Uint16 *)row1;
+	Uint16 *dst = (Uint16 *)dstp;
+
+	for ( ; i < info->width; ++i ) {
+		dst[i] = (Uint16)Lerp16(a[i], b[i], w, info);
+	}
+}
+
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+/*
+ * SSE2 and NEON versions of the row functions above.  They handle as many
+ * pixels as fit in whole vectors and leave the rest to the C code.  The
+ * 16 bpp vector code shifts each channel down to bit 0 first, which needs
+ * the channels to be 8 bits or less so the products fit in 16-bit lanes.
+ * The blend functions are never called with w == 0; those rows are copied.
+ */
+#if SDL_SSE2_BLITTERS
+#define HasSIMD()	SDL_HasSSE2()
+#else
+#define HasSIMD()	SDL_HasNEON()
 #endif
-#endif /* USE_ASM_STRETCH */
-	const int bpp = dst->format->BytesPerPixel;
 
-	if ( src->format->BitsPerPixel != dst->format->BitsPerPixel ) {
-		SDL_SetError("Only works with same format surfaces");
-		return(-1);
+#if SDL_SSE2_BLITTERS
+
+/* the bytes of two source pixels, interleaved for _mm_madd_epi16() */
+#define PAIR_SSE2(src, info, i)						\
+	_mm_unpacklo_epi8(_mm_cvtsi32_si128(src[info->x0[i]]),		\
+	                  _mm_cvtsi32_si128(src[info->x1[i]]))
+
+#define WEIGHTS_SSE2(info, i)						\
+	_mm_set1_epi32(((Uint32)info->xw[i] << 16) | (256 - info->xw[i]))
+
+/* scale two destination pixels into 16-bit channel lanes */
+static __inline__ __m128i ScalePair32SSE2(const Uint32 *src,
+                                          const SDL_StretchInfo *info, int i)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i p = _mm_unpacklo_epi64(PAIR_SSE2(src, info, i),
+	                               PAIR_SSE2(src, info, i+1));
+	__m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(p, zero),
+	                            WEIGHTS_SSE2(info, i));
+	__m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(p, zero),
+	                            WEIGHTS_SSE2(info, i+1));
+	return _mm_packs_epi32(_mm_srli_epi32(lo, 8), _mm_srli_epi32(hi, 8));
+}
+
+/* SSE2 version of ScaleRowLinear32, 4 pixels at a time */
+static void ScaleRowLinear32SIMD(const Uint8 *srcp, Uint8 *dstp,
+                                 const SDL_StretchInfo *info, int i)
+{
+	const Uint32 *src = (const Uint32 *)srcp;
+	Uint32 *dst = (Uint32 *)dstp;
+
+	for ( ; i + 4 <= info->width; i += 4 ) {
+		_mm_storeu_si128((__m128i *)(dst + i),
+		    _mm_packus_epi16(ScalePair32SSE2(src, info, i),
+		                     ScalePair32SSE2(src, info, i+2)));
 	}
+	ScaleRowLinear32(srcp, dstp, info, i);
+}
 
-	/* Verify the blit rectangles */
-	if ( srcrect ) {
-		if ( (srcrect->x < 0) || (srcrect->y < 0) ||
-		     ((srcrect->x+srcrect->w) > src->w) ||
-		     ((srcrect->y+srcrect->h) > src->h) ) {
-			SDL_SetError("Invalid source blit rectangle");
-			return(-1);
+/* SSE2 version of BlendRowsLinear32, 4 pixels at a time */
+static void BlendRowsLinear32SIMD(const Uint8 *row0, const Uint8 *row1,
+                                  Uint8 *dstp, int w,
+                                  const SDL_StretchInfo *info, int i)
+{
+	const Uint32 *a = (const Uint32 *)row0;
+	const Uint32 *b = (const Uint32 *)row1;
+	Uint32 *dst = (Uint32 *)dstp;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i w0 = _mm_set1_epi16(256 - w);
+	const __m128i w1 = _mm_set1_epi16(w);
+
+	for ( ; i + 4 <= info->width; i += 4 ) {
+		__m128i pa = _mm_loadu_si128((const __m128i *)(a + i));
+		__m128i pb = _mm_loadu_si128((const __m128i *)(b + i));
+		__m128i lo = _mm_add_epi16(
+		    _mm_mullo_epi16(_mm_unpacklo_epi8(pa, zero), w0),
+		    _mm_mullo_epi16(_mm_unpacklo_epi8(pb, zero), w1));
+		__m128i hi = _mm_add_epi16(
+		    _mm_mullo_epi16(_mm_unpackhi_epi8(pa, zero), w0),
+		    _mm_mullo_epi16(_mm_unpackhi_epi8(pb, zero), w1));
+		_mm_storeu_si128((__m128i *)(dst + i),
+		    _mm_packus_epi16(_mm_srli_epi16(lo, 8),
+		                     _mm_srli_epi16(hi, 8)));
+	}
+	BlendRowsLinear32(row0, row1, dstp, w, info, i);
+}
+
+#define SETUP16_SSE2(info, mask, shift)					\
+do {									\
+	int c;								\
+	for ( c = 0; c < info->nmasks; ++c ) {				\
+		mask[c] = _mm_set1_epi16((short)info->masks[c]);	\
+		shift[c] = _mm_cvtsi32_si128(info->shifts[c]);		\
+	}								\
+} while(0)
+
+/* blend each channel of 8 16-bit pixels with per-pixel weights */
+static __inline__ __m128i Lerp16SSE2(__m128i pa, __m128i pb,
+                                     __m128i w0, __m128i w1,
+                                     const __m128i *mask,
+                                     const __m128i *shift, int nmasks)
+{
+	__m128i pixel = _mm_setzero_si128();
+	int c;
+
+	for ( c = 0; c < nmasks; ++c ) {
+		__m128i ca = _mm_srl_epi16(_mm_and_si128(pa, mask[c]), shift[c]);
+		__m128i cb = _mm_srl_epi16(_mm_and_si128(pb, mask[c]), shift[c]);
+		__m128i v = _mm_srli_epi16(_mm_add_epi16(
+		    _mm_mullo_epi16(ca, w0), _mm_mullo_epi16(cb, w1)), 8);
+		pixel = _mm_or_si128(pixel, _mm_sll_epi16(v, shift[c]));
+	}
+	return pixel;
+}
+
+/* SSE2 version of ScaleRowLinear16, 8 pixels at a time */
+static void ScaleRowLinear16SIMD(const Uint8 *srcp, Uint8 *dstp,
+                                 const SDL_StretchInfo *info, int i)
+{
+	const Uint16 *src = (const Uint16 *)srcp;
+	Uint16 *dst = (Uint16 *)dstp;
+	const __m128i c256 = _mm_set1_epi16(256);
+	__m128i mask[4], shift[4];
+
+	SETUP16_SSE2(info, mask, shift);
+	for ( ; i + 8 <= info->width; i += 8 ) {
+		__m128i pa = _mm_setzero_si128();
+		__m128i pb = _mm_setzero_si128();
+		__m128i w1 = _mm_loadu_si128((const __m128i *)(info->xw + i));
+		pa = _mm_insert_epi16(pa, src[info->x0[i+0]], 0);
+		pb = _mm_insert_epi16(pb, src[info->x1[i+0]], 0);
+		pa = _mm_insert_epi16(pa, src[info->x0[i+1]], 1);
+		pb = _mm_insert_epi16(pb, src[info->x1[i+1]], 1);
+		pa = _mm_insert_epi16(pa, src[info->x0[i+2]], 2);
+		pb = _mm_insert_epi16(pb, src[info->x1[i+2]], 2);
+		pa = _mm_insert_epi16(pa, src[info->x0[i+3]], 3);
+		pb = _mm_insert_epi16(pb, src[info->x1[i+3]], 3);
+		pa = _mm_insert_epi16(pa, src[info->x0[i+4]], 4);
+		pb = _mm_insert_epi16(pb, src[info->x1[i+4]], 4);
+		pa = _mm_insert_epi16(pa, src[info->x0[i+5]], 5);
+		pb = _mm_insert_epi16(pb, src[info->x1[i+5]], 5);
+		pa = _mm_insert_epi16(pa, src[info->x0[i+6]], 6);
+		pb = _mm_insert_epi16(pb, src[info->x1[i+6]], 6);
+		pa = _mm_insert_epi16(pa, src[info->x0[i+7]], 7);
+		pb = _mm_insert_epi16(pb, src[info->x1[i+7]], 7);
+		_mm_storeu_si128((__m128i *)(dst + i),
+		    Lerp16SSE2(pa, pb, _mm_sub_epi16(c256, w1), w1,
+		               mask, shift, info->nmasks));
+	}
+	ScaleRowLinear16(srcp, dstp, info, i);
+}
+
+/* SSE2 version of BlendRowsLinear16, 8 pixels at a time */
+static void BlendRowsLinear16SIMD(const Uint8 *row0, const Uint8 *row1,
+                                  Uint8 *dstp, int w,
+                                  const SDL_StretchInfo *info, int i)
+{
+	const Uint16 *a = (const Uint16 *)row0;
+	const Uint16 *b = (const Uint16 *)row1;
+	Uint16 *dst = (Uint16 *)dstp;
+	const __m128i w0 = _mm_set1_epi16(256 - w);
+	const __m128i w1 = _mm_set1_epi16(w);
+	__m128i mask[4], shift[4];
+
+	SETUP16_SSE2(info, mask, shift);
+	for ( ; i + 8 <= info->width; i += 8 ) {
+		_mm_storeu_si128((__m128i *)(dst + i), Lerp16SSE2(
+		    _mm_loadu_si128((const __m128i *)(a + i)),
+		    _mm_loadu_si128((const __m128i *)(b + i)),
+		    w0, w1, mask, shift, info->nmasks));
+	}
+	BlendRowsLinear16(row0, row1, dstp, w, info, i);
+}
+
+#elif SDL_NEON_BLITTERS
+
+/* scale one destination pixel into 16-bit channel lanes */
+static __inline__ uint16x4_t ScalePixel32NEON(const Uint32 *src,
+                                              const SDL_StretchInfo *info,
+                                              int i)
+{
+	uint32x2_t p = vset_lane_u32(src[info->x1[i]],
+	                             vdup_n_u32(src[info->x0[i]]), 1);
+	uint16x8_t v = vmovl_u8(vreinterpret_u8_u32(p));
+	return vadd_u16(vmul_n_u16(vget_low_u16(v), 256 - info->xw[i]),
+	                vmul_n_u16(vget_high_u16(v), info->xw[i]));
+}
+
+/* NEON version of ScaleRowLinear32, 2 pixels at a time */
+static void ScaleRowLinear32SIMD(const Uint8 *srcp, Uint8 *dstp,
+                                 const SDL_StretchInfo *info, int i)
+{
+	const Uint32 *src = (const Uint32 *)srcp;
+	Uint32 *dst = (Uint32 *)dstp;
+
+	for ( ; i + 2 <= info->width; i += 2 ) {
+		vst1_u8((uint8_t *)(dst + i), vshrn_n_u16(vcombine_u16(
+		    ScalePixel32NEON(src, info, i),
+		    ScalePixel32NEON(src, info, i+1)), 8));
+	}
+	ScaleRowLinear32(srcp, dstp, info, i);
+}
+
+/* NEON version of BlendRowsLinear32, 4 pixels at a time */
+static void BlendRowsLinear32SIMD(const Uint8 *row0, const Uint8 *row1,
+                                  Uint8 *dstp, int w,
+                                  const SDL_StretchInfo *info, int i)
+{
+	const Uint32 *a = (const Uint32 *)row0;
+	const Uint32 *b = (const Uint32 *)row1;
+	Uint32 *dst = (Uint32 *)dstp;
+	const uint8x8_t w0 = vdup_n_u8(256 - w);
+	const uint8x8_t w1 = vdup_n_u8(w);
+
+	for ( ; i + 4 <= info->width; i += 4 ) {
+		uint8x16_t pa = vld1q_u8((const uint8_t *)(a + i));
+		uint8x16_t pb = vld1q_u8((const uint8_t *)(b + i));
+		uint8x8_t lo = vshrn_n_u16(vmlal_u8(vmull_u8(vget_low_u8(pa), w0),
+		                                    vget_low_u8(pb), w1), 8);
+		uint8x8_t hi = vshrn_n_u16(vmlal_u8(vmull_u8(vget_high_u8(pa), w0),
+		                                    vget_high_u8(pb), w1), 8);
+		vst1q_u8((uint8_t *)(dst + i), vcombine_u8(lo, hi));
+	}
+	BlendRowsLinear32(row0, row1, dstp, w, info, i);
+}
+
+#define SETUP16_NEON(info, mask, down, up)				\
+do {									\
+	int c;								\
+	for ( c = 0; c < info->nmasks; ++c ) {				\
+		mask[c] = vdupq_n_u16((Uint16)info->masks[c]);		\
+		down[c] = vdupq_n_s16(-info->shifts[c]);		\
+		up[c] = vdupq_n_s16(info->shifts[c]);			\
+	}								\
+} while(0)
+
+/* blend each channel of 8 16-bit pixels with per-pixel weights */
+static __inline__ uint16x8_t Lerp16NEON(uint16x8_t pa, uint16x8_t pb,
+                                        uint16x8_t w0, uint16x8_t w1,
+                                        const uint16x8_t *mask,
+                                        const int16x8_t *down,
+                                        const int16x8_t *up, int nmasks)
+{
+	uint16x8_t pixel = vdupq_n_u16(0);
+	int c;
+
+	for ( c = 0; c < nmasks; ++c ) {
+		uint16x8_t ca = vshlq_u16(vandq_u16(pa, mask[c]), down[c]);
+		uint16x8_t cb = vshlq_u16(vandq_u16(pb, mask[c]), down[c]);
+		uint16x8_t v = vshrq_n_u16(vmlaq_u16(vmulq_u16(ca, w0),
+		                                     cb, w1), 8);
+		pixel = vorrq_u16(pixel, vshlq_u16(v, up[c]));
+	}
+	return pixel;
+}
+
+/* NEON version of ScaleRowLinear16, 8 pixels at a time */
+static void ScaleRowLinear16SIMD(const Uint8 *srcp, Uint8 *dstp,
+                                 const SDL_StretchInfo *info, int i)
+{
+	const Uint16 *src = (const Uint16 *)srcp;
+	Uint16 *dst = (Uint16 *)dstp;
+	const uint16x8_t c256 = vdupq_n_u16(256);
+	uint16x8_t mask[4];
+	int16x8_t down[4], up[4];
+	Uint16 a[8], b[8];
+	int n;
+
+	SETUP16_NEON(info, mask, down, up);
+	for ( ; i + 8 <= info->width; i += 8 ) {
+		uint16x8_t w1 = vld1q_u16(info->xw + i);
+		for ( n = 0; n < 8; ++n ) {
+			a[n] = src[info->x0[i+n]];
+			b[n] = src[info->x1[i+n]];
 		}
-	} else {
-		full_src.x = 0;
-		full_src.y = 0;
-		full_src.w = src->w;
-		full_src.h = src->h;
-		srcrect = &full_src;
+		vst1q_u16(dst + i, Lerp16NEON(vld1q_u16(a), vld1q_u16(b),
+		                              vsubq_u16(c256, w1), w1,
+		                              mask, down, up, info->nmasks));
 	}
-	if ( dstrect ) {
-		if ( (dstrect->x < 0) || (dstrect->y < 0) ||
-		     ((dstrect->x+dstrect->w) > dst->w) ||
-		     ((dstrect->y+dstrect->h) > dst->h) ) {
-			SDL_SetError("Invalid destination blit rectangle");
-			return(-1);
+	ScaleRowLinear16(srcp, dstp, info, i);
+}
+
+/* NEON version of BlendRowsLinear16, 8 pixels at a time */
+static void BlendRowsLinear16SIMD(const Uint8 *row0, const Uint8 *row1,
+                                  Uint8 *dstp, int w,
+                                  const SDL_StretchInfo *info, int i)
+{
+	const Uint16 *a = (const Uint16 *)row0;
+	const Uint16 *b = (const Uint16 *)row1;
+	Uint16 *dst = (Uint16 *)dstp;
+	const uint16x8_t w0 = vdupq_n_u16(256 - w);
+	const uint16x8_t w1 = vdupq_n_u16(w);
+	uint16x8_t mask[4];
+	int16x8_t down[4], up[4];
+
+	SETUP16_NEON(info, mask, down, up);
+	for ( ; i + 8 <= info->width; i += 8 ) {
+		vst1q_u16(dst + i, Lerp16NEON(vld1q_u16(a + i), vld1q_u16(b + i),
+		                              w0, w1, mask, down, up,
+		                              info->nmasks));
+	}
+	BlendRowsLinear16(row0, row1, dstp, w, info, i);
+}
+
+#endif /* SDL_SSE2_BLITTERS */
+#endif /* SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS */
+
+/* Set up the 16 bpp channel masks, in the order the vector code uses them */
+static void SetupStretch16(SDL_StretchInfo *info, const SDL_PixelFormat *fmt)
+{
+	const Uint32 masks[4] = { fmt->Rmask, fmt->Gmask, fmt->Bmask, fmt->Amask };
+	const int shifts[4] = { fmt->Rshift, fmt->Gshift, fmt->Bshift, fmt->Ashift };
+	int i;
+
+	info->nmasks = 0;
+	info->simd16 = SDL_TRUE;
+	for ( i = 0; i < 4; ++i ) {
+		if ( masks[i] ) {
+			info->masks[info->nmasks] = masks[i];
+			info->shifts[info->nmasks] = shifts[i];
+			if ( (masks[i] >> shifts[i]) > 0xFF ) {
+				info->simd16 = SDL_FALSE;
+			}
+			++info->nmasks;
 		}
-	} else {
-		full_dst.x = 0;
-		full_dst.y = 0;
-		full_dst.w = dst->w;
-		full_dst.h = dst->h;
-		dstrect = &full_dst;
 	}
+}
 
-	/* Lock the destination if it's in hardware */
-	dst_locked = 0;
-	if ( SDL_MUSTLOCK(dst) ) {
-		if ( SDL_LockSurface(dst) < 0 ) {
-			SDL_SetError("Unable to lock destination surface");
-			return(-1);
+/* Bilinear stretch of some rows of dstrect into a locked surface */
+static int SDL_StretchLinear(SDL_StretchGetRow getrow, void *data,
+                             int src_w, int src_h,
+                             SDL_Surface *dst, SDL_Rect *dstrect,
+                             int first, int count)
+{
+	const int bpp = dst->format->BytesPerPixel;
+	const int width = dstrect->w;
+	const int row_bytes = width * bpp;
+	SDL_StretchInfo info;
+	SDL_StretchRow scale;
+	SDL_StretchBlend blend;
+	Uint8 *buffer;
+	Uint8 *row0, *row1, *tmp;
+	int have0, have1;
+	int x0, x1, y0, y1, w;
+	int i, dst_row;
+	Uint32 pos, inc;
+
+	buffer = (Uint8 *)SDL_malloc(width * (2*sizeof(int) + 2*bpp +
+	                                      sizeof(Uint16)));
+	if ( !buffer ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	info.width = width;
+	info.x0 = (int *)buffer;
+	info.x1 = info.x0 + width;
+	row0 = (Uint8 *)(info.x1 + width);
+	row1 = row0 + row_bytes;
+	info.xw = (Uint16 *)(row1 + row_bytes);
+
+	/* Work out where each destination column comes from */
+	inc = ((Uint32)src_w << 16) / width;
+	pos = inc / 2;
+	for ( i = 0; i < width; ++i ) {
+		info.xw[i] = StretchCoord(pos, src_w, &x0, &x1);
+		info.x0[i] = x0;
+		info.x1[i] = x1;
+		pos += inc;
+	}
+
+	if ( bpp == 4 ) {
+		scale = ScaleRowLinear32;
+		blend = BlendRowsLinear32;
+	} else {
+		SetupStretch16(&info, dst->format);
+		scale = ScaleRowLinear16;
+		blend = BlendRowsLinear16;
+	}
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+	if ( HasSIMD() ) {
+		if ( bpp == 4 ) {
+			scale = ScaleRowLinear32SIMD;
+			blend = BlendRowsLinear32SIMD;
+		} else if ( info.simd16 ) {
+			scale = ScaleRowLinear16SIMD;
+			blend = BlendRowsLinear16SIMD;
 		}
-		dst_locked = 1;
 	}
-	/* Lock the source if it's in hardware */
-	src_locked = 0;
-	if ( SDL_MUSTLOCK(src) ) {
-		if ( SDL_LockSurface(src) < 0 ) {
-			if ( dst_locked ) {
-				SDL_UnlockSurface(dst);
+#endif
+
+	/* Blend each destination row from two horizontally scaled source rows,
+	   keeping the last two around since consecutive rows usually share them.
+	 */
+	have0 = have1 = -1;
+	inc = ((Uint32)src_h << 16) / dstrect->h;
+	pos = inc / 2 + first * inc;
+	for ( dst_row = first; dst_row < first + count; ++dst_row ) {
+		Uint8 *dstp = (Uint8 *)dst->pixels +
+		              (dstrect->y + dst_row) * dst->pitch +
+		              dstrect->x * bpp;
+
+		w = StretchCoord(pos, src_h, &y0, &y1);
+		pos += inc;
+		if ( y0 != have0 ) {
+			if ( y0 == have1 ) {
+				tmp = row0;
+				row0 = row1;
+				row1 = tmp;
+				have1 = have0;
+			} else {
+				scale(getrow(data, y0), row0, &info, 0);
 			}
-			SDL_SetError("Unable to lock source surface");
-			return(-1);
+			have0 = y0;
 		}
-		src_locked = 1;
+		if ( w == 0 ) {
+			SDL_memcpy(dstp, row0, row_bytes);
+			continue;
+		}
+		if ( y1 != have1 ) {
+			scale(getrow(data, y1), row1, &info, 0);
+			have1 = y1;
+		}
+		blend(row0, row1, dstp, w, &info, 0);
 	}
 
-	/* Set up the data... */
-	pos = 0x10000;
-	inc = (srcrect->h << 16) / dstrect->h;
-	src_row = srcrect->y;
-	dst_row = dstrect->y;
+	SDL_free(buffer);
+	return(0);
+}
+
+/* Nearest neighbour stretch of some rows of dstrect into a locked surface */
+static void SDL_StretchNearest(SDL_StretchGetRow getrow, void *data,
+                               int src_w, int src_h,
+                               SDL_Surface *dst, SDL_Rect *dstrect,
+                               int first, int count, SDL_bool use_asm)
+{
+	Uint32 pos, inc;
+	int dst_width;
+	int dst_maxrow;
+	int src_row, dst_row;
+	const Uint8 *srcp;
+	Uint8 *dstp;
+#if defined(USE_ASM_STRETCH) && defined(__GNUC__)
+	int u1, u2;
+#endif
+	const int bpp = dst->format->BytesPerPixel;
+
+	/* Set up the data, starting as if the rows above had been done but
+	   the first row still has to be fetched...
+	 */
+	inc = ((Uint32)src_h << 16) / dstrect->h;
+	pos = 0x10000 + first * inc;
+	src_row = (int)(pos >> 16) - 1;
+	pos -= (Uint32)src_row << 16;
+	dst_row = dstrect->y + first;
 	dst_width = dstrect->w*bpp;
 
 #ifdef USE_ASM_STRETCH
 	/* Write the opcodes for this stretch */
 	if ( (bpp == 3) ||
-	     (generate_rowbytes(srcrect->w, dstrect->w, bpp) < 0) ) {
+	     (generate_rowbytes(src_w, dstrect->w, bpp) < 0) ) {
 		use_asm = SDL_FALSE;
 	}
 #endif
 
 	/* Perform the stretch blit */
-	for ( dst_maxrow = dst_row+dstrect->h; dst_row<dst_maxrow; ++dst_row ) {
+	for ( dst_maxrow = dst_row+count; dst_row<dst_maxrow; ++dst_row ) {
 		dstp = (Uint8 *)dst->pixels + (dst_row*dst->pitch)
 		                            + (dstrect->x*bpp);
+		if ( (pos < 0x10000L) && (dst_row != dstrect->y + first) ) {
+			/* Same source row as last time, just copy it */
+			SDL_memcpy(dstp, dstp - dst->pitch, dst_width);
+			pos += inc;
+			continue;
+		}
 		while ( pos >= 0x10000L ) {
-			srcp = (Uint8 *)src->pixels + (src_row*src->pitch)
-			                            + (srcrect->x*bpp);
 			++src_row;
 			pos -= 0x10000L;
 		}
+		srcp = getrow(data, src_row - 1);
 #ifdef USE_ASM_STRETCH
 		if (use_asm) {
 #ifdef __GNUC__
@@ -329,22 +820,157 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 #endif
 		switch (bpp) {
 		    case 1:
-			copy_row1(srcp, srcrect->w, dstp, dstrect->w);
+			copy_row1((Uint8 *)srcp, src_w, dstp, dstrect->w);
 			break;
 		    case 2:
-			copy_row2((Uint16 *)srcp, srcrect->w,
+			copy_row2((Uint16 *)srcp, src_w,
 			          (Uint16 *)dstp, dstrect->w);
 			break;
 		    case 3:
-			copy_row3(srcp, srcrect->w, dstp, dstrect->w);
+			copy_row3((Uint8 *)srcp, src_w, dstp, dstrect->w);
 			break;
 		    case 4:
-			copy_row4((Uint32 *)srcp, srcrect->w,
+			copy_row4((Uint32 *)srcp, src_w,
 			          (Uint32 *)dstp, dstrect->w);
 			break;
 		}
 		pos += inc;
 	}
+}
+
+int SDL_StretchRows(SDL_StretchGetRow getrow, void *data, int src_w, int src_h,
+                    SDL_Surface *dst, SDL_Rect *dstrect,
+                    int first, int count, SDL_StretchFilter filter)
+{
+	const int bpp = dst->format->BytesPerPixel;
+
+	if ( !src_w || !src_h || !dstrect->w || !dstrect->h || (count <= 0) ) {
+		return(0);
+	}
+	if ( (filter == SDL_STRETCH_BILINEAR) && ((bpp == 2) || (bpp == 4)) ) {
+		return SDL_StretchLinear(getrow, data, src_w, src_h,
+		                         dst, dstrect, first, count);
+	}
+	SDL_StretchNearest(getrow, data, src_w, src_h,
+	                   dst, dstrect, first, count, SDL_FALSE);
+	return(0);
+}
+
+/* Rows of a surface, for SDL_StretchSurface() */
+typedef struct {
+	SDL_Surface *surface;
+	SDL_Rect *rect;
+} SDL_StretchSource;
+
+static const Uint8 *GetSurfaceRow(void *data, int row)
+{
+	SDL_StretchSource *source = (SDL_StretchSource *)data;
+	SDL_Surface *surface = source->surface;
+
+	return (Uint8 *)surface->pixels +
+	       (source->rect->y + row) * surface->pitch +
+	       source->rect->x * surface->format->BytesPerPixel;
+}
+
+/* Perform a stretch blit between two surfaces of the same format.
+   NOTE:  The generated copy_row code is shared, so the ASM stretch is
+          not safe to call from multiple threads!
+*/
+static int SDL_StretchSurface(SDL_Surface *src, SDL_Rect *srcrect,
+                              SDL_Surface *dst, SDL_Rect *dstrect,
+                              SDL_StretchFilter filter, SDL_bool allow_asm)
+{
+	int retval = 0;
+	int src_locked;
+	int dst_locked;
+	SDL_StretchSource source;
+	SDL_Rect full_src;
+	SDL_Rect full_dst;
+	const int bpp = dst->format->BytesPerPixel;
+
+	if ( src->format->BitsPerPixel != dst->format->BitsPerPixel ) {
+		SDL_SetError("Only works with same format surfaces");
+		return(-1);
+	}
+	switch (filter) {
+	    case SDL_STRETCH_NEAREST:
+		break;
+	    case SDL_STRETCH_BILINEAR:
+		if ( (bpp != 2) && (bpp != 4) ) {
+			SDL_SetError("Bilinear stretch only works with 16 and 32 bpp surfaces");
+			return(-1);
+		}
+		break;
+	    default:
+		SDL_SetError("Unknown stretch filter");
+		return(-1);
+	}
+
+	/* Verify the blit rectangles */
+	if ( srcrect ) {
+		if ( (srcrect->x < 0) || (srcrect->y < 0) ||
+		     ((srcrect->x+srcrect->w) > src->w) ||
+		     ((srcrect->y+srcrect->h) > src->h) ) {
+			SDL_SetError("Invalid source blit rectangle");
+			return(-1);
+		}
+	} else {
+		full_src.x = 0;
+		full_src.y = 0;
+		full_src.w = src->w;
+		full_src.h = src->h;
+		srcrect = &full_src;
+	}
+	if ( dstrect ) {
+		if ( (dstrect->x < 0) || (dstrect->y < 0) ||
+		     ((dstrect->x+dstrect->w) > dst->w) ||
+		     ((dstrect->y+dstrect->h) > dst->h) ) {
+			SDL_SetError("Invalid destination blit rectangle");
+			return(-1);
+		}
+	} else {
+		full_dst.x = 0;
+		full_dst.y = 0;
+		full_dst.w = dst->w;
+		full_dst.h = dst->h;
+		dstrect = &full_dst;
+	}
+	if ( !srcrect->w || !srcrect->h || !dstrect->w || !dstrect->h ) {
+		return(0);
+	}
+
+	/* Lock the destination if it's in hardware */
+	dst_locked = 0;
+	if ( SDL_MUSTLOCK(dst) ) {
+		if ( SDL_LockSurface(dst) < 0 ) {
+			SDL_SetError("Unable to lock destination surface");
+			return(-1);
+		}
+		dst_locked = 1;
+	}
+	/* Lock the source if it's in hardware */
+	src_locked = 0;
+	if ( SDL_MUSTLOCK(src) ) {
+		if ( SDL_LockSurface(src) < 0 ) {
+			if ( dst_locked ) {
+				SDL_UnlockSurface(dst);
+			}
+			SDL_SetError("Unable to lock source surface");
+			return(-1);
+		}
+		src_locked = 1;
+	}
+
+	source.surface = src;
+	source.rect = srcrect;
+	if ( filter == SDL_STRETCH_BILINEAR ) {
+		retval = SDL_StretchLinear(GetSurfaceRow, &source,
+		                           srcrect->w, srcrect->h, dst, dstrect,
+		                           0, dstrect->h);
+	} else {
+		SDL_StretchNearest(GetSurfaceRow, &source, srcrect->w, srcrect->h,
+		                   dst, dstrect, 0, dstrect->h, allow_asm);
+	}
 
 	/* We need to unlock the surfaces if they're locked */
 	if ( dst_locked ) {
@@ -353,6 +979,20 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 	if ( src_locked ) {
 		SDL_UnlockSurface(src);
 	}
-	return(0);
+	return(retval);
+}
+
+int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
+                    SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	return SDL_StretchSurface(src, srcrect, dst, dstrect,
+	                          SDL_STRETCH_NEAREST, SDL_TRUE);
+}
+
+int SDL_SoftStretchFiltered(SDL_Surface *src, SDL_Rect *srcrect,
+                            SDL_Surface *dst, SDL_Rect *dstrect,
+                            SDL_StretchFilter filter)
+{
+	return SDL_StretchSurface(src, srcrect, dst, dstrect, filter, SDL_FALSE);
 }
 
@@ -22,8 +22,30 @@
 #include "SDL_config.h"
 
 /* Perform a stretch blit between two surfaces of the same format.
-   NOTE:  This function is not safe to call from multiple threads!
+   NOTE:  This function is only unsafe to call from multiple threads when
+          USE_ASM_STRETCH is defined, since the generated copy_row code is
+          shared.  SDL_SoftStretchFiltered() never uses it.
 */
 extern int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
                            SDL_Surface *dst, SDL_Rect *dstrect);
 
+/* Returns a pointer to the first pixel of the given source row, in the
+   destination pixel format.  The pointer only needs to stay valid until
+   the next call.
+*/
+typedef const Uint8 *(*SDL_StretchGetRow)(void *data, int row);
+
+/* Stretch a src_w x src_h image, fetched a row at a time, into dstrect.
+   Only the count rows of dstrect starting at row first are written, so
+   one stretch can be split into bands.
+   The destination must already be locked and dstrect must be valid.
+   Bilinear filtering falls back to nearest at 8 and 24 bpp, and the
+   source rows are fetched in increasing order.
+   This function is safe to call from multiple threads on separate
+   destination rows.  Returns 0, or -1 if out of memory.
+*/
+extern int SDL_StretchRows(SDL_StretchGetRow getrow, void *data,
+                           int src_w, int src_h,
+                           SDL_Surface *dst, SDL_Rect *dstrect,
+                           int first, int count, SDL_StretchFilter filter);
+
@@ -258,6 +258,14 @@ struct SDL_VideoDevice {
 	/* Handle any queued OS events */
 	void (*PumpEvents)(_THIS);
 
+	/* Optional:  block until OS events are pending or 'timeout' ms pass
+	   (SDL_MUTEX_MAXWAIT for no timeout), leaving them to PumpEvents().
+	   SDL_WaitEvent() uses this instead of polling, and calls WakeEvents()
+	   from whichever thread queues an event meanwhile.
+	 */
+	void (*WaitEvents)(_THIS, Uint32 timeout);
+	void (*WakeEvents)(_THIS);
+
 	/* * * */
 	/* Data common to all drivers */
 	SDL_Surface *screen;
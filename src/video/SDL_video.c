@@ -276,6 +276,12 @@ int SDL_VideoInit (const char *driver_name, Uint32 flags)
 #endif
 	video->info.vfmt = SDL_VideoSurface->format;
 
+	/* Let SDL_FindColor() keep its inverse colormaps */
+	if ( SDL_InitColorMatching() < 0 ) {
+		SDL_VideoQuit();
+		return(-1);
+	}
+
 	/* Start the event loop */
 	if ( SDL_StartEventLoop(flags) < 0 ) {
 		SDL_VideoQuit();
@@ -1388,6 +1394,8 @@ void SDL_VideoQuit (void)
 			video->wm_icon = NULL;
 		}
 
+		SDL_QuitColorMatching();
+
 		/* Finish cleaning up video subsystem */
 		video->free(this);
 		current_video = NULL;
@@ -0,0 +1,626 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* SSE2 and NEON versions of the software YUV overlay colorspace conversion.
+
+   These produce exactly the same pixels as the table driven C functions in
+   SDL_yuv_sw.c.  The tables hold, for each chroma value c, (int)(k * (c-128))
+   for four constants k; the vector code works out the same truncated
+   products as sign(c-128) * floor(k * |c-128|), with k split into an
+   integer part and a 16-bit fraction that was checked to give identical
+   results for every chroma value.  The clamped red, green and blue values
+   are then reduced and shifted into place as described by the rgb_2_pix
+   table, so any 16 or 32 bpp format with 8 bits or less per channel works.
+*/
+
+#include "SDL_video.h"
+#include "SDL_blit.h"
+
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+
+/* The fractional parts of the colortab constants, in 1/65536 */
+#define CR_R_FRAC	26302	/* (0.419/0.299) - 1 */
+#define CR_G_FRAC	46767	/* (0.299/0.419) */
+#define CB_G_FRAC	22571	/* (0.114/0.331) */
+#define CB_B_FRAC	50686	/* (0.587/0.331) - 1 */
+
+/* The row loops are written once for every pixel size and scale, and must
+   be inlined into each entry point to get those as constants.
+ */
+#if defined(__GNUC__)
+#define YUV_INLINE	__inline__ __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define YUV_INLINE	__forceinline
+#else
+#define YUV_INLINE	__inline__
+#endif
+
+/* How each channel is stored in a destination pixel */
+typedef struct {
+	int loss[3];
+	int shift[3];
+	SDL_bool bytes;		/* 32 bpp with a whole byte per channel */
+	int byte[4];		/* channel in each byte, 3 for none */
+} SDL_YUVOutFormat;
+
+/* Recover the destination format from the brightest rgb_2_pix entries */
+static void GetOutFormat(const Uint32 *rgb_2_pix, int bpp,
+                         SDL_YUVOutFormat *fmt)
+{
+	int i;
+
+	for ( i = 0; i < 3; ++i ) {
+		Uint32 v = rgb_2_pix[i*768 + 511];
+		int bits = 0;
+
+		if ( bpp == 2 ) {
+			v &= 0xFFFF;
+		}
+		fmt->shift[i] = 0;
+		while ( v && !(v & 1) ) {
+			v >>= 1;
+			++fmt->shift[i];
+		}
+		while ( v ) {
+			bits += (v & 1);
+			v >>= 1;
+		}
+		fmt->loss[i] = 8 - bits;
+	}
+
+	fmt->bytes = (bpp == 4);
+	for ( i = 0; i < 4; ++i ) {
+		fmt->byte[i] = 3;
+	}
+	for ( i = 0; i < 3; ++i ) {
+		if ( fmt->loss[i] || (fmt->shift[i] % 8) ) {
+			fmt->bytes = SDL_FALSE;
+		} else if ( fmt->shift[i] < 32 ) {
+			fmt->byte[fmt->shift[i] / 8] = i;
+		}
+	}
+}
+
+/* Convert one pair of pixels sharing a chroma sample, using the tables */
+static YUV_INLINE void PutPixelPair(int *colortab, Uint32 *rgb_2_pix,
+                                    int L1, int L2, int cr, int cb,
+                                    Uint8 *out, int pitch, int bpp, int scale)
+{
+	const int cr_r  = 0*768+256 + colortab[ cr + 0*256 ];
+	const int crb_g = 1*768+256 + colortab[ cr + 1*256 ]
+	                            + colortab[ cb + 2*256 ];
+	const int cb_b  = 2*768+256 + colortab[ cb + 3*256 ];
+	Uint32 pixel[2];
+	int i, j;
+
+	pixel[0] = (rgb_2_pix[ L1 + cr_r ] |
+	            rgb_2_pix[ L1 + crb_g ] |
+	            rgb_2_pix[ L1 + cb_b ]);
+	pixel[1] = (rgb_2_pix[ L2 + cr_r ] |
+	            rgb_2_pix[ L2 + crb_g ] |
+	            rgb_2_pix[ L2 + cb_b ]);
+	for ( j = 0; j < scale; ++j ) {
+		for ( i = 0; i < 2*scale; ++i ) {
+			if ( bpp == 2 ) {
+				((Uint16 *)out)[i] = (Uint16)pixel[i / scale];
+			} else {
+				((Uint32 *)out)[i] = pixel[i / scale];
+			}
+		}
+		out += pitch;
+	}
+}
+
+#if SDL_SSE2_BLITTERS
+
+/* sign(x) * floor(|x| * k) for the chroma values c in 16-bit lanes */
+#define TRUNCMUL_SSE2(a, s, frac, whole)				\
+	_mm_sub_epi16(_mm_xor_si128(_mm_add_epi16(			\
+	    _mm_mulhi_epu16(a, _mm_set1_epi16((short)frac)),		\
+	    whole ? a : _mm_setzero_si128()), s), s)
+
+/* Work out the table terms for 8 chroma samples in 16-bit lanes */
+static __inline__ void ChromaSSE2(__m128i cr, __m128i cb, __m128i *rt,
+                                  __m128i *gt, __m128i *bt)
+{
+	const __m128i c128 = _mm_set1_epi16(128);
+	__m128i x, s, a;
+
+	x = _mm_sub_epi16(cr, c128);
+	s = _mm_srai_epi16(x, 15);
+	a = _mm_sub_epi16(_mm_xor_si128(x, s), s);
+	*rt = TRUNCMUL_SSE2(a, s, CR_R_FRAC, 1);
+	*gt = TRUNCMUL_SSE2(a, s, CR_G_FRAC, 0);
+
+	x = _mm_sub_epi16(cb, c128);
+	s = _mm_srai_epi16(x, 15);
+	a = _mm_sub_epi16(_mm_xor_si128(x, s), s);
+	*gt = _mm_add_epi16(*gt, TRUNCMUL_SSE2(a, s, CB_G_FRAC, 0));
+	*bt = TRUNCMUL_SSE2(a, s, CB_B_FRAC, 1);
+}
+
+/* reduce a clamped channel and move it into place within 16-bit lanes */
+#define CHANNEL16_SSE2(v, fmt, i)					\
+	_mm_sll_epi16(_mm_srl_epi16(v, _mm_cvtsi32_si128(fmt->loss[i])),	\
+	              _mm_cvtsi32_si128(fmt->shift[i]))
+
+/* the same within 32-bit lanes, taking 16-bit lanes lo (0-3) or hi (4-7) */
+#define CHANNEL32_SSE2(v, unpack, fmt, i)				\
+	_mm_sll_epi32(unpack(_mm_srl_epi16(v,				\
+	                         _mm_cvtsi32_si128(fmt->loss[i])),	\
+	                     _mm_setzero_si128()),			\
+	              _mm_cvtsi32_si128(fmt->shift[i]))
+
+/* Convert and store 8 pixels from luma and chroma terms in 16-bit lanes */
+static YUV_INLINE void Store8SSE2(Uint8 *out, int pitch, __m128i y,
+                                  __m128i rt, __m128i gt, __m128i bt,
+                                  const SDL_YUVOutFormat *fmt,
+                                  int bpp, int scale)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c255 = _mm_set1_epi16(255);
+	__m128i r, g, b;
+	__m128i p[4];
+	int i, n;
+
+	if ( bpp == 2 ) {
+		r = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(y, rt), zero), c255);
+		g = _mm_min_epi16(_mm_max_epi16(_mm_sub_epi16(y, gt), zero), c255);
+		b = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(y, bt), zero), c255);
+		p[0] = _mm_or_si128(_mm_or_si128(CHANNEL16_SSE2(r, fmt, 0),
+		                                 CHANNEL16_SSE2(g, fmt, 1)),
+		                    CHANNEL16_SSE2(b, fmt, 2));
+		n = 1;
+		if ( scale == 2 ) {
+			p[1] = _mm_unpackhi_epi16(p[0], p[0]);
+			p[0] = _mm_unpacklo_epi16(p[0], p[0]);
+			n = 2;
+		}
+	} else {
+		if ( fmt->bytes ) {
+			/* saturate to bytes and interleave them in place */
+			__m128i c[4], lo, hi;
+			c[0] = _mm_packus_epi16(_mm_add_epi16(y, rt), zero);
+			c[1] = _mm_packus_epi16(_mm_sub_epi16(y, gt), zero);
+			c[2] = _mm_packus_epi16(_mm_add_epi16(y, bt), zero);
+			c[3] = zero;
+			lo = _mm_unpacklo_epi8(c[fmt->byte[0]], c[fmt->byte[1]]);
+			hi = _mm_unpacklo_epi8(c[fmt->byte[2]], c[fmt->byte[3]]);
+			p[0] = _mm_unpacklo_epi16(lo, hi);
+			p[1] = _mm_unpackhi_epi16(lo, hi);
+		} else {
+			r = _mm_min_epi16(_mm_max_epi16(
+			        _mm_add_epi16(y, rt), zero), c255);
+			g = _mm_min_epi16(_mm_max_epi16(
+			        _mm_sub_epi16(y, gt), zero), c255);
+			b = _mm_min_epi16(_mm_max_epi16(
+			        _mm_add_epi16(y, bt), zero), c255);
+			p[0] = _mm_or_si128(_mm_or_si128(
+			    CHANNEL32_SSE2(r, _mm_unpacklo_epi16, fmt, 0),
+			    CHANNEL32_SSE2(g, _mm_unpacklo_epi16, fmt, 1)),
+			    CHANNEL32_SSE2(b, _mm_unpacklo_epi16, fmt, 2));
+			p[1] = _mm_or_si128(_mm_or_si128(
+			    CHANNEL32_SSE2(r, _mm_unpackhi_epi16, fmt, 0),
+			    CHANNEL32_SSE2(g, _mm_unpackhi_epi16, fmt, 1)),
+			    CHANNEL32_SSE2(b, _mm_unpackhi_epi16, fmt, 2));
+		}
+		n = 2;
+		if ( scale == 2 ) {
+			p[3] = _mm_unpackhi_epi32(p[1], p[1]);
+			p[2] = _mm_unpacklo_epi32(p[1], p[1]);
+			p[1] = _mm_unpackhi_epi32(p[0], p[0]);
+			p[0] = _mm_unpacklo_epi32(p[0], p[0]);
+			n = 4;
+		}
+	}
+	for ( i = 0; i < n; ++i ) {
+		_mm_storeu_si128((__m128i *)out + i, p[i]);
+		if ( scale == 2 ) {
+			_mm_storeu_si128((__m128i *)(out + pitch) + i, p[i]);
+		}
+	}
+}
+
+/* YV12 and IYUV, 16 pixels of two rows at a time */
+static YUV_INLINE void ColorYV12SSE2(int *colortab, Uint32 *rgb_2_pix,
+                                     unsigned char *lum, unsigned char *cr,
+                                     unsigned char *cb, unsigned char *out,
+                                     int rows, int cols, int mod,
+                                     int bpp, int scale)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const int pitch = (cols*scale + mod) * bpp;
+	const int step = 8 * scale * bpp;
+	SDL_YUVOutFormat fmt;
+	int x, y;
+
+	GetOutFormat(rgb_2_pix, bpp, &fmt);
+	for ( y = 0; y < rows / 2; ++y ) {
+		Uint8 *lum1 = lum + (2*y) * cols;
+		Uint8 *lum2 = lum1 + cols;
+		Uint8 *crp = cr + y * (cols / 2);
+		Uint8 *cbp = cb + y * (cols / 2);
+		Uint8 *row1 = out + (2*y) * scale * pitch;
+		Uint8 *row2 = row1 + scale * pitch;
+		for ( x = 0; x + 16 <= cols; x += 16 ) {
+			__m128i rt, gt, bt, y1, y2;
+			ChromaSSE2(_mm_unpacklo_epi8(_mm_loadl_epi64(
+			               (const __m128i *)(crp + x/2)), zero),
+			           _mm_unpacklo_epi8(_mm_loadl_epi64(
+			               (const __m128i *)(cbp + x/2)), zero),
+			           &rt, &gt, &bt);
+			y1 = _mm_loadu_si128((const __m128i *)(lum1 + x));
+			y2 = _mm_loadu_si128((const __m128i *)(lum2 + x));
+			Store8SSE2(row1, pitch, _mm_unpacklo_epi8(y1, zero),
+			           _mm_unpacklo_epi16(rt, rt),
+			           _mm_unpacklo_epi16(gt, gt),
+			           _mm_unpacklo_epi16(bt, bt), &fmt, bpp, scale);
+			Store8SSE2(row1 + step, pitch, _mm_unpackhi_epi8(y1, zero),
+			           _mm_unpackhi_epi16(rt, rt),
+			           _mm_unpackhi_epi16(gt, gt),
+			           _mm_unpackhi_epi16(bt, bt), &fmt, bpp, scale);
+			Store8SSE2(row2, pitch, _mm_unpacklo_epi8(y2, zero),
+			           _mm_unpacklo_epi16(rt, rt),
+			           _mm_unpacklo_epi16(gt, gt),
+			           _mm_unpacklo_epi16(bt, bt), &fmt, bpp, scale);
+			Store8SSE2(row2 + step, pitch, _mm_unpackhi_epi8(y2, zero),
+			           _mm_unpackhi_epi16(rt, rt),
+			           _mm_unpackhi_epi16(gt, gt),
+			           _mm_unpackhi_epi16(bt, bt), &fmt, bpp, scale);
+			row1 += 2 * step;
+			row2 += 2 * step;
+		}
+		for ( ; x + 2 <= cols; x += 2 ) {
+			PutPixelPair(colortab, rgb_2_pix, lum1[x], lum1[x+1],
+			             crp[x/2], cbp[x/2], row1, pitch, bpp, scale);
+			PutPixelPair(colortab, rgb_2_pix, lum2[x], lum2[x+1],
+			             crp[x/2], cbp[x/2], row2, pitch, bpp, scale);
+			row1 += 2 * scale * bpp;
+			row2 += 2 * scale * bpp;
+		}
+	}
+}
+
+/* YUY2, UYVY and YVYU, 16 pixels at a time */
+static YUV_INLINE void ColorYUY2SSE2(int *colortab, Uint32 *rgb_2_pix,
+                                     unsigned char *lum, unsigned char *cr,
+                                     unsigned char *cb, unsigned char *out,
+                                     int rows, int cols, int mod,
+                                     int bpp, int scale)
+{
+	const __m128i mask = _mm_set1_epi32(0xFF);
+	const int pitch = (cols*scale + mod) * bpp;
+	const int step = 8 * scale * bpp;
+	SDL_YUVOutFormat fmt;
+	Uint8 *base;
+	__m128i yoff0, yoff1, croff, cboff;
+	int x, y;
+
+	GetOutFormat(rgb_2_pix, bpp, &fmt);
+
+	/* The bytes of each 4 byte macropixel, relative to the first one */
+	base = lum;
+	if ( cr < base ) base = cr;
+	if ( cb < base ) base = cb;
+	yoff0 = _mm_cvtsi32_si128((lum - base) * 8);
+	yoff1 = _mm_cvtsi32_si128((lum - base + 2) * 8);
+	croff = _mm_cvtsi32_si128((cr - base) * 8);
+	cboff = _mm_cvtsi32_si128((cb - base) * 8);
+
+	for ( y = 0; y < rows; ++y ) {
+		Uint8 *src = base + y * cols * 2;
+		Uint8 *row = out + y * scale * pitch;
+		for ( x = 0; x + 16 <= cols; x += 16 ) {
+			__m128i p1 = _mm_loadu_si128((const __m128i *)(src + x*2));
+			__m128i p2 = _mm_loadu_si128((const __m128i *)(src + x*2 + 16));
+			__m128i rt, gt, bt, y1, y2;
+			ChromaSSE2(_mm_packs_epi32(
+			               _mm_and_si128(_mm_srl_epi32(p1, croff), mask),
+			               _mm_and_si128(_mm_srl_epi32(p2, croff), mask)),
+			           _mm_packs_epi32(
+			               _mm_and_si128(_mm_srl_epi32(p1, cboff), mask),
+			               _mm_and_si128(_mm_srl_epi32(p2, cboff), mask)),
+			           &rt, &gt, &bt);
+			y1 = _mm_or_si128(
+			    _mm_and_si128(_mm_srl_epi32(p1, yoff0), mask),
+			    _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(p1, yoff1),
+			                                 mask), 16));
+			y2 = _mm_or_si128(
+			    _mm_and_si128(_mm_srl_epi32(p2, yoff0), mask),
+			    _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(p2, yoff1),
+			                                 mask), 16));
+			Store8SSE2(row, pitch, y1,
+			           _mm_unpacklo_epi16(rt, rt),
+			           _mm_unpacklo_epi16(gt, gt),
+			           _mm_unpacklo_epi16(bt, bt), &fmt, bpp, scale);
+			Store8SSE2(row + step, pitch, y2,
+			           _mm_unpackhi_epi16(rt, rt),
+			           _mm_unpackhi_epi16(gt, gt),
+			           _mm_unpackhi_epi16(bt, bt), &fmt, bpp, scale);
+			row += 2 * step;
+		}
+		for ( ; x + 2 <= cols; x += 2 ) {
+			Uint8 *m = src + x*2;
+			PutPixelPair(colortab, rgb_2_pix,
+			             m[lum - base], m[lum - base + 2],
+			             m[cr - base], m[cb - base],
+			             row, pitch, bpp, scale);
+			row += 2 * scale * bpp;
+		}
+	}
+}
+
+#define ColorYV12SIMD	ColorYV12SSE2
+#define ColorYUY2SIMD	ColorYUY2SSE2
+
+#elif SDL_NEON_BLITTERS
+
+/* sign(x) * floor(|x| * k) for the chroma values c in 16-bit lanes */
+static __inline__ int16x8_t TruncMulNEON(uint16x8_t a, int16x8_t s,
+                                         Uint16 frac, int whole)
+{
+	uint16x8_t p = vcombine_u16(
+	    vshrn_n_u32(vmull_n_u16(vget_low_u16(a), frac), 16),
+	    vshrn_n_u32(vmull_n_u16(vget_high_u16(a), frac), 16));
+	if ( whole ) {
+		p = vaddq_u16(p, a);
+	}
+	return vsubq_s16(veorq_s16(vreinterpretq_s16_u16(p), s), s);
+}
+
+/* Work out the table terms for 8 chroma samples */
+static __inline__ void ChromaNEON(uint8x8_t cr, uint8x8_t cb, int16x8_t *rt,
+                                  int16x8_t *gt, int16x8_t *bt)
+{
+	int16x8_t x, s;
+	uint16x8_t a;
+
+	x = vreinterpretq_s16_u16(vsubl_u8(cr, vdup_n_u8(128)));
+	s = vshrq_n_s16(x, 15);
+	a = vreinterpretq_u16_s16(vabsq_s16(x));
+	*rt = TruncMulNEON(a, s, CR_R_FRAC, 1);
+	*gt = TruncMulNEON(a, s, CR_G_FRAC, 0);
+
+	x = vreinterpretq_s16_u16(vsubl_u8(cb, vdup_n_u8(128)));
+	s = vshrq_n_s16(x, 15);
+	a = vreinterpretq_u16_s16(vabsq_s16(x));
+	*gt = vaddq_s16(*gt, TruncMulNEON(a, s, CB_G_FRAC, 0));
+	*bt = TruncMulNEON(a, s, CB_B_FRAC, 1);
+}
+
+/* Convert and store 8 pixels from luma and chroma terms in 16-bit lanes */
+static YUV_INLINE void Store8NEON(Uint8 *out, int pitch, int16x8_t y,
+                                  int16x8_t rt, int16x8_t gt, int16x8_t bt,
+                                  const SDL_YUVOutFormat *fmt,
+                                  int bpp, int scale)
+{
+	uint8x8_t c8[4];
+	uint16x8_t c[3];
+	int i;
+
+	/* clamp to 0-255 */
+	c8[0] = vqmovun_s16(vaddq_s16(y, rt));
+	c8[1] = vqmovun_s16(vsubq_s16(y, gt));
+	c8[2] = vqmovun_s16(vaddq_s16(y, bt));
+	c8[3] = vdup_n_u8(0);
+	if ( bpp == 4 && fmt->bytes ) {
+		/* store the channel bytes straight into place */
+		uint8x8x4_t p;
+		for ( i = 0; i < 4; ++i ) {
+			p.val[i] = c8[fmt->byte[i]];
+		}
+		if ( scale == 2 ) {
+			uint8x8x4_t q;
+			for ( i = 0; i < 4; ++i ) {
+				uint8x8x2_t d = vzip_u8(p.val[i], p.val[i]);
+				p.val[i] = d.val[0];
+				q.val[i] = d.val[1];
+			}
+			vst4_u8(out, p);
+			vst4_u8(out + 32, q);
+			vst4_u8(out + pitch, p);
+			vst4_u8(out + pitch + 32, q);
+		} else {
+			vst4_u8(out, p);
+		}
+		return;
+	}
+
+	/* reduce to the width of each channel */
+	for ( i = 0; i < 3; ++i ) {
+		c[i] = vshlq_u16(vmovl_u8(c8[i]), vdupq_n_s16(-fmt->loss[i]));
+	}
+	if ( bpp == 2 ) {
+		uint16x8_t p = vdupq_n_u16(0);
+		for ( i = 0; i < 3; ++i ) {
+			p = vorrq_u16(p, vshlq_u16(c[i],
+			                           vdupq_n_s16(fmt->shift[i])));
+		}
+		if ( scale == 2 ) {
+			uint16x8x2_t d = vzipq_u16(p, p);
+			vst1q_u16((uint16_t *)out, d.val[0]);
+			vst1q_u16((uint16_t *)out + 8, d.val[1]);
+			vst1q_u16((uint16_t *)(out + pitch), d.val[0]);
+			vst1q_u16((uint16_t *)(out + pitch) + 8, d.val[1]);
+		} else {
+			vst1q_u16((uint16_t *)out, p);
+		}
+	} else {
+		uint32x4_t lo = vdupq_n_u32(0);
+		uint32x4_t hi = vdupq_n_u32(0);
+		for ( i = 0; i < 3; ++i ) {
+			int32x4_t shift = vdupq_n_s32(fmt->shift[i]);
+			lo = vorrq_u32(lo, vshlq_u32(vmovl_u16(vget_low_u16(c[i])),
+			                             shift));
+			hi = vorrq_u32(hi, vshlq_u32(vmovl_u16(vget_high_u16(c[i])),
+			                             shift));
+		}
+		if ( scale == 2 ) {
+			uint32x4x2_t l = vzipq_u32(lo, lo);
+			uint32x4x2_t h = vzipq_u32(hi, hi);
+			for ( i = 0; i < 2; ++i ) {
+				uint32_t *p = (uint32_t *)(out + i * pitch);
+				vst1q_u32(p, l.val[0]);
+				vst1q_u32(p + 4, l.val[1]);
+				vst1q_u32(p + 8, h.val[0]);
+				vst1q_u32(p + 12, h.val[1]);
+			}
+		} else {
+			vst1q_u32((uint32_t *)out, lo);
+			vst1q_u32((uint32_t *)out + 4, hi);
+		}
+	}
+}
+
+/* YV12 and IYUV, 16 pixels of two rows at a time */
+static YUV_INLINE void ColorYV12NEON(int *colortab, Uint32 *rgb_2_pix,
+                                     unsigned char *lum, unsigned char *cr,
+                                     unsigned char *cb, unsigned char *out,
+                                     int rows, int cols, int mod,
+                                     int bpp, int scale)
+{
+	const int pitch = (cols*scale + mod) * bpp;
+	const int step = 8 * scale * bpp;
+	SDL_YUVOutFormat fmt;
+	int x, y, i;
+
+	GetOutFormat(rgb_2_pix, bpp, &fmt);
+	for ( y = 0; y < rows / 2; ++y ) {
+		Uint8 *lum1 = lum + (2*y) * cols;
+		Uint8 *crp = cr + y * (cols / 2);
+		Uint8 *cbp = cb + y * (cols / 2);
+		Uint8 *row1 = out + (2*y) * scale * pitch;
+		for ( x = 0; x + 16 <= cols; x += 16 ) {
+			int16x8_t rt, gt, bt;
+			int16x8x2_t r, g, b;
+			ChromaNEON(vld1_u8(crp + x/2), vld1_u8(cbp + x/2),
+			           &rt, &gt, &bt);
+			r = vzipq_s16(rt, rt);
+			g = vzipq_s16(gt, gt);
+			b = vzipq_s16(bt, bt);
+			for ( i = 0; i < 2; ++i ) {
+				uint8x16_t l = vld1q_u8(lum1 + i * cols + x);
+				Uint8 *row = row1 + i * scale * pitch;
+				Store8NEON(row, pitch, vreinterpretq_s16_u16(
+				               vmovl_u8(vget_low_u8(l))),
+				           r.val[0], g.val[0], b.val[0],
+				           &fmt, bpp, scale);
+				Store8NEON(row + step, pitch, vreinterpretq_s16_u16(
+				               vmovl_u8(vget_high_u8(l))),
+				           r.val[1], g.val[1], b.val[1],
+				           &fmt, bpp, scale);
+			}
+			row1 += 2 * step;
+		}
+		for ( ; x + 2 <= cols; x += 2 ) {
+			for ( i = 0; i < 2; ++i ) {
+				Uint8 *l = lum1 + i * cols;
+				PutPixelPair(colortab, rgb_2_pix, l[x], l[x+1],
+				             crp[x/2], cbp[x/2],
+				             row1 + i * scale * pitch,
+				             pitch, bpp, scale);
+			}
+			row1 += 2 * scale * bpp;
+		}
+	}
+}
+
+/* YUY2, UYVY and YVYU, 16 pixels at a time */
+static YUV_INLINE void ColorYUY2NEON(int *colortab, Uint32 *rgb_2_pix,
+                                     unsigned char *lum, unsigned char *cr,
+                                     unsigned char *cb, unsigned char *out,
+                                     int rows, int cols, int mod,
+                                     int bpp, int scale)
+{
+	const int pitch = (cols*scale + mod) * bpp;
+	const int step = 8 * scale * bpp;
+	SDL_YUVOutFormat fmt;
+	Uint8 *base;
+	int yoff, croff, cboff;
+	int x, y;
+
+	GetOutFormat(rgb_2_pix, bpp, &fmt);
+
+	/* The bytes of each 4 byte macropixel, relative to the first one */
+	base = lum;
+	if ( cr < base ) base = cr;
+	if ( cb < base ) base = cb;
+	yoff = lum - base;
+	croff = cr - base;
+	cboff = cb - base;
+
+	for ( y = 0; y < rows; ++y ) {
+		Uint8 *src = base + y * cols * 2;
+		Uint8 *row = out + y * scale * pitch;
+		for ( x = 0; x + 16 <= cols; x += 16 ) {
+			uint8x8x4_t p = vld4_u8(src + x*2);
+			uint8x8x2_t l = vzip_u8(p.val[yoff], p.val[yoff+2]);
+			int16x8_t rt, gt, bt;
+			int16x8x2_t r, g, b;
+			ChromaNEON(p.val[croff], p.val[cboff], &rt, &gt, &bt);
+			r = vzipq_s16(rt, rt);
+			g = vzipq_s16(gt, gt);
+			b = vzipq_s16(bt, bt);
+			Store8NEON(row, pitch,
+			           vreinterpretq_s16_u16(vmovl_u8(l.val[0])),
+			           r.val[0], g.val[0], b.val[0], &fmt, bpp, scale);
+			Store8NEON(row + step, pitch,
+			           vreinterpretq_s16_u16(vmovl_u8(l.val[1])),
+			           r.val[1], g.val[1], b.val[1], &fmt, bpp, scale);
+			row += 2 * step;
+		}
+		for ( ; x + 2 <= cols; x += 2 ) {
+			Uint8 *m = src + x*2;
+			PutPixelPair(colortab, rgb_2_pix,
+			             m[yoff], m[yoff + 2], m[croff], m[cboff],
+			             row, pitch, bpp, scale);
+			row += 2 * scale * bpp;
+		}
+	}
+}
+
+#define ColorYV12SIMD	ColorYV12NEON
+#define ColorYUY2SIMD	ColorYUY2NEON
+
+#endif /* SDL_SSE2_BLITTERS */
+
+/* The entry points, with the same interface as the C functions */
+#define DEFINE_YUV_SIMD(name, worker, bpp, scale)			\
+void name( int *colortab, Uint32 *rgb_2_pix,				\
+           unsigned char *lum, unsigned char *cr,			\
+           unsigned char *cb, unsigned char *out,			\
+           int rows, int cols, int mod )				\
+{									\
+	worker(colortab, rgb_2_pix, lum, cr, cb, out,			\
+	       rows, cols, mod, bpp, scale);				\
+}
+DEFINE_YUV_SIMD(Color16YV12SIMD1X, ColorYV12SIMD, 2, 1)
+DEFINE_YUV_SIMD(Color16YV12SIMD2X, ColorYV12SIMD, 2, 2)
+DEFINE_YUV_SIMD(Color32YV12SIMD1X, ColorYV12SIMD, 4, 1)
+DEFINE_YUV_SIMD(Color32YV12SIMD2X, ColorYV12SIMD, 4, 2)
+DEFINE_YUV_SIMD(Color16YUY2SIMD1X, ColorYUY2SIMD, 2, 1)
+DEFINE_YUV_SIMD(Color16YUY2SIMD2X, ColorYUY2SIMD, 2, 2)
+DEFINE_YUV_SIMD(Color32YUY2SIMD1X, ColorYUY2SIMD, 4, 1)
+DEFINE_YUV_SIMD(Color32YUY2SIMD2X, ColorYUY2SIMD, 4, 2)
+
+#endif /* SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS */
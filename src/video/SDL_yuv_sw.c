@@ -85,6 +85,8 @@
 
 #include "SDL_video.h"
 #include "SDL_cpuinfo.h"
+#include "SDL_thread.h"
+#include "SDL_blit.h"
 #include "SDL_stretch_c.h"
 #include "SDL_yuvfuncs.h"
 #include "SDL_yuv_sw_c.h"
@@ -97,10 +99,40 @@ static struct private_yuvhwfuncs sw_yuvfuncs = {
 	SDL_FreeYUV_SW
 };
 
+/* The most threads SDL_VIDEO_YUV_THREADS can ask for */
+#define SDL_YUV_MAXTHREADS	8
+
+/* One horizontal band of the display, converted by one thread */
+typedef struct SDL_YUVBand {
+	struct private_yuvhwdata *swdata;
+	SDL_Thread *thread;
+	SDL_sem *start;
+	Uint8 *rowbuf;
+	int first;
+	int count;
+	int retval;
+} SDL_YUVBand;
+
 /* RGB conversion lookup tables */
 struct private_yuvhwdata {
-	SDL_Surface *stretch;
+	Uint8 *rowbuf;
+	SDL_StretchFilter filter;
 	SDL_Surface *display;
+
+	/* The bands, the first of which is done by the displaying thread */
+	int nbands;
+	SDL_YUVBand *bands;
+	SDL_sem *done;
+	int quit;
+
+	/* The frame being displayed, as seen by the band threads */
+	SDL_Overlay *overlay;
+	SDL_Rect *src;
+	SDL_Rect *dst;
+	Uint8 *lum, *Cr, *Cb;
+	int stretch;
+	int scale_2x;
+
 	Uint8 *pixels;
 	int *colortab;
 	Uint32 *rgb_2_pix;
@@ -132,6 +164,23 @@ extern void ColorRGBDitherYV12MMX1X( int *colortab, Uint32 *rgb_2_pix,
                                      int rows, int cols, int mod );
 #endif 
 
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+/* Vectorised versions of the functions below, from SDL_yuv_simd.c */
+#define DECLARE_YUV_SIMD(name)						\
+extern void name( int *colortab, Uint32 *rgb_2_pix,			\
+                  unsigned char *lum, unsigned char *cr,		\
+                  unsigned char *cb, unsigned char *out,		\
+                  int rows, int cols, int mod );
+DECLARE_YUV_SIMD(Color16YV12SIMD1X)
+DECLARE_YUV_SIMD(Color16YV12SIMD2X)
+DECLARE_YUV_SIMD(Color32YV12SIMD1X)
+DECLARE_YUV_SIMD(Color32YV12SIMD2X)
+DECLARE_YUV_SIMD(Color16YUY2SIMD1X)
+DECLARE_YUV_SIMD(Color16YUY2SIMD2X)
+DECLARE_YUV_SIMD(Color32YUY2SIMD1X)
+DECLARE_YUV_SIMD(Color32YUY2SIMD2X)
+#endif
+
 static void Color16DitherYV12Mod1X( int *colortab, Uint32 *rgb_2_pix,
                                     unsigned char *lum, unsigned char *cr,
                                     unsigned char *cb, unsigned char *out,
@@ -791,7 +840,7 @@ static void Color16DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
             row++;
 
         }
-        row += next_row;
+        row += next_row + mod/2;
     }
 }
 
@@ -847,7 +896,7 @@ static void Color24DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
             row += 2*3;
 
         }
-        row += next_row;
+        row += next_row + mod*3;
     }
 }
 
@@ -863,7 +912,6 @@ static void Color32DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
     int crb_g;
     int cb_b;
     int cols_2 = cols / 2;
-    mod+=mod;
     y = rows;
     while( y-- )
     {
@@ -895,7 +943,7 @@ static void Color32DitherYUY2Mod2X( int *colortab, Uint32 *rgb_2_pix,
 
         }
 
-        row += next_row;
+        row += next_row + mod;
     }
 }
 
@@ -923,6 +971,183 @@ static int free_bits_at_bottom( Uint32 a )
 }
 
 
+/* Source rows of an overlay, converted on demand for SDL_StretchRows() */
+typedef struct {
+	struct private_yuvhwdata *swdata;
+	Uint8 *rowbuf;
+	int bpp;
+	int pair;
+} SDL_YUVRowSource;
+
+static const Uint8 *GetOverlayRow(void *data, int row)
+{
+	SDL_YUVRowSource *source = (SDL_YUVRowSource *)data;
+	struct private_yuvhwdata *swdata = source->swdata;
+	SDL_Overlay *overlay = swdata->overlay;
+	const int row_bytes = overlay->w * source->bpp;
+	const int x = swdata->src->x * source->bpp;
+	int y;
+
+	row += swdata->src->y;
+	switch (overlay->format) {
+	    case SDL_YV12_OVERLAY:
+	    case SDL_IYUV_OVERLAY:
+		/* Rows are converted in pairs since they share chroma */
+		y = (row & ~1);
+		if ( y != source->pair ) {
+			swdata->Display1X(swdata->colortab, swdata->rgb_2_pix,
+			                  swdata->lum + y * overlay->pitches[0],
+			                  swdata->Cr + (y/2) * overlay->pitches[1],
+			                  swdata->Cb + (y/2) * overlay->pitches[1],
+			                  source->rowbuf, 2, overlay->w, 0);
+			source->pair = y;
+		}
+		return source->rowbuf + (row - y) * row_bytes + x;
+	    default:
+		y = row * overlay->pitches[0];
+		swdata->Display1X(swdata->colortab, swdata->rgb_2_pix,
+		                  swdata->lum + y, swdata->Cr + y, swdata->Cb + y,
+		                  source->rowbuf, 1, overlay->w, 0);
+		return source->rowbuf + x;
+	}
+}
+
+/* Convert one band of the frame described in swdata */
+static int DisplayYUVBand(SDL_YUVBand *band)
+{
+	struct private_yuvhwdata *swdata = band->swdata;
+	SDL_Overlay *overlay = swdata->overlay;
+	SDL_Surface *display = swdata->display;
+	const int bpp = display->format->BytesPerPixel;
+	SDL_YUVRowSource source;
+	Uint8 *lum, *Cr, *Cb;
+	Uint8 *dstp;
+	int mod;
+
+	if ( band->count <= 0 ) {
+		return(0);
+	}
+	if ( swdata->stretch ) {
+		/* Convert and scale in one pass, straight into the display */
+		source.swdata = swdata;
+		source.rowbuf = band->rowbuf;
+		source.bpp = bpp;
+		source.pair = -1;
+		return SDL_StretchRows(GetOverlayRow, &source,
+		                       swdata->src->w, swdata->src->h,
+		                       display, swdata->dst,
+		                       band->first, band->count, swdata->filter);
+	}
+
+	/* Bands of planar formats start on an even row, sharing no chroma */
+	lum = swdata->lum + band->first * overlay->pitches[0];
+	if ( overlay->planes == 3 ) {
+		Cr = swdata->Cr + (band->first/2) * overlay->pitches[1];
+		Cb = swdata->Cb + (band->first/2) * overlay->pitches[1];
+	} else {
+		Cr = swdata->Cr + band->first * overlay->pitches[0];
+		Cb = swdata->Cb + band->first * overlay->pitches[0];
+	}
+	dstp = (Uint8 *)display->pixels
+		+ swdata->dst->x * bpp
+		+ swdata->dst->y * display->pitch;
+	mod = (display->pitch / bpp);
+
+	if ( swdata->scale_2x ) {
+		dstp += 2 * band->first * display->pitch;
+		mod -= (overlay->w * 2);
+		swdata->Display2X(swdata->colortab, swdata->rgb_2_pix,
+		                  lum, Cr, Cb, dstp, band->count, overlay->w, mod);
+	} else {
+		dstp += band->first * display->pitch;
+		mod -= overlay->w;
+		swdata->Display1X(swdata->colortab, swdata->rgb_2_pix,
+		                  lum, Cr, Cb, dstp, band->count, overlay->w, mod);
+	}
+	return(0);
+}
+
+static int SDLCALL RunYUVBand(void *data)
+{
+	SDL_YUVBand *band = (SDL_YUVBand *)data;
+	struct private_yuvhwdata *swdata = band->swdata;
+
+	for ( ; ; ) {
+		SDL_SemWait(band->start);
+		if ( swdata->quit ) {
+			break;
+		}
+		band->retval = DisplayYUVBand(band);
+		SDL_SemPost(swdata->done);
+	}
+	return(0);
+}
+
+/* Set up the bands, with a thread for each band after the first.
+   If threads can't be created, fewer bands are used.
+ */
+static int SDL_CreateYUVBands(struct private_yuvhwdata *swdata, int nbands)
+{
+	SDL_YUVBand *band;
+	int i;
+
+	swdata->bands = (SDL_YUVBand *)SDL_malloc(nbands * sizeof(SDL_YUVBand));
+	if ( ! swdata->bands ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	SDL_memset(swdata->bands, 0, nbands * sizeof(SDL_YUVBand));
+	swdata->bands[0].swdata = swdata;
+	swdata->nbands = 1;
+	if ( nbands > 1 ) {
+		swdata->done = SDL_CreateSemaphore(0);
+		if ( ! swdata->done ) {
+			return(0);
+		}
+	}
+	for ( i = 1; i < nbands; ++i ) {
+		band = &swdata->bands[i];
+		band->swdata = swdata;
+		band->start = SDL_CreateSemaphore(0);
+		if ( ! band->start ) {
+			break;
+		}
+#if (defined(__WIN32__) && !defined(_WIN32_WCE)) && !defined(HAVE_LIBC) && !defined(__SYMBIAN32__)
+#undef SDL_CreateThread
+		band->thread = SDL_CreateThread(RunYUVBand, band, NULL, NULL);
+#else
+		band->thread = SDL_CreateThread(RunYUVBand, band);
+#endif
+		if ( ! band->thread ) {
+			SDL_DestroySemaphore(band->start);
+			band->start = NULL;
+			break;
+		}
+		++swdata->nbands;
+	}
+	return(0);
+}
+
+static void SDL_FreeYUVBands(struct private_yuvhwdata *swdata)
+{
+	int i;
+
+	swdata->quit = 1;
+	for ( i = 1; i < swdata->nbands; ++i ) {
+		SDL_SemPost(swdata->bands[i].start);
+	}
+	for ( i = 1; i < swdata->nbands; ++i ) {
+		SDL_WaitThread(swdata->bands[i].thread, NULL);
+		SDL_DestroySemaphore(swdata->bands[i].start);
+	}
+	if ( swdata->done ) {
+		SDL_DestroySemaphore(swdata->done);
+	}
+	if ( swdata->bands ) {
+		SDL_free(swdata->bands);
+	}
+}
+
 SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_Surface *display)
 {
 	SDL_Overlay *overlay;
@@ -937,6 +1162,8 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 	int i;
 	int CR, CB;
 	Uint32 Rmask, Gmask, Bmask;
+	const char *filter;
+	const char *threads;
 
 	/* Only RGB packed pixel conversion supported */
 	if ( (display->format->BytesPerPixel != 2) &&
@@ -983,8 +1210,13 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 		SDL_FreeYUVOverlay(overlay);
 		return(NULL);
 	}
-	swdata->stretch = NULL;
+	swdata->rowbuf = NULL;
+	swdata->filter = SDL_STRETCH_NEAREST;
 	swdata->display = display;
+	swdata->nbands = 0;
+	swdata->bands = NULL;
+	swdata->done = NULL;
+	swdata->quit = 0;
 	swdata->pixels = (Uint8 *) SDL_malloc(width*height*2);
 	swdata->colortab = (int *)SDL_malloc(4*256*sizeof(int));
 	Cr_r_tab = &swdata->colortab[0*256];
@@ -1122,6 +1354,65 @@ SDL_Overlay *SDL_CreateYUV_SW(_THIS, int width, int height, Uint32 format, SDL_S
 		break;
 	}
 
+#if SDL_SSE2_BLITTERS || SDL_NEON_BLITTERS
+	/* The vector code handles even widths at 16 and 32 bpp with up to
+	   8 bits per channel, and gives exactly the same results as the
+	   tables above.
+	 */
+#if SDL_SSE2_BLITTERS
+	if ( SDL_HasSSE2() &&
+#else
+	if ( SDL_HasNEON() &&
+#endif
+	     (display->format->BytesPerPixel != 3) && !(width & 1) &&
+	     (number_of_bits_set(Rmask) <= 8) &&
+	     (number_of_bits_set(Gmask) <= 8) &&
+	     (number_of_bits_set(Bmask) <= 8) ) {
+		switch (format) {
+		    case SDL_YV12_OVERLAY:
+		    case SDL_IYUV_OVERLAY:
+			if ( display->format->BytesPerPixel == 2 ) {
+				swdata->Display1X = Color16YV12SIMD1X;
+				swdata->Display2X = Color16YV12SIMD2X;
+			} else {
+				swdata->Display1X = Color32YV12SIMD1X;
+				swdata->Display2X = Color32YV12SIMD2X;
+			}
+			break;
+		    default:
+			if ( display->format->BytesPerPixel == 2 ) {
+				swdata->Display1X = Color16YUY2SIMD1X;
+				swdata->Display2X = Color16YUY2SIMD2X;
+			} else {
+				swdata->Display1X = Color32YUY2SIMD1X;
+				swdata->Display2X = Color32YUY2SIMD2X;
+			}
+			break;
+		}
+	}
+#endif
+
+	/* Scaled displays can be smoothed at 16 and 32 bpp */
+	filter = SDL_getenv("SDL_VIDEO_YUV_FILTER");
+	if ( filter && (SDL_strcasecmp(filter, "bilinear") == 0) ) {
+		swdata->filter = SDL_STRETCH_BILINEAR;
+	}
+
+	/* Split the conversion between threads if asked to */
+	threads = SDL_getenv("SDL_VIDEO_YUV_THREADS");
+	if ( threads && (SDL_atoi(threads) > 1) ) {
+		i = SDL_atoi(threads);
+		if ( i > SDL_YUV_MAXTHREADS ) {
+			i = SDL_YUV_MAXTHREADS;
+		}
+	} else {
+		i = 1;
+	}
+	if ( SDL_CreateYUVBands(swdata, i) < 0 ) {
+		SDL_FreeYUVOverlay(overlay);
+		return(NULL);
+	}
+
 	/* Find the pitch and offset values for the overlay */
 	overlay->pitches = swdata->pitches;
 	overlay->pixels = swdata->planes;
@@ -1167,21 +1458,21 @@ void SDL_UnlockYUV_SW(_THIS, SDL_Overlay *overlay)
 int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 {
 	struct private_yuvhwdata *swdata;
+	SDL_Surface *display;
 	int stretch;
 	int scale_2x;
-	SDL_Surface *display;
-	Uint8 *lum, *Cr, *Cb;
-	Uint8 *dstp;
-	int mod;
+	int rows;
+	int i;
+	int retval;
 
 	swdata = overlay->hwdata;
+	display = swdata->display;
 	stretch = 0;
 	scale_2x = 0;
 	if ( src->x || src->y || src->w < overlay->w || src->h < overlay->h ) {
 		/* The source rectangle has been clipped.
-		   Using a scratch surface is easier than adding clipped
-		   source support to all the blitters, plus that would
-		   slow them down in the general unclipped case.
+		   Rather than adding clipped source support to all the
+		   blitters, the stretch code pulls in the rows it needs.
 		*/
 		stretch = 1;
 	} else if ( (src->w != dst->w) || (src->h != dst->h) ) {
@@ -1193,86 +1484,110 @@ int SDL_DisplayYUV_SW(_THIS, SDL_Overlay *overlay, SDL_Rect *src, SDL_Rect *dst)
 		}
 	}
 	if ( stretch ) {
-		if ( ! swdata->stretch ) {
-			display = swdata->display;
-			swdata->stretch = SDL_CreateRGBSurface(
-				SDL_SWSURFACE,
-				overlay->w, overlay->h,
-				display->format->BitsPerPixel,
-				display->format->Rmask,
-				display->format->Gmask,
-				display->format->Bmask, 0);
-			if ( ! swdata->stretch ) {
+		if ( (src->x < 0) || (src->y < 0) ||
+		     ((src->x+src->w) > overlay->w) ||
+		     ((src->y+src->h) > overlay->h) ||
+		     (dst->x < 0) || (dst->y < 0) ||
+		     ((dst->x+dst->w) > display->w) ||
+		     ((dst->y+dst->h) > display->h) ) {
+			SDL_SetError("Invalid YUV display rectangle");
+			return(-1);
+		}
+		/* Each band converts rows through a buffer of two overlay rows */
+		if ( ! swdata->rowbuf ) {
+			swdata->rowbuf = (Uint8 *)SDL_malloc(swdata->nbands *
+			                         2 * overlay->w *
+			                         display->format->BytesPerPixel);
+			if ( ! swdata->rowbuf ) {
+				SDL_OutOfMemory();
 				return(-1);
 			}
 		}
-		display = swdata->stretch;
-	} else {
-		display = swdata->display;
 	}
 	switch (overlay->format) {
 	    case SDL_YV12_OVERLAY:
-		lum = overlay->pixels[0];
-		Cr =  overlay->pixels[1];
-		Cb =  overlay->pixels[2];
+		swdata->lum = overlay->pixels[0];
+		swdata->Cr =  overlay->pixels[1];
+		swdata->Cb =  overlay->pixels[2];
 		break;
 	    case SDL_IYUV_OVERLAY:
-		lum = overlay->pixels[0];
-		Cr =  overlay->pixels[2];
-		Cb =  overlay->pixels[1];
+		swdata->lum = overlay->pixels[0];
+		swdata->Cr =  overlay->pixels[2];
+		swdata->Cb =  overlay->pixels[1];
 		break;
 	    case SDL_YUY2_OVERLAY:
-		lum = overlay->pixels[0];
-		Cr = lum + 3;
-		Cb = lum + 1;
+		swdata->lum = overlay->pixels[0];
+		swdata->Cr = swdata->lum + 3;
+		swdata->Cb = swdata->lum + 1;
 		break;
 	    case SDL_UYVY_OVERLAY:
-		lum = overlay->pixels[0]+1;
-		Cr = lum + 1;
-		Cb = lum - 1;
+		swdata->lum = overlay->pixels[0]+1;
+		swdata->Cr = swdata->lum + 1;
+		swdata->Cb = swdata->lum - 1;
 		break;
 	    case SDL_YVYU_OVERLAY:
-		lum = overlay->pixels[0];
-		Cr = lum + 1;
-		Cb = lum + 3;
+		swdata->lum = overlay->pixels[0];
+		swdata->Cr = swdata->lum + 1;
+		swdata->Cb = swdata->lum + 3;
 		break;
 	    default:
 		SDL_SetError("Unsupported YUV format in blit");
 		return(-1);
 	}
+	swdata->overlay = overlay;
+	swdata->src = src;
+	swdata->dst = dst;
+	swdata->stretch = stretch;
+	swdata->scale_2x = scale_2x;
+
+	/* Stretches are split by destination row, the rest by overlay row
+	   pairs so the bands of planar formats don't share chroma.
+	 */
+	rows = stretch ? dst->h : overlay->h;
+	for ( i = 0; i < swdata->nbands; ++i ) {
+		SDL_YUVBand *band = &swdata->bands[i];
+		int last = (i + 1 == swdata->nbands) ? rows :
+		           ((i + 1) * rows) / swdata->nbands;
+
+		band->first = (i * rows) / swdata->nbands;
+		if ( ! stretch ) {
+			band->first &= ~1;
+			if ( i + 1 < swdata->nbands ) {
+				last &= ~1;
+			}
+		}
+		band->count = last - band->first;
+		if ( swdata->rowbuf ) {
+			band->rowbuf = swdata->rowbuf + i * 2 * overlay->w *
+			               display->format->BytesPerPixel;
+		}
+		band->retval = 0;
+	}
+
 	if ( SDL_MUSTLOCK(display) ) {
         	if ( SDL_LockSurface(display) < 0 ) {
 			return(-1);
 		}
 	}
-	if ( stretch ) {
-		dstp = (Uint8 *)swdata->stretch->pixels;
-	} else {
-		dstp = (Uint8 *)display->pixels
-			+ dst->x * display->format->BytesPerPixel
-			+ dst->y * display->pitch;
+	for ( i = 1; i < swdata->nbands; ++i ) {
+		SDL_SemPost(swdata->bands[i].start);
 	}
-	mod = (display->pitch / display->format->BytesPerPixel);
-
-	if ( scale_2x ) {
-		mod -= (overlay->w * 2);
-		swdata->Display2X(swdata->colortab, swdata->rgb_2_pix,
-		                  lum, Cr, Cb, dstp, overlay->h, overlay->w, mod);
-	} else {
-		mod -= overlay->w;
-		swdata->Display1X(swdata->colortab, swdata->rgb_2_pix,
-		                  lum, Cr, Cb, dstp, overlay->h, overlay->w, mod);
+	retval = DisplayYUVBand(&swdata->bands[0]);
+	for ( i = 1; i < swdata->nbands; ++i ) {
+		SDL_SemWait(swdata->done);
+	}
+	for ( i = 1; i < swdata->nbands; ++i ) {
+		if ( swdata->bands[i].retval < 0 ) {
+			retval = -1;
+		}
 	}
 	if ( SDL_MUSTLOCK(display) ) {
 		SDL_UnlockSurface(display);
 	}
-	if ( stretch ) {
-		display = swdata->display;
-		SDL_SoftStretch(swdata->stretch, src, display, dst);
+	if ( retval == 0 ) {
+		SDL_UpdateRects(display, 1, dst);
 	}
-	SDL_UpdateRects(display, 1, dst);
-
-	return(0);
+	return(retval);
 }
 
 void SDL_FreeYUV_SW(_THIS, SDL_Overlay *overlay)
@@ -1281,8 +1596,9 @@ void SDL_FreeYUV_SW(_THIS, SDL_Overlay *overlay)
 
 	swdata = overlay->hwdata;
 	if ( swdata ) {
-		if ( swdata->stretch ) {
-			SDL_FreeSurface(swdata->stretch);
+		SDL_FreeYUVBands(swdata);
+		if ( swdata->rowbuf ) {
+			SDL_free(swdata->rowbuf);
 		}
 		if ( swdata->pixels ) {
 			SDL_free(swdata->pixels);
@@ -599,6 +599,31 @@ if (primaryJoystick != NULL) {
 }
 }
 
+void
+PLAYBOOK_WaitEvents(_THIS, Uint32 timeout)
+{
+	if (_priv->waitedEvent)
+		return;
+
+	/* The event stays valid until the next bps_get_event() on this
+	   thread, which is the one PLAYBOOK_PumpEvents() makes next.
+	 */
+	bps_get_event(&_priv->waitedEvent,
+	              (timeout == SDL_MUTEX_MAXWAIT) ? -1 : (int)timeout);
+}
+
+void
+PLAYBOOK_WakeEvents(_THIS)
+{
+	bps_event_t *event = NULL;
+
+	/* PLAYBOOK_PumpEvents() ignores the event; it only ends the wait */
+	if (bps_event_create(&event, _priv->wakeDomain, 0, NULL, NULL) != BPS_SUCCESS)
+		return;
+	if (bps_channel_push_event(_priv->eventChannel, event) != BPS_SUCCESS)
+		bps_event_destroy(event);
+}
+
 void
 PLAYBOOK_PumpEvents(_THIS)
 {
@@ -607,8 +632,11 @@ PLAYBOOK_PumpEvents(_THIS)
 		navkey.sym = 0;
 	}
 
-	bps_event_t *global_bps_event = NULL;
-    bps_get_event(&global_bps_event, 0);
+	/* Start with the event that woke PLAYBOOK_WaitEvents(), if any */
+	bps_event_t *global_bps_event = _priv->waitedEvent;
+	_priv->waitedEvent = NULL;
+	if (!global_bps_event)
+		bps_get_event(&global_bps_event, 0);
 
     while (global_bps_event) {
 		int domain = bps_event_get_domain(global_bps_event);
@@ -32,6 +32,8 @@
 */
 extern void PLAYBOOK_InitOSKeymap(_THIS);
 extern void PLAYBOOK_PumpEvents(_THIS);
+extern void PLAYBOOK_WaitEvents(_THIS, Uint32 timeout);
+extern void PLAYBOOK_WakeEvents(_THIS);
 
 extern int joystickReset;
 extern SDL_Joystick *primaryJoystick;
@@ -152,6 +152,8 @@ static SDL_VideoDevice *PLAYBOOK_CreateDevice(int devindex)
 	device->GetWMInfo = PLAYBOOK_GetWMInfo;
 	device->InitOSKeymap = PLAYBOOK_InitOSKeymap;
 	device->PumpEvents = PLAYBOOK_PumpEvents;
+	device->WaitEvents = PLAYBOOK_WaitEvents;
+	device->WakeEvents = PLAYBOOK_WakeEvents;
 
 	device->free = PLAYBOOK_DeleteDevice;
 
@@ -196,6 +198,17 @@ int PLAYBOOK_VideoInit(_THIS, SDL_PixelFormat *vformat)
 		return -1;
 	}
 
+    /* Other threads wake SDL_WaitEvent() by pushing an event of our own
+       domain onto this thread's channel.  Without one, it polls instead.
+     */
+    _priv->wakeDomain = bps_register_domain();
+    _priv->eventChannel = bps_channel_get_active();
+    _priv->waitedEvent = NULL;
+    if (_priv->wakeDomain == BPS_FAILURE || _priv->eventChannel == BPS_FAILURE) {
+        this->WaitEvents = NULL;
+        this->WakeEvents = NULL;
+    }
+
     paymentservice_request_events(0);
 #ifdef PAYMENT_LOCAL
     paymentservice_set_connection_mode(true);
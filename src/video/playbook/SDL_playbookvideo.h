@@ -54,6 +54,11 @@ struct SDL_PrivateVideoData {
     int pitch;
     int screenResolution[2];
 
+    /* For blocking in WaitEvents() and waking from other threads */
+    int wakeDomain;
+    int eventChannel;
+    bps_event_t *waitedEvent;
+
     SDL_Rect *SDL_modelist[SDL_NUMMODES+1];
 
 #if SDL_VIDEO_OPENGL